@@ -11,8 +11,9 @@
 #include <glm/gtx/string_cast.hpp>
 #include <glad/glad.h>
 #include "Animation.h"
-#include "Model.h"
+#include "model.h"
 #include "shader.h"
+#include "CpuProfiler.h"
 
 class Animator {
 private:
@@ -21,6 +22,7 @@ private:
     float currentTime = 0.0f;
     bool isPlaying = false;
     Model* model = nullptr;
+    std::vector<glm::mat4> finalBoneMatrices; // һμĹ󣬹ͨ
 
 public:
     // ĬϹ캯
@@ -50,6 +52,7 @@ public:
     }
 
     void update(float deltaTime, GLuint shaderProgramID) {
+        CPU_PROFILE_SCOPE("Animator::update");
         if (!model) return;
 
         // 
@@ -57,8 +60,8 @@ public:
 
         // ûлʼйΪλϴ
         if (!isPlaying || !currentAnimation) {
-            std::vector<glm::mat4> identityMatrices(boneCount, glm::mat4(1.0f));
-            uploadBoneMatrices(shaderProgramID, identityMatrices);
+            finalBoneMatrices.assign(boneCount, glm::mat4(1.0f));
+            uploadBoneMatrices(shaderProgramID, finalBoneMatrices);
             return;
         }
 
@@ -78,7 +81,7 @@ public:
         }
 
         // ¹ձ任
-        std::vector<glm::mat4> finalBoneMatrices(boneCount, glm::mat4(1.0f));
+        finalBoneMatrices.assign(boneCount, glm::mat4(1.0f));
         for (const auto& [boneName, boneIdx] : model->boneMapping) {
             finalBoneMatrices[boneIdx] = model->boneInfoMap[boneName].finalTransform;
         }
@@ -125,13 +128,20 @@ public:
     }
 
     void uploadBoneMatrices(GLuint shaderProgramID, const std::vector<glm::mat4>& matrices) {
-        glUseProgram(shaderProgramID);
+        GL_STATE.useProgram(shaderProgramID);
+        RENDER_STATS_PROGRAM();
         GLint boneLoc = glGetUniformLocation(shaderProgramID, "bones");
         if (boneLoc != -1) {
             glUniformMatrix4fv(boneLoc, static_cast<GLsizei>(matrices.size()), GL_FALSE, glm::value_ptr(matrices[0]));
+            RENDER_STATS_UNIFORM();
         }
     }
 
+    // ȡһμĹδ¹ʱΪգ
+    const std::vector<glm::mat4>& getFinalBoneMatrices() const {
+        return finalBoneMatrices;
+    }
+
     const Animation* getCurrentAnimation() const {
         return currentAnimation;
     }
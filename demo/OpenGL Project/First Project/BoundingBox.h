@@ -58,6 +58,17 @@ public:
         min = glm::min(min, other.min);
         max = glm::max(max, other.max);
     }
+
+    // 任ΧУתԭΧУ
+    BoundingBox transformed(const glm::mat4& matrix) const {
+        glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+        glm::vec3 extent = glm::mat3(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])))
+            * (getSize() * 0.5f);
+        BoundingBox result;
+        result.min = center - extent;
+        result.max = center + extent;
+        return result;
+    }
 };
 
 #endif // BOUNDINGBOX_H
@@ -0,0 +1,120 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 关键帧相机路径，用于基准测试的固定飞行路线
+// - 文件格式：{"keyframes":[{"time":0.0,"position":[x,y,z],"yaw":-90.0,"pitch":0.0}, ...]}，time 以秒为单位且递增
+// - 关键帧之间用 Catmull-Rom 样条插值，首尾关键帧重复作为端点；时间超出范围时停在首尾关键帧
+// - yaw / pitch 按角度直接插值，跨越 ±180 度时应在文件中写成连续的角度（例如 170 -> 190）
+class CameraPath {
+public:
+    struct Keyframe {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    struct Pose {
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    bool loadFromFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open camera path: " << path << std::endl;
+            return false;
+        }
+
+        nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+        if (json.is_discarded() || !json.contains("keyframes") || !json["keyframes"].is_array()) {
+            std::cerr << "Invalid camera path (expected a \"keyframes\" array): " << path << std::endl;
+            return false;
+        }
+
+        std::vector<Keyframe> loaded;
+        for (const auto& item : json["keyframes"]) {
+            const auto& position = item.value("position", nlohmann::json::array({ 0.0f, 0.0f, 0.0f }));
+            if (!position.is_array() || position.size() != 3) {
+                std::cerr << "Camera path keyframe needs a 3-component position: " << path << std::endl;
+                return false;
+            }
+            Keyframe keyframe;
+            keyframe.time = item.value("time", 0.0f);
+            keyframe.position = glm::vec3(position[0].get<float>(), position[1].get<float>(), position[2].get<float>());
+            keyframe.yaw = item.value("yaw", -90.0f);
+            keyframe.pitch = item.value("pitch", 0.0f);
+            loaded.push_back(keyframe);
+        }
+        if (loaded.empty()) {
+            std::cerr << "Camera path has no keyframes: " << path << std::endl;
+            return false;
+        }
+        std::stable_sort(loaded.begin(), loaded.end(),
+            [](const Keyframe& a, const Keyframe& b) { return a.time < b.time; });
+
+        keyframes = std::move(loaded);
+        return true;
+    }
+
+    bool empty() const { return keyframes.empty(); }
+    float getDuration() const { return keyframes.empty() ? 0.0f : keyframes.back().time - keyframes.front().time; }
+
+    // time 为相对第一个关键帧的秒数
+    Pose evaluate(float time) const {
+        if (keyframes.empty()) {
+            return { glm::vec3(0.0f), -90.0f, 0.0f };
+        }
+        float t = keyframes.front().time + time;
+        if (keyframes.size() == 1 || t <= keyframes.front().time) {
+            return poseOf(keyframes.front());
+        }
+        if (t >= keyframes.back().time) {
+            return poseOf(keyframes.back());
+        }
+
+        size_t segment = 0;
+        while (segment + 2 < keyframes.size() && t >= keyframes[segment + 1].time) {
+            ++segment;
+        }
+        const Keyframe& k1 = keyframes[segment];
+        const Keyframe& k2 = keyframes[segment + 1];
+        const Keyframe& k0 = keyframes[segment > 0 ? segment - 1 : segment];
+        const Keyframe& k3 = keyframes[std::min(segment + 2, keyframes.size() - 1)];
+
+        float span = k2.time - k1.time;
+        float u = span > 0.0f ? (t - k1.time) / span : 1.0f;
+        return {
+            catmullRom(k0.position, k1.position, k2.position, k3.position, u),
+            catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, u),
+            glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, u), -89.0f, 89.0f)
+        };
+    }
+
+private:
+    std::vector<Keyframe> keyframes;
+
+    static Pose poseOf(const Keyframe& keyframe) {
+        return { keyframe.position, keyframe.yaw, keyframe.pitch };
+    }
+
+    // 均匀 Catmull-Rom：经过 p1 和 p2，切线由相邻关键帧决定
+    template <typename T>
+    static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float u) {
+        float u2 = u * u;
+        float u3 = u2 * u;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2
+            + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+    }
+};
+
+#endif // CAMERA_PATH_H
@@ -1,15 +1,29 @@
 #include "CaptureManager.h"
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <iostream>
 #include <cstdio>
 #include <cstring>
+#include <cerrno>
 #include <stdexcept>
+#include <system_error>
 
 // ʹ stb_image_write
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+namespace {
+
+// Windows ĹܵҪöģʽзᱻתPOSIX  popen  "b"
+#ifdef _WIN32
+FILE* openPipe(const char* command) { return _popen(command, "wb"); }
+void closePipe(FILE* pipe) { _pclose(pipe); }
+#else
+FILE* openPipe(const char* command) { return popen(command, "w"); }
+void closePipe(FILE* pipe) { pclose(pipe); }
+#endif
+
+} // namespace
+
 CaptureManager::CaptureManager(unsigned int width, unsigned int height)
     : SCR_WIDTH(width), SCR_HEIGHT(height), recording(false), ffmpegPipe(nullptr)
 {
@@ -116,10 +130,9 @@ bool CaptureManager::initFfmpegPipe(const std::string& videoPath, int fps) {
         "-pix_fmt rgba -s " + std::to_string(SCR_WIDTH) + "x" + std::to_string(SCR_HEIGHT) +
         " -r " + std::to_string(fps) + " -i - -c:v libx264 -preset ultrafast -crf 23 -pix_fmt yuv420p " + videoPath;
 
-    ffmpegPipe = _popen(command.c_str(), "wb"); // ʹöģʽ
-    char errorBuffer[256]; // 建
+    ffmpegPipe = openPipe(command.c_str());
     if (!ffmpegPipe) {
-        std::cerr << "[CaptureManager] Failed to open ffmpeg pipe: " << strerror_s(errorBuffer, sizeof(errorBuffer), errno) << std::endl;
+        std::cerr << "[CaptureManager] Failed to open ffmpeg pipe: " << std::generic_category().message(errno) << std::endl;
         return false;
     }
     return true;
@@ -128,7 +141,7 @@ bool CaptureManager::initFfmpegPipe(const std::string& videoPath, int fps) {
 void CaptureManager::closeFfmpegPipe() {
     if (ffmpegPipe) {
         fflush(ffmpegPipe);  // ȷедļ
-        _pclose(ffmpegPipe);
+        closePipe(ffmpegPipe);
         ffmpegPipe = nullptr;
     }
 }
@@ -0,0 +1,183 @@
+#include "CpuProfiler.h"
+#include "TraceJson.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+CpuProfiler& CpuProfiler::instance() {
+    static CpuProfiler profiler;
+    return profiler;
+}
+
+CpuProfiler::CpuProfiler() : origin(std::chrono::steady_clock::now()) {
+}
+
+int64_t CpuProfiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+CpuProfiler::ThreadHandle::~ThreadHandle() {
+    if (buffer) {
+        CpuProfiler::instance().releaseBuffer(buffer);
+    }
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::threadBuffer() {
+    thread_local ThreadHandle handle;
+    if (handle.buffer) {
+        return *handle.buffer;
+    }
+
+    // 优先复用已结束线程的缓冲，旧的区间保留在同一线程号下
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto& buffer : buffers) {
+        if (!buffer->inUse) {
+            handle.buffer = buffer.get();
+            break;
+        }
+    }
+    if (!handle.buffer) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events = std::make_unique<Event[]>(BUFFER_EVENTS);
+        buffer->name = buffers.empty() ? "Main Thread" : "Worker " + std::to_string(buffers.size());
+        handle.buffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+    handle.buffer->inUse = true;
+    handle.buffer->depth = 0;
+    return *handle.buffer;
+}
+
+void CpuProfiler::releaseBuffer(ThreadBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->inUse = false;
+}
+
+void CpuProfiler::beginZone(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    // 超出深度的区间不记录，但仍然计数以保持配对
+    if (buffer.depth < MAX_DEPTH) {
+        buffer.stack[buffer.depth] = { name, isEnabled() ? now() : -1 };
+    }
+    ++buffer.depth;
+}
+
+void CpuProfiler::endZone() {
+    ThreadBuffer& buffer = threadBuffer();
+    if (buffer.depth == 0) {
+        return;
+    }
+    --buffer.depth;
+    if (buffer.depth >= MAX_DEPTH) {
+        return;
+    }
+    const OpenZone& zone = buffer.stack[buffer.depth];
+    if (zone.startNs < 0 || !isEnabled()) {
+        return;
+    }
+
+    // 只有本线程写入；写完事件后再发布计数，导出时读到的计数之前的事件都是完整的
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index % BUFFER_EVENTS] = { zone.name, zone.startNs, now() };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer.name = name;
+}
+
+void CpuProfiler::recordFrameTime(float frameMs) {
+    frameTimes[frameTimeHead] = frameMs;
+    frameTimeHead = (frameTimeHead + 1) % FRAME_HISTORY;
+    frameTimeCount = std::min(frameTimeCount + 1, FRAME_HISTORY);
+}
+
+std::vector<float> CpuProfiler::buildFrameTimeHistogram(int bucketCount, float maxMs) const {
+    std::vector<float> buckets(std::max(bucketCount, 1), 0.0f);
+    if (maxMs <= 0.0f) {
+        return buckets;
+    }
+    for (int i = 0; i < frameTimeCount; ++i) {
+        int bucket = static_cast<int>(frameTimes[i] / maxMs * buckets.size());
+        buckets[std::min(std::max(bucket, 0), static_cast<int>(buckets.size()) - 1)] += 1.0f;
+    }
+    return buckets;
+}
+
+float CpuProfiler::getFrameTimePercentile(float percentile) const {
+    if (frameTimeCount == 0) {
+        return 0.0f;
+    }
+    std::vector<float> sorted(frameTimes, frameTimes + frameTimeCount);
+    size_t index = static_cast<size_t>(std::min(std::max(percentile, 0.0f), 1.0f) * (sorted.size() - 1) + 0.5f);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+size_t CpuProfiler::getThreadCount() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    return buffers.size();
+}
+
+std::vector<CpuProfiler::ZoneSummary> CpuProfiler::summarizeZones(int64_t sinceNs) {
+    std::vector<ZoneSummary> summaries;
+    std::map<std::string, size_t> index;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto& buffer : buffers) {
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = written > BUFFER_EVENTS ? written - BUFFER_EVENTS : 0;
+        for (uint64_t i = begin; i < written; ++i) {
+            const Event& event = buffer->events[i % BUFFER_EVENTS];
+            if (event.startNs < sinceNs) {
+                continue;
+            }
+            auto it = index.find(event.name);
+            if (it == index.end()) {
+                it = index.emplace(event.name, summaries.size()).first;
+                summaries.push_back({ event.name, 0, 0.0 });
+            }
+            ZoneSummary& summary = summaries[it->second];
+            ++summary.count;
+            summary.totalMs += static_cast<double>(event.endNs - event.startNs) / 1.0e6;
+        }
+    }
+    return summaries;
+}
+
+bool CpuProfiler::exportTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open CPU trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    size_t eventCount = 0;
+    bool first = true;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t tid = 0; tid < buffers.size(); ++tid) {
+        const ThreadBuffer& buffer = *buffers[tid];
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << escapeJson(buffer.name) << "\"}}";
+        first = false;
+
+        // 环形缓冲中最旧的事件在写入位置处
+        uint64_t written = buffer.written.load(std::memory_order_acquire);
+        uint64_t begin = written > BUFFER_EVENTS ? written - BUFFER_EVENTS : 0;
+        for (uint64_t i = begin; i < written; ++i) {
+            const Event& event = buffer.events[i % BUFFER_EVENTS];
+            file << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << static_cast<double>(event.startNs) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.endNs - event.startNs) / 1000.0 << "}";
+            ++eventCount;
+        }
+    }
+    file << "\n]}\n";
+    std::cout << "CPU trace saved to " << path << " (" << eventCount << " events, "
+        << buffers.size() << " threads)" << std::endl;
+    return true;
+}
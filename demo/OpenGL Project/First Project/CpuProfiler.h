@@ -0,0 +1,138 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// CPU 分区计时
+// - 每个线程写自己的环形缓冲，记录 (名字, 开始, 结束)，写入时不加锁；名字必须是字符串字面量等静态字符串
+// - 线程第一次记录时从池中取一个缓冲，线程结束时归还（光源分簇等每帧创建的工作线程会复用缓冲），
+//   缓冲下标作为 trace 中的线程号
+// - 导出为 Chrome trace（chrome://tracing 或 Perfetto 打开），每个缓冲保留最近 BUFFER_EVENTS 个区间
+// - 定义 DISABLE_CPU_PROFILER 时下面的宏展开为空，计时代码不参与编译
+class CpuProfiler {
+public:
+    static constexpr size_t BUFFER_EVENTS = 1 << 14;
+    static constexpr int MAX_DEPTH = 64;
+    static constexpr int FRAME_HISTORY = 240;
+
+    struct Event {
+        const char* name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+    // 按名字汇总的区间，所有线程合计
+    struct ZoneSummary {
+        std::string name;
+        size_t count;
+        double totalMs;
+    };
+
+    static CpuProfiler& instance();
+
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    // 运行时开关：关闭后区间不再写入缓冲
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // 当前线程的区间开始 / 结束，必须成对调用
+    void beginZone(const char* name);
+    void endZone();
+
+    // trace 中当前线程的名字
+    void setThreadName(const std::string& name);
+
+    // 每帧记录一次帧间隔，用于界面中的直方图
+    void recordFrameTime(float frameMs);
+    const float* getFrameTimes() const { return frameTimes; }
+    int getFrameTimeCount() const { return frameTimeCount; }
+    int getFrameTimeOffset() const { return frameTimeHead; }
+
+    // 把最近帧的帧间隔按 [0, maxMs) 等分为 bucketCount 档统计，超出的计入最后一档
+    std::vector<float> buildFrameTimeHistogram(int bucketCount, float maxMs) const;
+    // 最近帧的帧间隔百分位（0~1）
+    float getFrameTimePercentile(float percentile) const;
+
+    // 区间使用的时钟（纳秒，从单例创建时开始）
+    int64_t now() const;
+
+    // 汇总开始时间不早于 sinceNs 的区间，按首次出现的顺序；与导出一样应在帧边界调用，
+    // 且两次调用之间的区间数不应超过 BUFFER_EVENTS
+    std::vector<ZoneSummary> summarizeZones(int64_t sinceNs);
+
+    // 写出所有线程缓冲中的区间；应在主线程的帧边界调用，此时工作线程没有在写入
+    bool exportTrace(const std::string& path);
+
+    size_t getThreadCount();
+
+private:
+    CpuProfiler();
+
+    // 未结束的区间；关闭计时时也入栈（start 为 -1），保证开关切换时开始和结束仍然配对
+    struct OpenZone {
+        const char* name;
+        int64_t startNs;
+    };
+
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> written{ 0 };
+        OpenZone stack[MAX_DEPTH];
+        int depth = 0;
+        std::string name;
+        bool inUse = false;
+    };
+
+    // 线程结束时把缓冲还给池
+    struct ThreadHandle {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadHandle();
+    };
+
+    std::atomic<bool> enabled{ true };
+    std::chrono::steady_clock::time_point origin;
+
+    std::mutex buffersMutex;            // 只在线程取得 / 归还缓冲和导出时使用
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    float frameTimes[FRAME_HISTORY] = {};
+    int frameTimeHead = 0;
+    int frameTimeCount = 0;
+
+    ThreadBuffer& threadBuffer();
+    void releaseBuffer(ThreadBuffer* buffer);
+};
+
+// 作用域内的 CPU 计时
+class CpuProfileScope {
+public:
+    explicit CpuProfileScope(const char* name) { CpuProfiler::instance().beginZone(name); }
+    ~CpuProfileScope() { CpuProfiler::instance().endZone(); }
+
+    CpuProfileScope(const CpuProfileScope&) = delete;
+    CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+};
+
+#ifndef DISABLE_CPU_PROFILER
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+#define CPU_PROFILE_SCOPE(name) CpuProfileScope CPU_PROFILE_CONCAT(cpuProfileScope, __LINE__)(name)
+#define CPU_PROFILE_BEGIN(name) CpuProfiler::instance().beginZone(name)
+#define CPU_PROFILE_END() CpuProfiler::instance().endZone()
+#define CPU_PROFILE_THREAD(name) CpuProfiler::instance().setThreadName(name)
+#else
+#define CPU_PROFILE_SCOPE(name) ((void)0)
+#define CPU_PROFILE_BEGIN(name) ((void)0)
+#define CPU_PROFILE_END() ((void)0)
+#define CPU_PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif // CPU_PROFILER_H
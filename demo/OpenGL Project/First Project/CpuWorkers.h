@@ -0,0 +1,49 @@
+// CpuWorkers.h
+#ifndef CPU_WORKERS_H
+#define CPU_WORKERS_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// 光源分簇、软件遮挡剔除等 CPU 并行模块共用的工具
+// 编译目标支持 SSE2 时定义 ENGINE_SSE 并引入 SSE 头文件，否则各模块使用标量实现
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// 默认工作线程数：留一个核心给渲染线程，最多 4 个
+inline int defaultCpuWorkerCount()
+{
+    unsigned int hw = std::thread::hardware_concurrency();
+    return hw > 1 ? static_cast<int>(std::min(hw - 1, 4u)) : 1;
+}
+
+// 把 [0, count) 均分成 workers 段，第 0 段在调用线程中执行，其余各开一个线程，返回前全部完成
+// work(worker, begin, end) 处理第 worker 段，各段之间不能有写冲突
+template <typename Work>
+void runOnWorkers(int workers, int count, const Work& work)
+{
+    if (workers <= 1)
+    {
+        work(0, 0, count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (int w = 1; w < workers; ++w)
+    {
+        int begin = count * w / workers;
+        int end = count * (w + 1) / workers;
+        threads.emplace_back([&work, w, begin, end]() {
+            work(w, begin, end);
+        });
+    }
+    work(0, 0, count / workers);
+    for (auto& t : threads)
+        t.join();
+}
+
+#endif // CPU_WORKERS_H
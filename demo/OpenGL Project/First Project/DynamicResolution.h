@@ -0,0 +1,50 @@
+// DynamicResolution.h
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+
+// 动态分辨率控制器
+// 每帧用上一帧可用的 GPU 耗时与预算比较，调整渲染分辨率的缩放（每个方向）
+// - 着色开销近似与像素数即缩放的平方成正比，目标缩放按 sqrt(预算 / 耗时) 估计
+// - 超出预算时快速降低，低于预算时缓慢回升；误差在死区内不调整，输出按 1/32 量化，避免每帧抖动
+class DynamicResolution
+{
+public:
+    bool enabled = false;
+    float targetMs = 16.6f;     // GPU 帧时间预算
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+
+    // 输入最近一次测得的 GPU 帧时间，返回本帧使用的缩放
+    float update(double gpuMs)
+    {
+        if (!enabled)
+        {
+            scale = maxScale;
+            return getScale();
+        }
+        if (gpuMs <= 0.0)
+            return getScale();
+
+        double ratio = targetMs / gpuMs;
+        if (ratio > 0.95 && ratio < 1.05)
+            return getScale();
+
+        float desired = std::clamp(scale * static_cast<float>(std::sqrt(ratio)), minScale, maxScale);
+        float rate = desired < scale ? 0.5f : 0.1f;
+        scale = std::clamp(scale + (desired - scale) * rate, minScale, maxScale);
+        return getScale();
+    }
+
+    float getScale() const
+    {
+        return std::clamp(std::round(scale * 32.0f) / 32.0f, minScale, maxScale);
+    }
+
+private:
+    float scale = 1.0f;         // 未量化的缩放
+};
+
+#endif // DYNAMIC_RESOLUTION_H
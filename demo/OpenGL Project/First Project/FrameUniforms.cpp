@@ -0,0 +1,121 @@
+#include "FrameUniforms.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cstring>
+
+FrameUniforms& FrameUniforms::instance() {
+    static FrameUniforms uniforms;
+    return uniforms;
+}
+
+FrameUniforms::FrameUniforms() {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+    objectStride = (sizeof(ObjectData) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &frameBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+
+    ringCapacity = INITIAL_RING_SIZE;
+    glGenBuffers(1, &objectBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, ringCapacity, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &materialBuffer);
+}
+
+void FrameUniforms::updateFrame(const FrameData& frame) {
+    // 先重新指定存储，上一帧仍在使用的旧数据由驱动保留
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+    RENDER_STATS_UPLOAD(sizeof(FrameData));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, frameBuffer);
+
+    objectsWritten = 0;
+    objectBytes = 0;
+    materialsWritten = 0;
+}
+
+size_t FrameUniforms::writeObjects(const ObjectData* objects, size_t count) {
+    size_t size = count * objectStride;
+    if (size == 0) {
+        return ringHead;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+    if (size > ringCapacity) {
+        ringCapacity = std::max(size, ringCapacity * 2);
+        glBufferData(GL_UNIFORM_BUFFER, ringCapacity, nullptr, GL_STREAM_DRAW);
+        ringHead = 0;
+    }
+    else if (ringHead + size > ringCapacity) {
+        // 回绕：重新指定存储，仍在使用旧区域的绘制不受影响，也不需要等待
+        glBufferData(GL_UNIFORM_BUFFER, ringCapacity, nullptr, GL_STREAM_DRAW);
+        ringHead = 0;
+        ++ringWraps;
+    }
+
+    staging.assign(size, 0);
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(&staging[i * objectStride], &objects[i], sizeof(ObjectData));
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, ringHead, size, staging.data());
+    RENDER_STATS_UPLOAD(size);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    size_t offset = ringHead;
+    ringHead += size;
+    objectsWritten += count;
+    objectBytes += size;
+    return offset;
+}
+
+void FrameUniforms::bindObject(size_t offset) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, objectBuffer, offset, sizeof(ObjectData));
+}
+
+void FrameUniforms::writeMaterials(const std::vector<MaterialData>& materials) {
+    if (materials.empty()) {
+        return;
+    }
+    size_t size = materials.size() * sizeof(MaterialData);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, materialBuffer);
+    if (size > materialCapacity) {
+        materialCapacity = std::max(size, materialCapacity * 2);
+    }
+    glBufferData(GL_SHADER_STORAGE_BUFFER, materialCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, materials.data());
+    RENDER_STATS_UPLOAD(size);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    bindMaterials();
+    materialsWritten += materials.size();
+}
+
+void FrameUniforms::bindMaterials() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BINDING, materialBuffer);
+}
+
+FrameUniforms::MaterialData FrameUniforms::packMaterial(const PBRMaterial& material) {
+    // 与 Mesh::bindMaterialTextures 的判断一致：打开了开关且有纹理时才使用贴图
+    unsigned int flags = 0;
+    if (material.useAlbedoMap && material.albedoMap != 0) flags |= ALBEDO_MAP;
+    if (material.useMetallicMap && material.metallicMap != 0) flags |= METALLIC_MAP;
+    if (material.useRoughnessMap && material.roughnessMap != 0) flags |= ROUGHNESS_MAP;
+    if (material.useNormalMap && material.normalMap != 0) flags |= NORMAL_MAP;
+    if (material.useAOMap && material.aoMap != 0) flags |= AO_MAP;
+
+    return {
+        glm::vec4(material.albedo, material.metallic),
+        glm::vec4(material.roughness, material.ao, 0.0f, 0.0f),
+        glm::uvec4(flags, 0u, 0u, 0u)
+    };
+}
+
+FrameUniforms::Stats FrameUniforms::getStats() const {
+    return { objectsWritten, objectBytes, materialsWritten, ringCapacity, ringWraps };
+}
@@ -0,0 +1,128 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include "mesh.h" // PBRMaterial 与 Mesh 互相包含，先包含 Mesh.h
+
+// 着色器共用的常量缓冲，代替逐个按名字设置的 uniform
+// - FrameData：每帧一次写入的 UBO（相机、分簇、阴影、调试开关），与 shaders/frame_common.glsl 对应
+// - ObjectData：每次绘制一份的物体常量，写入环形 UBO，绘制时只用 glBindBufferRange 切换偏移
+// - MaterialData：材质常量表（SSBO），物体常量中保存材质下标
+class FrameUniforms {
+public:
+    // 绑定点：UBO 与 SSBO 的绑定点互不影响；GL 4.3 只保证 8 个 SSBO 绑定点（0~7），
+    // 材质表与剔除的输入共用 3 号，剔除后由 GpuCulling 调用 bindMaterials() 恢复
+    static constexpr GLuint FRAME_BINDING = 0;
+    static constexpr GLuint OBJECT_BINDING = 1;
+    static constexpr GLuint MATERIAL_BINDING = 3;
+
+    static constexpr int MAX_SHADOW_SLOTS = 32;
+    static constexpr int MAX_SHADOW_LIGHTS = 16;
+    static constexpr int MAX_DIRECTIONAL_LIGHTS = 4;
+
+    // std140 布局；数组元素按 16 字节对齐，所以 shadowSlots 和 directionalLights 用 ivec4 存放
+    struct FrameData {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::mat4 viewProjection;
+        glm::mat4 invViewProjection;
+        glm::mat4 shadowMatrices[MAX_SHADOW_SLOTS];
+        glm::vec4 shadowRects[MAX_SHADOW_SLOTS];
+        glm::ivec4 shadowSlots[MAX_SHADOW_LIGHTS];             // xy 有效
+        glm::ivec4 directionalLights[MAX_DIRECTIONAL_LIGHTS];  // x 有效
+        glm::vec4 cascadeSplits;
+        glm::vec3 viewPos;
+        float farPlane;
+        glm::uvec3 clusterGrid;
+        float shadowMapResolution;
+        glm::vec2 screenSize;
+        glm::vec2 clusterDepthParams;
+        int directionalLightCount;
+        int shadowQuality;
+        float pcssLightSize;
+        int debugLightView;
+        int debugLightIndex;
+        int debugMaterialView;
+        int debugMaterialIndex;
+        int padding;
+    };
+
+    struct ObjectData {
+        glm::mat4 model;
+        int materialIndex;
+        int useBones;
+        int useInstancing;
+        int padding;
+    };
+
+    // 使用了哪些贴图，与 material_common.glsl 中的常量对应
+    enum TextureFlag : unsigned int {
+        ALBEDO_MAP = 1u << 0,
+        METALLIC_MAP = 1u << 1,
+        ROUGHNESS_MAP = 1u << 2,
+        NORMAL_MAP = 1u << 3,
+        AO_MAP = 1u << 4
+    };
+
+    struct MaterialData {
+        glm::vec4 albedoMetallic;
+        glm::vec4 roughnessAO;     // x: roughness, y: ao
+        glm::uvec4 textureFlags;   // x: TextureFlag 的组合
+    };
+
+    struct Stats {
+        size_t objectsWritten;     // 本帧写入的物体常量
+        size_t objectBytes;        // 本帧写入环形缓冲的字节数
+        size_t materialsWritten;   // 本帧写入的材质
+        size_t ringCapacity;       // 环形缓冲容量（字节）
+        size_t ringWraps;          // 累计回绕次数
+    };
+
+    // 全局实例，首次使用时创建（需要已有 GL 上下文）
+    static FrameUniforms& instance();
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    // 写入本帧常量并绑定到 FRAME_BINDING，同时重置每帧统计
+    void updateFrame(const FrameData& frame);
+
+    // 写入一批物体常量，返回第一份的偏移；第 i 份位于 offset + i * getObjectStride()
+    size_t writeObjects(const ObjectData* objects, size_t count);
+    void bindObject(size_t offset) const;
+    size_t getObjectStride() const { return objectStride; }
+
+    // 写入材质表并绑定到 MATERIAL_BINDING，下标即 ObjectData::materialIndex
+    void writeMaterials(const std::vector<MaterialData>& materials);
+    // 重新绑定材质表（绑定点被计算着色器占用之后）
+    void bindMaterials() const;
+
+    static MaterialData packMaterial(const PBRMaterial& material);
+
+    Stats getStats() const;
+
+private:
+    FrameUniforms();
+
+    static constexpr size_t INITIAL_RING_SIZE = 256 * 1024;
+
+    GLuint frameBuffer = 0;
+    GLuint objectBuffer = 0;
+    GLuint materialBuffer = 0;
+
+    size_t objectStride = 0;       // 按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐
+    size_t ringCapacity = 0;
+    size_t ringHead = 0;
+    size_t materialCapacity = 0;
+    std::vector<unsigned char> staging;
+
+    size_t objectsWritten = 0;
+    size_t objectBytes = 0;
+    size_t materialsWritten = 0;
+    size_t ringWraps = 0;
+};
+
+#endif // FRAME_UNIFORMS_H
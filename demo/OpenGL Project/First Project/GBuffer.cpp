@@ -0,0 +1,104 @@
+#include "GBuffer.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <iostream>
+
+GBuffer::GBuffer(unsigned int width, unsigned int height)
+    : width(width), height(height), fbo(0), albedoAOTex(0), normalMRTex(0), depthTex(0), emptyVAO(0) {
+}
+
+GBuffer::~GBuffer() {
+    releaseAttachments();
+    if (emptyVAO) GL_STATE.deleteVertexArrays(1, &emptyVAO);
+}
+
+bool GBuffer::initialize() {
+    // 全屏三角形不需要顶点数据，但核心模式要求绑定一个 VAO
+    glGenVertexArrays(1, &emptyVAO);
+    return createAttachments();
+}
+
+bool GBuffer::resize(unsigned int newWidth, unsigned int newHeight) {
+    if (newWidth == 0 || newHeight == 0 || (newWidth == width && newHeight == height))
+        return true;
+    width = newWidth;
+    height = newHeight;
+    releaseAttachments();
+    return createAttachments();
+}
+
+bool GBuffer::createAttachments() {
+    glGenFramebuffers(1, &fbo);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    // albedo + ao
+    glGenTextures(1, &albedoAOTex);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, albedoAOTex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoAOTex, 0);
+
+    // 法线 + metallic + roughness
+    glGenTextures(1, &normalMRTex);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, normalMRTex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalMRTex, 0);
+
+    // 深度，格式与后处理 FBO 的渲染缓冲一致，便于直接拷贝
+    glGenTextures(1, &depthTex);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, depthTex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+
+    GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        std::cerr << "G-buffer framebuffer is not complete!" << std::endl;
+    }
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, 0);
+    return complete;
+}
+
+void GBuffer::releaseAttachments() {
+    if (fbo) GL_STATE.deleteFramebuffers(1, &fbo);
+    if (albedoAOTex) GL_STATE.deleteTextures(1, &albedoAOTex);
+    if (normalMRTex) GL_STATE.deleteTextures(1, &normalMRTex);
+    if (depthTex) GL_STATE.deleteTextures(1, &depthTex);
+    fbo = albedoAOTex = normalMRTex = depthTex = 0;
+}
+
+void GBuffer::bindForGeometry(unsigned int viewportWidth, unsigned int viewportHeight) {
+    // 背景由深度 = 1 识别，颜色附件清成什么都可以，沿用当前清屏颜色
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GL_STATE.viewport(0, 0, viewportWidth, viewportHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GBuffer::bindTextures(unsigned int firstUnit) const {
+    GL_STATE.bindTexture(firstUnit, GL_TEXTURE_2D, albedoAOTex);
+    GL_STATE.bindTexture(firstUnit + 1, GL_TEXTURE_2D, normalMRTex);
+    GL_STATE.bindTexture(firstUnit + 2, GL_TEXTURE_2D, depthTex);
+    RENDER_STATS_TEXTURES(3);
+}
+
+void GBuffer::copyDepthTo(unsigned int targetFBO, unsigned int regionWidth, unsigned int regionHeight) const {
+    GL_STATE.bindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    GL_STATE.bindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+    glBlitFramebuffer(0, 0, regionWidth, regionHeight, 0, 0, regionWidth, regionHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+}
+
+void GBuffer::drawFullscreenTriangle() const {
+    GL_STATE.bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RENDER_STATS_DRAW(1);
+    GL_STATE.bindVertexArray(0);
+}
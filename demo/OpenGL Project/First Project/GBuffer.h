@@ -0,0 +1,51 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad/glad.h>
+
+// 延迟着色的 G-buffer
+// RT0: RGBA8   albedo.rgb + ao
+// RT1: RGBA16F 八面体编码法线 (xy) + metallic + roughness
+// 深度: DEPTH24_STENCIL8，光照阶段由深度重建世界坐标
+class GBuffer {
+public:
+    GBuffer(unsigned int width, unsigned int height);
+    ~GBuffer();
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // 初始化资源
+    bool initialize();
+
+    // 窗口尺寸变化时重建附件
+    bool resize(unsigned int width, unsigned int height);
+
+    // 几何阶段：绑定 FBO 并清空；视口为左下角的渲染区域（动态分辨率时小于附件）
+    void bindForGeometry(unsigned int viewportWidth, unsigned int viewportHeight);
+
+    // 光照阶段：把三张纹理绑定到 firstUnit 起的连续纹理单元
+    void bindTextures(unsigned int firstUnit) const;
+
+    // 把左下角区域的深度拷贝到目标帧缓冲的相同区域，供之后的天空盒等前向绘制做深度测试
+    void copyDepthTo(unsigned int targetFBO, unsigned int regionWidth, unsigned int regionHeight) const;
+
+    // 绘制覆盖全屏的三角形（顶点由 gl_VertexID 生成）
+    void drawFullscreenTriangle() const;
+
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+
+private:
+    unsigned int width, height;
+    unsigned int fbo;
+    unsigned int albedoAOTex;
+    unsigned int normalMRTex;
+    unsigned int depthTex;
+    unsigned int emptyVAO;
+
+    bool createAttachments();
+    void releaseAttachments();
+};
+
+#endif
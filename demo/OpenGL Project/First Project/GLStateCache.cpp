@@ -0,0 +1,312 @@
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+GLStateCache& GLStateCache::instance() {
+    static GLStateCache cache;
+    return cache;
+}
+
+GLStateCache::GLStateCache() {
+    invalidate();
+}
+
+void GLStateCache::beginFrame() {
+    lastStats = stats;
+    stats = {};
+}
+
+void GLStateCache::invalidate() {
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (auto& unit : textures) {
+        for (GLuint& texture : unit) {
+            texture = UNKNOWN;
+        }
+    }
+    readFramebuffer = UNKNOWN;
+    drawFramebuffer = UNKNOWN;
+    viewportKnown = false;
+    for (int& capability : capabilities) {
+        capability = -1;
+    }
+    depthFuncValue = 0;
+    depthMaskValue = -1;
+    cullFaceValue = 0;
+    polygonOffsetKnown = false;
+    polygonModeValue = 0;
+}
+
+void GLStateCache::skipped() {
+    ++stats.skipped;
+    if (!debugEnabled) {
+        return;
+    }
+    // 只保留文件名部分
+    const char* name = siteFile;
+    for (const char* p = siteFile; *p; ++p) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    std::string site = std::string(name) + ":" + std::to_string(siteLine);
+    for (auto& entry : redundantSites) {
+        if (entry.first == site) {
+            ++entry.second;
+            return;
+        }
+    }
+    redundantSites.emplace_back(site, 1);
+}
+
+void GLStateCache::useProgram(GLuint value) {
+    if (program == value) {
+        skipped();
+        return;
+    }
+    glUseProgram(value);
+    program = value;
+    issued();
+}
+
+GLuint GLStateCache::getProgram() {
+    // 只有 invalidate 之后还没有设置过时才需要查询
+    if (program == UNKNOWN) {
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        program = static_cast<GLuint>(current);
+    }
+    return program;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+    if (vertexArray == vao) {
+        skipped();
+        return;
+    }
+    glBindVertexArray(vao);
+    vertexArray = vao;
+    issued();
+}
+
+void GLStateCache::setActiveUnit(GLuint unit) {
+    if (activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+        issued();
+    }
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    int index = textureTargetIndex(target);
+    if (unit >= MAX_TEXTURE_UNITS || index < 0) {
+        setActiveUnit(unit);
+        glBindTexture(target, texture);
+        issued();
+        return;
+    }
+    // 跳过绑定时仍然切换活动单元，保证之后修改纹理参数的调用作用于这个纹理
+    setActiveUnit(unit);
+    if (textures[unit][index] == texture) {
+        skipped();
+        return;
+    }
+    glBindTexture(target, texture);
+    textures[unit][index] = texture;
+    issued();
+}
+
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    if ((!read || readFramebuffer == framebuffer) && (!draw || drawFramebuffer == framebuffer)) {
+        skipped();
+        return;
+    }
+    glBindFramebuffer(target, framebuffer);
+    if (read) readFramebuffer = framebuffer;
+    if (draw) drawFramebuffer = framebuffer;
+    issued();
+}
+
+GLuint GLStateCache::getDrawFramebuffer() {
+    if (drawFramebuffer == UNKNOWN) {
+        GLint current = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &current);
+        drawFramebuffer = static_cast<GLuint>(current);
+    }
+    return drawFramebuffer;
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (viewportKnown && viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width &&
+        viewportRect[3] == height) {
+        skipped();
+        return;
+    }
+    glViewport(x, y, width, height);
+    viewportRect[0] = x;
+    viewportRect[1] = y;
+    viewportRect[2] = width;
+    viewportRect[3] = height;
+    viewportKnown = true;
+    issued();
+}
+
+void GLStateCache::getViewport(GLint viewport[4]) {
+    if (!viewportKnown) {
+        glGetIntegerv(GL_VIEWPORT, viewportRect);
+        viewportKnown = true;
+    }
+    std::memcpy(viewport, viewportRect, sizeof(viewportRect));
+}
+
+void GLStateCache::setCapability(GLenum capability, bool enabled) {
+    int index = capabilityIndex(capability);
+    if (index >= 0 && capabilities[index] == (enabled ? 1 : 0)) {
+        skipped();
+        return;
+    }
+    if (enabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+    if (index >= 0) {
+        capabilities[index] = enabled ? 1 : 0;
+    }
+    issued();
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    if (depthFuncValue == func) {
+        skipped();
+        return;
+    }
+    glDepthFunc(func);
+    depthFuncValue = func;
+    issued();
+}
+
+void GLStateCache::depthMask(GLboolean mask) {
+    if (depthMaskValue == (mask ? 1 : 0)) {
+        skipped();
+        return;
+    }
+    glDepthMask(mask);
+    depthMaskValue = mask ? 1 : 0;
+    issued();
+}
+
+void GLStateCache::cullFace(GLenum mode) {
+    if (cullFaceValue == mode) {
+        skipped();
+        return;
+    }
+    glCullFace(mode);
+    cullFaceValue = mode;
+    issued();
+}
+
+void GLStateCache::polygonOffset(GLfloat factor, GLfloat units) {
+    if (polygonOffsetKnown && polygonOffsetValue[0] == factor && polygonOffsetValue[1] == units) {
+        skipped();
+        return;
+    }
+    glPolygonOffset(factor, units);
+    polygonOffsetValue[0] = factor;
+    polygonOffsetValue[1] = units;
+    polygonOffsetKnown = true;
+    issued();
+}
+
+void GLStateCache::polygonMode(GLenum mode) {
+    if (polygonModeValue == mode) {
+        skipped();
+        return;
+    }
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    polygonModeValue = mode;
+    issued();
+}
+
+void GLStateCache::deleteProgram(GLuint value) {
+    glDeleteProgram(value);
+    // 删除正在使用的程序时它仍然是当前程序，直到下一次 glUseProgram；同名的新程序必须重新绑定
+    if (program == value) {
+        program = UNKNOWN;
+    }
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint* vaos) {
+    glDeleteVertexArrays(count, vaos);
+    for (GLsizei i = 0; i < count; ++i) {
+        if (vertexArray == vaos[i]) {
+            vertexArray = 0;    // 删除当前绑定的对象时绑定恢复为 0
+        }
+    }
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint* names) {
+    glDeleteTextures(count, names);
+    for (GLsizei i = 0; i < count; ++i) {
+        if (names[i] == 0) {
+            continue;
+        }
+        for (auto& unit : textures) {
+            for (GLuint& texture : unit) {
+                if (texture == names[i]) {
+                    texture = 0;
+                }
+            }
+        }
+    }
+}
+
+void GLStateCache::deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    glDeleteFramebuffers(count, framebuffers);
+    for (GLsizei i = 0; i < count; ++i) {
+        if (framebuffers[i] == 0) {
+            continue;
+        }
+        if (readFramebuffer == framebuffers[i]) readFramebuffer = 0;
+        if (drawFramebuffer == framebuffers[i]) drawFramebuffer = 0;
+    }
+}
+
+std::vector<std::pair<std::string, size_t>> GLStateCache::getRedundantSites() const {
+    std::vector<std::pair<std::string, size_t>> sites = redundantSites;
+    std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    return sites;
+}
+
+void GLStateCache::logRedundantSites() const {
+    std::cout << "Redundant GL state calls by site:" << std::endl;
+    for (const auto& site : getRedundantSites()) {
+        std::cout << "  " << site.first << ": " << site.second << std::endl;
+    }
+}
+
+int GLStateCache::textureTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D: return 0;
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    case GL_TEXTURE_CUBE_MAP: return 2;
+    case GL_TEXTURE_CUBE_MAP_ARRAY: return 3;
+    case GL_TEXTURE_3D: return 4;
+    default: return -1;
+    }
+}
+
+int GLStateCache::capabilityIndex(GLenum capability) {
+    switch (capability) {
+    case GL_DEPTH_TEST: return 0;
+    case GL_CULL_FACE: return 1;
+    case GL_POLYGON_OFFSET_FILL: return 2;
+    case GL_BLEND: return 3;
+    default: return -1;
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// GL 状态缓存：记录当前绑定的程序、VAO、各纹理单元的纹理、读写帧缓冲、视口和深度 / 剔除 / 多边形偏移 / 多边形模式状态，
+// 与目标值相同的调用直接跳过，需要当前值时读缓存而不是 glGet*（glGet 会让驱动等待命令队列）
+// - 引擎代码通过 GL_STATE 宏访问，宏记录调用位置，调试模式下统计每个位置被跳过的重复调用
+// - 纹理绑定总是指定单元，调用后该单元为活动单元，随后的 glTexImage / glTexParameter 作用于刚绑定的纹理
+// - 删除对象要通过这里，GL 会复用对象名，缓存中的旧名字必须清除
+// - 绕过缓存修改状态的代码（ImGui 后端）执行后要调用 invalidate()，之后每种状态的第一次设置都会真正下发；
+//   帧之间不会自动 invalidate，get* 只在 invalidate 之后、该状态还没有设置过时才查询驱动
+class GLStateCache {
+public:
+    static constexpr int MAX_TEXTURE_UNITS = 32;
+
+    struct Stats {
+        size_t issued;      // 实际下发的状态调用
+        size_t skipped;     // 与缓存相同而跳过的调用
+    };
+
+    static GLStateCache& instance();
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+    // 记录调用位置，供 GL_STATE 宏使用
+    GLStateCache& at(const char* file, int line) {
+        siteFile = file;
+        siteLine = line;
+        return *this;
+    }
+
+    // 每帧开始时调用：结算上一帧的统计
+    void beginFrame();
+
+    // 把所有状态标记为未知
+    void invalidate();
+
+    void useProgram(GLuint program);
+    GLuint getProgram();
+
+    void bindVertexArray(GLuint vao);
+
+    // unit 为纹理单元下标（不是 GL_TEXTURE0 + i）
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // GL_FRAMEBUFFER 同时设置读和写
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    GLuint getDrawFramebuffer();
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void getViewport(GLint viewport[4]);
+
+    // 缓存 GL_DEPTH_TEST、GL_CULL_FACE、GL_POLYGON_OFFSET_FILL、GL_BLEND，其它开关直接下发
+    void enable(GLenum capability) { setCapability(capability, true); }
+    void disable(GLenum capability) { setCapability(capability, false); }
+
+    void depthFunc(GLenum func);
+    void depthMask(GLboolean mask);
+    void cullFace(GLenum mode);
+    void polygonOffset(GLfloat factor, GLfloat units);
+    // core profile 只允许 GL_FRONT_AND_BACK，只缓存模式
+    void polygonMode(GLenum mode);
+
+    void deleteProgram(GLuint program);
+    void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+    void deleteTextures(GLsizei count, const GLuint* textures);
+    void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+
+    // 上一帧的统计
+    const Stats& getLastStats() const { return lastStats; }
+
+    // 调试模式：按调用位置统计被跳过的重复调用
+    void setDebugEnabled(bool value) { debugEnabled = value; }
+    bool isDebugEnabled() const { return debugEnabled; }
+    std::vector<std::pair<std::string, size_t>> getRedundantSites() const;
+    void clearRedundantSites() { redundantSites.clear(); }
+    void logRedundantSites() const;
+
+private:
+    GLStateCache();
+
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+    static constexpr int TEXTURE_TARGETS = 5;   // 2D, 2D_ARRAY, CUBE_MAP, CUBE_MAP_ARRAY, 3D
+    static constexpr int CAPABILITIES = 4;      // DEPTH_TEST, CULL_FACE, POLYGON_OFFSET_FILL, BLEND
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint readFramebuffer;
+    GLuint drawFramebuffer;
+    GLint viewportRect[4];
+    bool viewportKnown;
+    int capabilities[CAPABILITIES];     // -1 未知，0 关闭，1 开启
+    GLenum depthFuncValue;
+    int depthMaskValue;                 // -1 未知
+    GLenum cullFaceValue;
+    GLfloat polygonOffsetValue[2];
+    bool polygonOffsetKnown;
+    GLenum polygonModeValue;
+
+    Stats stats = {};
+    Stats lastStats = {};
+
+    const char* siteFile = "";
+    int siteLine = 0;
+    bool debugEnabled = false;
+    std::vector<std::pair<std::string, size_t>> redundantSites;
+
+    void setCapability(GLenum capability, bool enabled);
+    void setActiveUnit(GLuint unit);
+    void issued() { ++stats.issued; }
+    void skipped();
+
+    static int textureTargetIndex(GLenum target);
+    static int capabilityIndex(GLenum capability);
+};
+
+#define GL_STATE GLStateCache::instance().at(__FILE__, __LINE__)
+
+#endif // GL_STATE_CACHE_H
@@ -3,7 +3,11 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include "Model.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "model.h"
 #include "BoundingBox.h"
 #include "Animator.h"
 
@@ -11,9 +15,12 @@ class GameObject {
 private:
 	std::string name;		   // 
     glm::mat4 modelMatrix;     // ģ;ı任
-    Model model;               // ģ
+    std::shared_ptr<Model> model;        // ģݣͬһ·干
+    std::vector<PBRMaterial> materials;  // ÿĲʣ
     BoundingBox boundingBox;   // Χ
     bool isSelected;            // Ƿѡ
+    bool occluder;              // ߱Ϊڵ壬 CPU ڵ޳Ĺդ
+    uint64_t version;           // 任޸ĺ£ΨһݴжʵǷҪؽ
 
     glm::vec3 position;        // λ
     glm::vec3 scale;           // 
@@ -21,8 +28,14 @@ private:
 
     Animator animator;
 
+    static uint64_t nextVersion() {
+        static std::atomic<uint64_t> counter{ 0 };
+        return ++counter;
+    }
+
     // ģ;
     void updateModelMatrix() {
+        version = nextVersion();
         modelMatrix = glm::mat4(1.0f);
         modelMatrix = glm::translate(modelMatrix, position);
         modelMatrix = glm::scale(modelMatrix, scale);
@@ -34,8 +47,8 @@ private:
 
     // °Χ
     void updateBoundingBox() {
-        glm::vec3 modelMin = model.boundingBox.min;
-        glm::vec3 modelMax = model.boundingBox.max;
+        glm::vec3 modelMin = model->boundingBox.min;
+        glm::vec3 modelMax = model->boundingBox.max;
 
         glm::vec3 scaledMin = modelMin * scale + position;
         glm::vec3 scaledMax = modelMax * scale + position;
@@ -52,18 +65,31 @@ public:
         const glm::vec3& scale = glm::vec3(1.0f),
         const glm::vec3& rotation = glm::vec3(0.0f),
         bool gamma = false)
-        : name(name), model(modelPath, gamma), animator(&model), position(position), scale(scale), rotation(rotation), isSelected(false) {
+        : name(name), model(Model::load(modelPath, gamma)), isSelected(false), occluder(false),
+        position(position), scale(scale), rotation(rotation), animator(model.get()) {
+        // ʴģ͸һݣ༭ʱӰ칲ͬһģ͵
+        for (const auto& mesh : model->meshes) {
+            materials.push_back(mesh.material);
+        }
         updateModelMatrix();
         //  Model нжӵ Animator
-        for (const auto& anim : model.animations) {
+        for (const auto& anim : model->animations) {
             animator.addAnimation(anim);
         }
     }
 
     // ӻȡ PBR ʵĺ
-    PBRMaterial& getPBRMaterial(unsigned int meshIndex = 0) {
-        // ÿ GameObject ֻһ Meshж MeshҪ meshIndex ȡ
-        return model.meshes[meshIndex].material;
+    const PBRMaterial& getPBRMaterial(unsigned int meshIndex = 0) const {
+        return materials[meshIndex];
+    }
+
+    void setPBRMaterial(unsigned int meshIndex, const PBRMaterial& material) {
+        materials[meshIndex] = material;
+        version = nextVersion();
+    }
+
+    const std::vector<PBRMaterial>& getMaterials() const {
+        return materials;
     }
 
     // ȡ
@@ -73,7 +99,12 @@ public:
 
     // ȡģ
     const Model& getModel() const {
-        return model;
+        return *model;
+    }
+
+    // ûй빲ͬһģ͵ϲΪʵ
+    bool isInstanceable() const {
+        return model->numBones == 0;
     }
 
     // ȡģ;
@@ -86,20 +117,31 @@ public:
         return boundingBox;
     }
 
-    // λ
+    // 任Ͳʵİ汾
+    uint64_t getVersion() const {
+        return version;
+    }
+
+    // λãֵʱ°汾
     void setPosition(const glm::vec3& newPosition) {
+        if (newPosition == position)
+            return;
         position = newPosition;
         updateModelMatrix();
     }
 
     // 
     void setScale(const glm::vec3& newScale) {
+        if (newScale == scale)
+            return;
         scale = newScale;
         updateModelMatrix();
     }
 
     // ת
     void setRotation(const glm::vec3& newRotation) {
+        if (newRotation == rotation)
+            return;
         rotation = newRotation;
         updateModelMatrix();
     }
@@ -121,20 +163,37 @@ public:
 
     // ߼
     void update(float deltaTime, Shader& shader) {
-
+        // ûй岻Ҫ¶̬л򡢲ѯ uniform
+        if (model->numBones == 0)
+            return;
         animator.update(deltaTime, shader.ID); // ¶
     }
 
-    // ϴص uniform
+    // ϴǷʹù峣 ObjectData::useBones 
     void uploadBoneUniforms(Shader& shader) {
-        bool useBones = (model.numBones > 0);
-        shader.use(); // ɫ
-        shader.setInt("useBones", useBones ? 1 : 0);
-        if (useBones) {
+        if (model->numBones > 0) {
+            shader.use(); // ɫ
             animator.update(0.0f, shader.ID); // ֱӴ Shader 
         }
     }
 
+    bool hasBones() const { return model->numBones > 0; }
+
+
+    // ͨƣֻģ;͹󣬲漰
+    void drawDepth(Shader& shader, GLsizei instanceCount = 1) const {
+        shader.setMat4("model", modelMatrix);
+
+        // ñ֡ѼĹ󣬱ظֵ
+        const std::vector<glm::mat4>& boneMatrices = animator.getFinalBoneMatrices();
+        bool useBones = model->numBones > 0 && !boneMatrices.empty();
+        shader.setInt("useBones", useBones ? 1 : 0);
+        if (useBones) {
+            shader.setMat4Array("bones", boneMatrices.data(), static_cast<int>(boneMatrices.size()));
+        }
+
+        model->DrawDepth(instanceCount);
+    }
 
     // ȡ
     const glm::vec3& getPosition() const { return position; }
@@ -144,6 +203,10 @@ public:
     // ѡ״̬ط
     bool getIsSelected() const { return isSelected; }
     void setIsSelected(bool selected) { isSelected = selected; }
+
+    // ڵ
+    bool isOccluder() const { return occluder; }
+    void setOccluder(bool value) { occluder = value; }
 };
 
 #endif // GAME_OBJECT_H
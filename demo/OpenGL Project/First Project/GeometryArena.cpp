@@ -0,0 +1,444 @@
+#include "GeometryArena.h"
+#include "mesh.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+// 初始容量，不够时按两倍扩容
+static const size_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+static const size_t INITIAL_INDEX_CAPACITY = 1 << 18;
+
+//------------------------------------------------------
+// RangeAllocator
+//------------------------------------------------------
+
+GeometryArena::RangeAllocator::RangeAllocator(size_t capacity)
+    : capacity(capacity), used(0) {
+    if (capacity > 0) {
+        freeBlocks[0] = capacity;
+    }
+}
+
+bool GeometryArena::RangeAllocator::allocate(size_t size, size_t& offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+        offset = it->first;
+        size_t remaining = it->second - size;
+        freeBlocks.erase(it);
+        if (remaining > 0) {
+            freeBlocks[offset + size] = remaining;
+        }
+        used += size;
+        return true;
+    }
+    return false;
+}
+
+void GeometryArena::RangeAllocator::free(size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    used -= size;
+    auto next = freeBlocks.lower_bound(offset);
+
+    // 与后一个空闲块相邻则合并
+    if (next != freeBlocks.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeBlocks.erase(next);
+    }
+    // 与前一个空闲块相邻则合并
+    if (next != freeBlocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    freeBlocks[offset] = size;
+}
+
+void GeometryArena::RangeAllocator::grow(size_t newCapacity) {
+    if (newCapacity <= capacity) {
+        return;
+    }
+    size_t oldCapacity = capacity;
+    capacity = newCapacity;
+    used += newCapacity - oldCapacity; // free 会减去这部分
+    free(oldCapacity, newCapacity - oldCapacity);
+}
+
+void GeometryArena::RangeAllocator::reset(size_t newUsed) {
+    used = newUsed;
+    freeBlocks.clear();
+    if (capacity > used) {
+        freeBlocks[used] = capacity - used;
+    }
+}
+
+size_t GeometryArena::RangeAllocator::getLargestFreeBlock() const {
+    size_t largest = 0;
+    for (const auto& block : freeBlocks) {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
+
+//------------------------------------------------------
+// GeometryArena
+//------------------------------------------------------
+
+GeometryArena& GeometryArena::instance() {
+    static GeometryArena arena;
+    return arena;
+}
+
+GeometryArena::GeometryArena()
+    : vertexAllocator(INITIAL_VERTEX_CAPACITY), indexAllocator(INITIAL_INDEX_CAPACITY) {
+    createBuffers(INITIAL_VERTEX_CAPACITY, INITIAL_INDEX_CAPACITY, vertexBuffer, positionBuffer, skinBuffer, indexBuffer);
+    setupVertexArrays();
+}
+
+void GeometryArena::createBuffers(size_t vertexCapacity, size_t indexCapacity,
+    GLuint& vertices, GLuint& positions, GLuint& skins, GLuint& indices) const {
+    // 用 COPY_WRITE 目标上传，避免改动当前 VAO 的索引缓冲绑定
+    auto create = [](GLuint& buffer, size_t size) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    };
+    create(vertices, vertexCapacity * sizeof(Vertex));
+    create(positions, vertexCapacity * sizeof(glm::vec3));
+    create(skins, vertexCapacity * sizeof(SkinVertex));
+    create(indices, indexCapacity * sizeof(unsigned int));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GeometryArena::releaseBuffers() {
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &positionBuffer);
+    glDeleteBuffers(1, &skinBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+}
+
+void GeometryArena::setupVertexArrays() {
+    // 着色：完整顶点流，属性布局与 Model Shader.vs 对应
+    auto setupColor = [](GLuint vao) {
+        GL_STATE.bindVertexArray(vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribFormat(3, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribFormat(4, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Bitangent));
+        glEnableVertexAttribArray(5);
+        glVertexAttribIFormat(5, 4, GL_INT, offsetof(Vertex, boneIDs));
+        glEnableVertexAttribArray(6);
+        glVertexAttribFormat(6, 4, GL_FLOAT, GL_FALSE, offsetof(Vertex, weights));
+        for (GLuint attrib = 0; attrib <= 6; ++attrib) {
+            glVertexAttribBinding(attrib, 0);
+        }
+    };
+
+    // 深度：位置流（绑定点 0），蒙皮网格另加蒙皮流（绑定点 1）
+    auto setupDepth = [](GLuint vao, bool skinned) {
+        GL_STATE.bindVertexArray(vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(0, 0);
+        if (!skinned) {
+            return;
+        }
+        glEnableVertexAttribArray(5);
+        glVertexAttribIFormat(5, 4, GL_INT, offsetof(SkinVertex, boneIDs));
+        glVertexAttribBinding(5, 1);
+        glEnableVertexAttribArray(6);
+        glVertexAttribFormat(6, 4, GL_FLOAT, GL_FALSE, offsetof(SkinVertex, weights));
+        glVertexAttribBinding(6, 1);
+    };
+
+    // 每实例属性：模型矩阵（7~10），着色时还有材质常量（11~12）
+    auto setupInstance = [](bool withMaterial) {
+        for (GLuint c = 0; c < 4; ++c) {
+            glEnableVertexAttribArray(7 + c);
+            glVertexAttribFormat(7 + c, 4, GL_FLOAT, GL_FALSE,
+                static_cast<GLuint>(offsetof(InstanceData, model) + sizeof(glm::vec4) * c));
+            glVertexAttribBinding(7 + c, INSTANCE_BINDING);
+        }
+        if (withMaterial) {
+            glEnableVertexAttribArray(11);
+            glVertexAttribFormat(11, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, albedoMetallic));
+            glVertexAttribBinding(11, INSTANCE_BINDING);
+            glEnableVertexAttribArray(12);
+            glVertexAttribFormat(12, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, roughnessAO));
+            glVertexAttribBinding(12, INSTANCE_BINDING);
+        }
+        glVertexBindingDivisor(INSTANCE_BINDING, 1);
+    };
+
+    glGenVertexArrays(1, &colorVAO);
+    glGenVertexArrays(1, &colorInstancedVAO);
+    glGenVertexArrays(1, &depthVAO);
+    glGenVertexArrays(1, &depthInstancedVAO);
+    glGenVertexArrays(1, &skinnedDepthVAO);
+
+    setupColor(colorVAO);
+    setupColor(colorInstancedVAO);
+    setupInstance(true);
+    setupDepth(depthVAO, false);
+    setupDepth(depthInstancedVAO, false);
+    setupInstance(false);
+    setupDepth(skinnedDepthVAO, true);
+    GL_STATE.bindVertexArray(0);
+
+    // 未启用的属性读取上下文的当前值（默认权重为 (0,0,0,1)）；置零后着色器把没有蒙皮流的网格按静态处理
+    glVertexAttribI4i(5, 0, 0, 0, 0);
+    glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+
+    attachBuffers();
+}
+
+void GeometryArena::attachBuffers() const {
+    for (GLuint vao : { colorVAO, colorInstancedVAO }) {
+        GL_STATE.bindVertexArray(vao);
+        glBindVertexBuffer(0, vertexBuffer, 0, sizeof(Vertex));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+    for (GLuint vao : { depthVAO, depthInstancedVAO, skinnedDepthVAO }) {
+        GL_STATE.bindVertexArray(vao);
+        glBindVertexBuffer(0, positionBuffer, 0, sizeof(glm::vec3));
+        if (vao == skinnedDepthVAO) {
+            glBindVertexBuffer(1, skinBuffer, 0, sizeof(SkinVertex));
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+    GL_STATE.bindVertexArray(0);
+}
+
+bool GeometryArena::reserve(size_t vertexCount, size_t indexCount, size_t& vertexOffset, size_t& indexOffset) {
+    if (!vertexAllocator.allocate(vertexCount, vertexOffset)) {
+        return false;
+    }
+    if (!indexAllocator.allocate(indexCount, indexOffset)) {
+        vertexAllocator.free(vertexOffset, vertexCount);
+        return false;
+    }
+    return true;
+}
+
+GeometryArena::Handle GeometryArena::allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    size_t vertexOffset = 0, indexOffset = 0;
+    if (!reserve(vertices.size(), indices.size(), vertexOffset, indexOffset)) {
+        // 空闲总量够用时先整理碎片，否则扩容
+        size_t vertexFree = vertexAllocator.getCapacity() - vertexAllocator.getUsed();
+        size_t indexFree = indexAllocator.getCapacity() - indexAllocator.getUsed();
+        if (vertexFree >= vertices.size() && indexFree >= indices.size()) {
+            defragment();
+        }
+        else {
+            grow(vertexAllocator.getUsed() + vertices.size(), indexAllocator.getUsed() + indices.size());
+        }
+        if (!reserve(vertices.size(), indices.size(), vertexOffset, indexOffset)) {
+            grow(vertexAllocator.getCapacity() + vertices.size(), indexAllocator.getCapacity() + indices.size());
+            reserve(vertices.size(), indices.size(), vertexOffset, indexOffset);
+        }
+    }
+
+    // 拆出深度通道用的位置流和蒙皮流
+    std::vector<glm::vec3> positions;
+    std::vector<SkinVertex> skins;
+    positions.reserve(vertices.size());
+    skins.reserve(vertices.size());
+    for (const auto& v : vertices) {
+        positions.push_back(v.Position);
+        SkinVertex skin;
+        for (int i = 0; i < 4; ++i) {
+            skin.boneIDs[i] = v.boneIDs[i];
+            skin.weights[i] = v.weights[i];
+        }
+        skins.push_back(skin);
+    }
+
+    auto upload = [](GLuint buffer, size_t offset, size_t size, const void* data) {
+        if (size == 0) return;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        RENDER_STATS_UPLOAD(size);
+    };
+    upload(vertexBuffer, vertexOffset * sizeof(Vertex), vertices.size() * sizeof(Vertex), vertices.data());
+    upload(positionBuffer, vertexOffset * sizeof(glm::vec3), positions.size() * sizeof(glm::vec3), positions.data());
+    upload(skinBuffer, vertexOffset * sizeof(SkinVertex), skins.size() * sizeof(SkinVertex), skins.data());
+    upload(indexBuffer, indexOffset * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    Handle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else {
+        handle = static_cast<Handle>(allocations.size());
+        allocations.push_back(Allocation());
+    }
+    Allocation& allocation = allocations[handle];
+    allocation.alive = true;
+    allocation.range.baseVertex = static_cast<GLint>(vertexOffset);
+    allocation.range.vertexCount = static_cast<GLuint>(vertices.size());
+    allocation.range.firstIndex = static_cast<GLuint>(indexOffset);
+    allocation.range.indexCount = static_cast<GLuint>(indices.size());
+    return handle;
+}
+
+void GeometryArena::free(Handle handle) {
+    if (handle >= allocations.size() || !allocations[handle].alive) {
+        return;
+    }
+    Allocation& allocation = allocations[handle];
+    vertexAllocator.free(allocation.range.baseVertex, allocation.range.vertexCount);
+    indexAllocator.free(allocation.range.firstIndex, allocation.range.indexCount);
+    allocation.alive = false;
+    allocation.range = Range();
+    freeHandles.push_back(handle);
+}
+
+void GeometryArena::grow(size_t minVertexCapacity, size_t minIndexCapacity) {
+    size_t vertexCapacity = std::max(vertexAllocator.getCapacity() * 2, minVertexCapacity);
+    size_t indexCapacity = std::max(indexAllocator.getCapacity() * 2, minIndexCapacity);
+
+    GLuint vertices, positions, skins, indices;
+    createBuffers(vertexCapacity, indexCapacity, vertices, positions, skins, indices);
+
+    // 旧内容原样拷贝到新缓冲的前部
+    auto copy = [](GLuint from, GLuint to, size_t size) {
+        glBindBuffer(GL_COPY_READ_BUFFER, from);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    };
+    copy(vertexBuffer, vertices, vertexAllocator.getCapacity() * sizeof(Vertex));
+    copy(positionBuffer, positions, vertexAllocator.getCapacity() * sizeof(glm::vec3));
+    copy(skinBuffer, skins, vertexAllocator.getCapacity() * sizeof(SkinVertex));
+    copy(indexBuffer, indices, indexAllocator.getCapacity() * sizeof(unsigned int));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    releaseBuffers();
+    vertexBuffer = vertices;
+    positionBuffer = positions;
+    skinBuffer = skins;
+    indexBuffer = indices;
+    vertexAllocator.grow(vertexCapacity);
+    indexAllocator.grow(indexCapacity);
+    attachBuffers();
+    ++growCount;
+}
+
+void GeometryArena::defragment() {
+    GLuint vertices, positions, skins, indices;
+    createBuffers(vertexAllocator.getCapacity(), indexAllocator.getCapacity(), vertices, positions, skins, indices);
+
+    // 按原来的偏移顺序依次紧凑拷贝到新缓冲；索引相对 baseVertex，不需要改写
+    std::vector<Handle> order;
+    for (Handle h = 0; h < allocations.size(); ++h) {
+        if (allocations[h].alive) {
+            order.push_back(h);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](Handle a, Handle b) {
+        return allocations[a].range.baseVertex < allocations[b].range.baseVertex;
+    });
+
+    auto copy = [](GLuint from, GLuint to, size_t src, size_t dst, size_t size) {
+        if (size == 0) return;
+        glBindBuffer(GL_COPY_READ_BUFFER, from);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src, dst, size);
+    };
+
+    size_t nextVertex = 0, nextIndex = 0;
+    for (Handle h : order) {
+        Range& range = allocations[h].range;
+        copy(vertexBuffer, vertices, range.baseVertex * sizeof(Vertex), nextVertex * sizeof(Vertex), range.vertexCount * sizeof(Vertex));
+        copy(positionBuffer, positions, range.baseVertex * sizeof(glm::vec3), nextVertex * sizeof(glm::vec3), range.vertexCount * sizeof(glm::vec3));
+        copy(skinBuffer, skins, range.baseVertex * sizeof(SkinVertex), nextVertex * sizeof(SkinVertex), range.vertexCount * sizeof(SkinVertex));
+        copy(indexBuffer, indices, range.firstIndex * sizeof(unsigned int), nextIndex * sizeof(unsigned int), range.indexCount * sizeof(unsigned int));
+        range.baseVertex = static_cast<GLint>(nextVertex);
+        range.firstIndex = static_cast<GLuint>(nextIndex);
+        nextVertex += range.vertexCount;
+        nextIndex += range.indexCount;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    releaseBuffers();
+    vertexBuffer = vertices;
+    positionBuffer = positions;
+    skinBuffer = skins;
+    indexBuffer = indices;
+    vertexAllocator.reset(nextVertex);
+    indexAllocator.reset(nextIndex);
+    attachBuffers();
+    ++defragmentCount;
+}
+
+DrawElementsIndirectCommand GeometryArena::makeCommand(Handle handle, GLuint instanceCount, GLuint baseInstance) const {
+    const Range& range = allocations[handle].range;
+    return { range.indexCount, instanceCount, range.firstIndex, range.baseVertex, baseInstance };
+}
+
+void GeometryArena::bindColor() const {
+    GL_STATE.bindVertexArray(colorVAO);
+}
+
+void GeometryArena::bindColorInstanced(GLuint instanceBuffer) const {
+    GL_STATE.bindVertexArray(colorInstancedVAO);
+    glBindVertexBuffer(INSTANCE_BINDING, instanceBuffer, 0, sizeof(InstanceData));
+}
+
+void GeometryArena::bindDepth(bool skinned) const {
+    GL_STATE.bindVertexArray(skinned ? skinnedDepthVAO : depthVAO);
+}
+
+void GeometryArena::bindDepthInstanced(GLuint instanceBuffer) const {
+    GL_STATE.bindVertexArray(depthInstancedVAO);
+    glBindVertexBuffer(INSTANCE_BINDING, instanceBuffer, 0, sizeof(InstanceData));
+}
+
+void GeometryArena::drawElements(Handle handle, GLsizei instanceCount, GLuint baseInstance) const {
+    const Range& range = allocations[handle].range;
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), GL_UNSIGNED_INT,
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(range.firstIndex) * sizeof(unsigned int)),
+        instanceCount, range.baseVertex, baseInstance);
+    RENDER_STATS_DRAW(static_cast<uint64_t>(range.indexCount / 3) * instanceCount);
+}
+
+float GeometryArena::fragmentation(const RangeAllocator& allocator) {
+    size_t freeTotal = allocator.getCapacity() - allocator.getUsed();
+    if (freeTotal == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(allocator.getLargestFreeBlock()) / static_cast<float>(freeTotal);
+}
+
+GeometryArena::Stats GeometryArena::getStats() const {
+    Stats stats;
+    stats.allocations = allocations.size() - freeHandles.size();
+    stats.vertexCapacity = vertexAllocator.getCapacity();
+    stats.vertexUsed = vertexAllocator.getUsed();
+    stats.vertexFreeBlocks = vertexAllocator.getFreeBlockCount();
+    stats.indexCapacity = indexAllocator.getCapacity();
+    stats.indexUsed = indexAllocator.getUsed();
+    stats.indexFreeBlocks = indexAllocator.getFreeBlockCount();
+    stats.vertexFragmentation = fragmentation(vertexAllocator);
+    stats.indexFragmentation = fragmentation(indexAllocator);
+    stats.defragmentCount = defragmentCount;
+    stats.growCount = growCount;
+    return stats;
+}
@@ -0,0 +1,152 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <glad/glad.h>
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+// glMultiDrawElementsIndirect 的命令格式
+struct DrawElementsIndirectCommand {
+    GLuint count;          // 索引数
+    GLuint instanceCount;  // 实例数
+    GLuint firstIndex;     // 在共享索引缓冲中的起始位置
+    GLint baseVertex;      // 在共享顶点缓冲中的起始位置
+    GLuint baseInstance;   // 在实例缓冲中的起始位置
+};
+
+// 全局几何缓冲：所有网格的顶点和索引放在少数几个大缓冲中
+// - 顶点按格式分为三个并行的流：完整顶点（着色）、位置（深度）、蒙皮（深度），共用同一个顶点偏移
+// - 顶点和索引各用一个空闲链表子分配，空间不足时先整理碎片，仍不够再扩容
+// - 网格只持有分配句柄，整理碎片后句柄不变，偏移由句柄查得
+// - 只有 5 个 VAO（着色/深度 × 单个/实例化，另加读取蒙皮流的深度 VAO），绘制时无需按网格切换；
+//   静态网格的深度绘制只读取位置流（12 B/顶点），只有蒙皮网格才额外读取蒙皮流
+class GeometryArena {
+public:
+    // 空闲链表子分配器（单位为元素个数），首次适配，释放时合并相邻空闲块
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(size_t capacity = 0);
+
+        bool allocate(size_t size, size_t& offset);
+        void free(size_t offset, size_t size);
+
+        // 扩容，新增部分作为空闲块
+        void grow(size_t newCapacity);
+        // 紧凑排列后只剩末尾一个空闲块
+        void reset(size_t used);
+
+        size_t getCapacity() const { return capacity; }
+        size_t getUsed() const { return used; }
+        size_t getFreeBlockCount() const { return freeBlocks.size(); }
+        size_t getLargestFreeBlock() const;
+
+    private:
+        size_t capacity;
+        size_t used;
+        std::map<size_t, size_t> freeBlocks; // 偏移 -> 大小
+    };
+
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0xFFFFFFFFu;
+
+    // 一次分配在共享缓冲中的位置
+    struct Range {
+        GLint baseVertex = 0;
+        GLuint vertexCount = 0;
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+    };
+
+    struct Stats {
+        size_t allocations;
+        size_t vertexCapacity, vertexUsed, vertexFreeBlocks;
+        size_t indexCapacity, indexUsed, indexFreeBlocks;
+        float vertexFragmentation;  // 1 - 最大空闲块 / 空闲总量，0 表示没有碎片
+        float indexFragmentation;
+        size_t defragmentCount;
+        size_t growCount;
+    };
+
+    // 实例数据的顶点缓冲绑定点
+    static constexpr GLuint INSTANCE_BINDING = 7;
+
+    // 全局实例，首次使用时创建（需要已有 GL 上下文）；缓冲随上下文一起释放
+    static GeometryArena& instance();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // 上传网格数据，返回句柄
+    Handle allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void free(Handle handle);
+
+    const Range& getRange(Handle handle) const { return allocations[handle].range; }
+
+    // 生成绘制该网格的间接命令
+    DrawElementsIndirectCommand makeCommand(Handle handle, GLuint instanceCount, GLuint baseInstance) const;
+
+    // 绑定 VAO；实例化版本同时把实例缓冲绑定到 INSTANCE_BINDING
+    void bindColor() const;
+    void bindColorInstanced(GLuint instanceBuffer) const;
+    // skinned 为 true 时同时读取蒙皮流（属性 5、6）；实例化只用于静态网格，不读取蒙皮流
+    void bindDepth(bool skinned = false) const;
+    void bindDepthInstanced(GLuint instanceBuffer) const;
+
+    // 使用当前绑定的 VAO 绘制一个网格
+    void drawElements(Handle handle, GLsizei instanceCount = 1, GLuint baseInstance = 0) const;
+
+    // 把所有分配紧凑地移到缓冲前部，消除碎片
+    void defragment();
+    // 整理次数；变化后之前由 makeCommand 生成的命令偏移失效
+    size_t getDefragmentCount() const { return defragmentCount; }
+
+    Stats getStats() const;
+
+private:
+    GeometryArena();
+
+    struct Allocation {
+        Range range;
+        bool alive = false;
+    };
+
+    struct SkinVertex {
+        int boneIDs[4];
+        float weights[4];
+    };
+
+    RangeAllocator vertexAllocator;
+    RangeAllocator indexAllocator;
+    std::vector<Allocation> allocations;
+    std::vector<Handle> freeHandles;
+
+    GLuint vertexBuffer = 0;    // 完整顶点
+    GLuint positionBuffer = 0;  // 紧密排列的位置
+    GLuint skinBuffer = 0;      // 骨骼 ID + 权重
+    GLuint indexBuffer = 0;
+
+    GLuint colorVAO = 0;
+    GLuint colorInstancedVAO = 0;
+    GLuint depthVAO = 0;
+    GLuint depthInstancedVAO = 0;
+    GLuint skinnedDepthVAO = 0;
+
+    size_t defragmentCount = 0;
+    size_t growCount = 0;
+
+    bool reserve(size_t vertexCount, size_t indexCount, size_t& vertexOffset, size_t& indexOffset);
+    void grow(size_t minVertexCapacity, size_t minIndexCapacity);
+    void createBuffers(size_t vertexCapacity, size_t indexCapacity,
+        GLuint& vertices, GLuint& positions, GLuint& skins, GLuint& indices) const;
+    void releaseBuffers();
+    void setupVertexArrays();
+    void attachBuffers() const;
+
+    static float fragmentation(const RangeAllocator& allocator);
+};
+
+#endif // GEOMETRY_ARENA_H
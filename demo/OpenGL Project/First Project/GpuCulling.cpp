@@ -0,0 +1,238 @@
+#include "GpuCulling.h"
+#include "FrameUniforms.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+GpuCulling::GpuCulling()
+    : inputInstanceBuffer(0), instanceCommandBuffer(0), boundsBuffer(0), commandTemplateBuffer(0),
+    commandBuffer(0), visibleInstanceBuffer(0), instanceCount(0), commandCount(0),
+    instanceCapacity(0), commandCapacity(0), lastPlanes(), lastHiZ(nullptr) {
+}
+
+GpuCulling::~GpuCulling() {
+    GLuint buffers[] = { instanceCommandBuffer, boundsBuffer, commandTemplateBuffer, commandBuffer, visibleInstanceBuffer };
+    glDeleteBuffers(5, buffers);
+    if (cullShader) GL_STATE.deleteProgram(cullShader->ID);
+}
+
+bool GpuCulling::initialize() {
+    cullShader = std::make_unique<Shader>("./shaders/cull_instances.comp");
+    GLint linked = 0;
+    glGetProgramiv(cullShader->ID, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        std::cerr << "Failed to build GPU culling shader." << std::endl;
+        return false;
+    }
+
+    glGenBuffers(1, &instanceCommandBuffer);
+    glGenBuffers(1, &boundsBuffer);
+    glGenBuffers(1, &commandTemplateBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &visibleInstanceBuffer);
+    return true;
+}
+
+void GpuCulling::ensureCapacity(size_t instances, size_t commands) {
+    // 输出缓冲只由 GPU 读写，按需扩容
+    if (instances > instanceCapacity) {
+        instanceCapacity = std::max(instances, instanceCapacity * 2);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, visibleInstanceBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, instanceCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_COPY);
+    }
+    if (commands > commandCapacity) {
+        commandCapacity = std::max(commands, commandCapacity * 2);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, commandCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GpuCulling::setInputs(GLuint instanceBuffer, const std::vector<GLuint>& instanceCommands,
+    const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<CommandBounds>& bounds) {
+    inputInstanceBuffer = instanceBuffer;
+    instanceCount = instanceCommands.size();
+    commandCount = commands.size();
+    if (instanceCount == 0) {
+        return;
+    }
+    ensureCapacity(instanceCount, commandCount);
+
+    // 命令模板：与场景的命令相同，只是实例数清零，由剔除时累加
+    std::vector<DrawElementsIndirectCommand> templateCommands = commands;
+    for (auto& command : templateCommands) {
+        command.instanceCount = 0;
+    }
+
+    auto upload = [](GLuint buffer, const void* data, size_t size) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STREAM_DRAW);
+        RENDER_STATS_UPLOAD(size);
+    };
+    upload(instanceCommandBuffer, instanceCommands.data(), instanceCommands.size() * sizeof(GLuint));
+    upload(boundsBuffer, bounds.data(), bounds.size() * sizeof(CommandBounds));
+    upload(commandTemplateBuffer, templateCommands.data(), templateCommands.size() * sizeof(DrawElementsIndirectCommand));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GpuCulling::cull(const Planes& planes, const HiZBuffer* hiZ) {
+    lastPlanes = planes;
+    lastHiZ = (hiZ && hiZ->isValid()) ? hiZ : nullptr;
+    if (instanceCount == 0) {
+        return;
+    }
+
+    // 重置输出命令
+    glBindBuffer(GL_COPY_READ_BUFFER, commandTemplateBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandCount * sizeof(DrawElementsIndirectCommand));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // 调用方通常已激活了自己的着色器，剔除后恢复
+    GLuint previousProgram = GL_STATE.getProgram();
+
+    cullShader->use();
+    glUniform1ui(glGetUniformLocation(cullShader->ID, "instanceCount"), static_cast<GLuint>(instanceCount));
+    RENDER_STATS_UNIFORM();
+    cullShader->setVec4Array("planes", planes.data(), 6);
+    cullShader->setInt("useHiZ", lastHiZ ? 1 : 0);
+    if (lastHiZ) {
+        GL_STATE.bindTexture(HIZ_TEXTURE_UNIT, GL_TEXTURE_2D, lastHiZ->getTexture());
+        RENDER_STATS_TEXTURE();
+        cullShader->setInt("hiZ", HIZ_TEXTURE_UNIT);
+        cullShader->setInt("hiZLevels", lastHiZ->getLevelCount());
+        cullShader->setMat4("hiZViewProjection", lastHiZ->getViewProjection());
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, inputInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, instanceCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, boundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, visibleInstanceBuffer);
+    glDispatchCompute(static_cast<GLuint>((instanceCount + 63) / 64), 1, 1);
+    RENDER_STATS_DISPATCH();
+
+    // 结果作为间接命令和实例属性读取；下次剔除前还要拷贝覆盖命令缓冲
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // 3 号绑定点平时是材质表
+    FrameUniforms::instance().bindMaterials();
+
+    GL_STATE.useProgram(previousProgram);
+    RENDER_STATS_PROGRAM();
+}
+
+GpuCulling::Planes GpuCulling::frustumPlanes(const glm::mat4& m) {
+    // glm 为列主序，第 i 行为 (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    return { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+}
+
+GpuCulling::Planes GpuCulling::boxPlanes(const glm::vec3& center, float halfExtent) {
+    return {
+        glm::vec4(1.0f, 0.0f, 0.0f, halfExtent - center.x),
+        glm::vec4(-1.0f, 0.0f, 0.0f, halfExtent + center.x),
+        glm::vec4(0.0f, 1.0f, 0.0f, halfExtent - center.y),
+        glm::vec4(0.0f, -1.0f, 0.0f, halfExtent + center.y),
+        glm::vec4(0.0f, 0.0f, 1.0f, halfExtent - center.z),
+        glm::vec4(0.0f, 0.0f, -1.0f, halfExtent + center.z)
+    };
+}
+
+bool GpuCulling::isVisible(const glm::mat4& model, const CommandBounds& bounds, const Planes& planes,
+    const HiZBuffer* hiZ, const std::vector<std::vector<float>>& hiZLevels) {
+    glm::vec3 localCenter = (glm::vec3(bounds.boundsMin) + glm::vec3(bounds.boundsMax)) * 0.5f;
+    glm::vec3 localExtent = (glm::vec3(bounds.boundsMax) - glm::vec3(bounds.boundsMin)) * 0.5f;
+    glm::vec3 center = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+    glm::mat3 absModel(glm::abs(glm::vec3(model[0])), glm::abs(glm::vec3(model[1])), glm::abs(glm::vec3(model[2])));
+    glm::vec3 extent = absModel * localExtent;
+
+    // 视锥
+    for (const glm::vec4& plane : planes) {
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    if (!hiZ || hiZLevels.empty()) {
+        return true;
+    }
+
+    // Hi-Z 遮挡
+    glm::vec2 uvMin(1.0f), uvMax(0.0f);
+    float nearestDepth = 1.0f;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner = center + extent * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        glm::vec4 clip = hiZ->getViewProjection() * glm::vec4(corner, 1.0f);
+        if (clip.w <= 1e-4f) {
+            return true;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        uvMin = glm::min(uvMin, glm::vec2(ndc) * 0.5f + 0.5f);
+        uvMax = glm::max(uvMax, glm::vec2(ndc) * 0.5f + 0.5f);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    glm::ivec2 size = hiZ->getLevelSize(0);
+    glm::ivec2 texelMin = glm::clamp(glm::ivec2(glm::floor(glm::clamp(uvMin, 0.0f, 1.0f) * glm::vec2(size))), glm::ivec2(0), size - 1);
+    glm::ivec2 texelMax = glm::clamp(glm::ivec2(glm::floor(glm::clamp(uvMax, 0.0f, 1.0f) * glm::vec2(size))), glm::ivec2(0), size - 1);
+
+    glm::ivec2 span = texelMax - texelMin;
+    int maxSpan = std::max(span.x, span.y);
+    int level = 0;
+    while ((1 << level) <= maxSpan) {
+        ++level;
+    }
+    if (level >= hiZ->getLevelCount()) {
+        return true;
+    }
+
+    glm::ivec2 levelSize = hiZ->getLevelSize(level);
+    glm::ivec2 p0 = glm::min(glm::ivec2(texelMin.x >> level, texelMin.y >> level), levelSize - 1);
+    glm::ivec2 p1 = glm::min(glm::ivec2(texelMax.x >> level, texelMax.y >> level), levelSize - 1);
+    const std::vector<float>& texels = hiZLevels[level];
+    auto fetch = [&](int x, int y) { return texels[static_cast<size_t>(y) * levelSize.x + x]; };
+    float farthest = std::max(std::max(fetch(p0.x, p0.y), fetch(p1.x, p0.y)), std::max(fetch(p0.x, p1.y), fetch(p1.x, p1.y)));
+    return nearestDepth <= farthest;
+}
+
+GpuCulling::ValidationResult GpuCulling::validate(const std::vector<InstanceData>& instances,
+    const std::vector<GLuint>& instanceCommands, const std::vector<CommandBounds>& bounds) const {
+    ValidationResult result = { instanceCount, 0, 0, 0 };
+    if (instanceCount == 0 || instances.size() != instanceCount) {
+        return result;
+    }
+
+    std::vector<DrawElementsIndirectCommand> gpuCommands(commandCount);
+    glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, commandCount * sizeof(DrawElementsIndirectCommand), gpuCommands.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    std::vector<std::vector<float>> hiZLevels;
+    if (lastHiZ) {
+        hiZLevels = lastHiZ->readLevels();
+    }
+
+    std::vector<GLuint> cpuCounts(commandCount, 0);
+    for (size_t i = 0; i < instanceCount; ++i) {
+        GLuint command = instanceCommands[i];
+        if (isVisible(instances[i].model, bounds[command], lastPlanes, lastHiZ, hiZLevels)) {
+            ++cpuCounts[command];
+        }
+    }
+
+    for (size_t c = 0; c < commandCount; ++c) {
+        result.gpuVisible += gpuCommands[c].instanceCount;
+        result.cpuVisible += cpuCounts[c];
+        if (gpuCommands[c].instanceCount != cpuCounts[c]) {
+            ++result.mismatchedCommands;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,93 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <memory>
+#include <vector>
+#include "mesh.h"
+#include "GeometryArena.h"
+#include "HiZBuffer.h"
+
+// GPU 驱动的实例剔除
+// - 输入：场景的实例缓冲、每个实例所属的间接命令、每条命令对应网格的局部包围盒
+// - cull 时先把命令模板（instanceCount = 0）拷贝到输出命令缓冲，再由计算着色器
+//   对每个实例做视锥 / Hi-Z 测试，可见实例写到所属命令的 baseInstance 起的连续位置
+// - 之后的 glMultiDrawElementsIndirect 直接使用输出缓冲，CPU 不需要知道可见数量
+class GpuCulling {
+public:
+    using Planes = std::array<glm::vec4, 6>;
+
+    // 网格局部空间的包围盒，与 cull_instances.comp 中的 CommandBounds 对应
+    struct CommandBounds {
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+    };
+
+    GpuCulling();
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // 编译计算着色器
+    bool initialize();
+
+    // 更新剔除输入，每帧在场景合并实例之后调用一次
+    void setInputs(GLuint instanceBuffer, const std::vector<GLuint>& instanceCommands,
+        const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<CommandBounds>& bounds);
+
+    // 按给定视锥（以及可选的 Hi-Z）剔除，结果写入输出缓冲
+    void cull(const Planes& planes, const HiZBuffer* hiZ);
+
+    GLuint getCommandBuffer() const { return commandBuffer; }
+    GLuint getInstanceBuffer() const { return visibleInstanceBuffer; }
+
+    // 从 viewProjection 提取视锥平面（法线指向内侧，未归一化）
+    static Planes frustumPlanes(const glm::mat4& viewProjection);
+    // 以 center 为中心、半边长为 halfExtent 的立方体，用于点光源阴影
+    static Planes boxPlanes(const glm::vec3& center, float halfExtent);
+
+    // CPU 参考实现，判断逻辑与 cull_instances.comp 一致；hiZLevels 为空时只做视锥测试
+    static bool isVisible(const glm::mat4& model, const CommandBounds& bounds, const Planes& planes,
+        const HiZBuffer* hiZ, const std::vector<std::vector<float>>& hiZLevels);
+
+    struct ValidationResult {
+        size_t instances;
+        size_t gpuVisible;
+        size_t cpuVisible;
+        size_t mismatchedCommands;   // 可见数量与 CPU 结果不一致的命令数
+    };
+
+    // 读回上一次 cull 的命令，与 CPU 剔除结果逐条比较
+    // 需在 Hi-Z 重建之前调用，保证两边使用同一份深度金字塔
+    ValidationResult validate(const std::vector<InstanceData>& instances, const std::vector<GLuint>& instanceCommands,
+        const std::vector<CommandBounds>& bounds) const;
+
+private:
+    // Hi-Z 纹理使用的纹理单元，避开材质（0~5）和阴影（16~19）
+    static constexpr GLuint HIZ_TEXTURE_UNIT = 20;
+
+    std::unique_ptr<Shader> cullShader;
+
+    GLuint inputInstanceBuffer;     // 场景的实例缓冲，不归本类所有
+    GLuint instanceCommandBuffer;   // 每实例的命令下标
+    GLuint boundsBuffer;            // 每命令的包围盒
+    GLuint commandTemplateBuffer;   // instanceCount 清零的命令模板
+    GLuint commandBuffer;           // 剔除后的间接命令
+    GLuint visibleInstanceBuffer;   // 剔除后的实例数据
+    size_t instanceCount;
+    size_t commandCount;
+
+    size_t instanceCapacity;
+    size_t commandCapacity;
+
+    // 上一次 cull 的参数，供 validate 复现
+    Planes lastPlanes;
+    const HiZBuffer* lastHiZ;
+
+    void ensureCapacity(size_t instances, size_t commands);
+};
+
+#endif // GPU_CULLING_H
@@ -0,0 +1,265 @@
+#include "GpuProfiler.h"
+#include "TraceJson.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+GpuProfiler& GpuProfiler::instance() {
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+void GpuProfiler::beginFrame() {
+    if (!enabled) {
+        return;
+    }
+
+    current = (current + 1) % FRAME_LATENCY;
+    Frame& frame = frames[current];
+    if (frame.pending && !collect(frame)) {
+        ++droppedFrames;
+    }
+    frame.pending = false;
+    frame.queriesUsed = 0;
+    frame.scopes.clear();
+    stack.clear();
+
+    inFrame = true;
+    push("Frame");
+}
+
+void GpuProfiler::endFrame() {
+    if (!inFrame) {
+        return;
+    }
+    // 未配对的作用域一并关闭
+    while (!stack.empty()) {
+        pop();
+    }
+    frames[current].pending = true;
+    inFrame = false;
+}
+
+bool GpuProfiler::collectPending() {
+    if (inFrame) {
+        return false;
+    }
+    // 从最旧的一组开始，与 beginFrame 的读取顺序一致
+    for (int i = 1; i <= FRAME_LATENCY; ++i) {
+        Frame& frame = frames[(current + i) % FRAME_LATENCY];
+        if (!frame.pending) {
+            continue;
+        }
+        glFinish();
+        if (!collect(frame)) {
+            ++droppedFrames;
+        }
+        frame.pending = false;
+        return true;
+    }
+    return false;
+}
+
+float GpuProfiler::getLastMs(const char* path) const {
+    for (const ScopeHistory& entry : history) {
+        if (entry.path == path) {
+            return entry.lastMs;
+        }
+    }
+    return 0.0f;
+}
+
+bool GpuProfiler::ScopeKey::operator<(const ScopeKey& other) const {
+    if (parentId != other.parentId) {
+        return parentId < other.parentId;
+    }
+    if (index != other.index) {
+        return index < other.index;
+    }
+    // 不同编译单元中相同的字面量地址可能不同，按内容比较
+    return std::strcmp(name, other.name) < 0;
+}
+
+void GpuProfiler::push(const char* name, int index) {
+    if (!inFrame) {
+        return;
+    }
+    Frame& frame = frames[current];
+    Scope scope;
+    scope.name = name;
+    scope.index = index;
+    scope.parent = stack.empty() ? -1 : static_cast<int>(stack.back());
+    scope.depth = static_cast<int>(stack.size());
+    scope.startQuery = allocateQuery(frame);
+    scope.endQuery = scope.startQuery;
+    glQueryCounter(frame.queries[scope.startQuery], GL_TIMESTAMP);
+    stack.push_back(frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::pop() {
+    if (!inFrame || stack.empty()) {
+        return;
+    }
+    Frame& frame = frames[current];
+    Scope& scope = frame.scopes[stack.back()];
+    stack.pop_back();
+    scope.endQuery = allocateQuery(frame);
+    glQueryCounter(frame.queries[scope.endQuery], GL_TIMESTAMP);
+}
+
+size_t GpuProfiler::allocateQuery(Frame& frame) {
+    if (frame.queriesUsed == frame.queries.size()) {
+        // 一次多分配一些，减少帧内的分配次数
+        size_t grow = std::max<size_t>(frame.queries.size(), 32);
+        frame.queries.resize(frame.queries.size() + grow);
+        glGenQueries(static_cast<GLsizei>(grow), frame.queries.data() + frame.queries.size() - grow);
+    }
+    return frame.queriesUsed++;
+}
+
+bool GpuProfiler::collect(Frame& frame) {
+    if (frame.scopes.empty()) {
+        return true;
+    }
+
+    // 根作用域的结束查询最后写入，它完成时其余查询都已完成
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.scopes.front().endQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+
+    timestamps.resize(frame.queriesUsed);
+    for (size_t i = 0; i < frame.queriesUsed; ++i) {
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    GLuint64 frameStart = timestamps[frame.scopes.front().startQuery];
+    bool capturing = captureRemaining > 0;
+    // 结果数组和其中的字符串复用上一帧的容量
+    lastResults.resize(frame.scopes.size());
+    frameSamples.assign(history.size(), 0.0f);
+    scopeEntries.resize(frame.scopes.size());
+    for (size_t i = 0; i < frame.scopes.size(); ++i) {
+        const Scope& scope = frame.scopes[i];
+        GLuint64 start = timestamps[scope.startQuery];
+        GLuint64 end = std::max(timestamps[scope.endQuery], start);
+        double startMs = static_cast<double>(start - frameStart) / 1.0e6;
+        double durationMs = static_cast<double>(end - start) / 1.0e6;
+
+        size_t entry = findHistory(frame, i);
+        scopeEntries[i] = entry;
+        ScopeResult& result = lastResults[i];
+        result.name = history[entry].name;
+        result.depth = scope.depth;
+        result.startMs = startMs;
+        result.durationMs = durationMs;
+
+        // 同一路径在一帧中出现多次（例如多次调用）时累加
+        frameSamples[entry] += static_cast<float>(durationMs);
+
+        if (capturing) {
+            traceEvents.push_back({ history[entry].name, scope.depth, start, end - start });
+        }
+    }
+
+    // 本帧没有出现的作用域记为 0，曲线保持对齐
+    for (size_t i = 0; i < history.size(); ++i) {
+        ScopeHistory& entry = history[i];
+        entry.samples[entry.head] = frameSamples[i];
+        entry.head = (entry.head + 1) % HISTORY;
+        entry.count = std::min(entry.count + 1, HISTORY);
+        entry.lastMs = frameSamples[i];
+        ++entry.absentFrames;
+        float sum = 0.0f;
+        for (float sample : entry.samples) {
+            sum += sample;
+        }
+        entry.averageMs = sum / entry.count;
+    }
+    for (size_t entry : scopeEntries) {
+        history[entry].absentFrames = 0;
+    }
+    pruneHistory();
+
+    ++collectedFrames;
+    if (capturing) {
+        ++capturedFrames;
+        if (--captureRemaining == 0) {
+            std::cout << "GPU profiler captured " << capturedFrames << " frames." << std::endl;
+        }
+    }
+    return true;
+}
+
+size_t GpuProfiler::findHistory(const Frame& frame, size_t scopeIndex) {
+    const Scope& scope = frame.scopes[scopeIndex];
+    // 父作用域先于子作用域写入，它的条目已经确定
+    const ScopeHistory* parent = scope.parent < 0 ? nullptr : &history[scopeEntries[scope.parent]];
+    ScopeKey key = { scope.parent < 0 ? 0u : historyIds[scopeEntries[scope.parent]], scope.name, scope.index };
+    auto it = historyIndex.find(key);
+    if (it != historyIndex.end()) {
+        return it->second;
+    }
+
+    ScopeHistory entry = {};
+    entry.name = scope.index < 0 ? std::string(scope.name) : std::string(scope.name) + " " + std::to_string(scope.index);
+    entry.path = parent ? parent->path + "/" + entry.name : entry.name;
+    entry.depth = scope.depth;
+    history.push_back(entry);
+    historyKeys.push_back(key);
+    historyIds.push_back(nextHistoryId++);
+    frameSamples.push_back(0.0f);
+    historyIndex.emplace(key, history.size() - 1);
+    return history.size() - 1;
+}
+
+void GpuProfiler::pruneHistory() {
+    // 子作用域只在父作用域内出现，两者同时或子先满足条件，不会留下找不到父条目的子条目
+    bool removed = false;
+    for (size_t i = history.size(); i-- > 0;) {
+        if (history[i].absentFrames >= HISTORY) {
+            history.erase(history.begin() + i);
+            historyKeys.erase(historyKeys.begin() + i);
+            historyIds.erase(historyIds.begin() + i);
+            removed = true;
+        }
+    }
+    if (!removed) {
+        return;
+    }
+    historyIndex.clear();
+    for (size_t i = 0; i < history.size(); ++i) {
+        historyIndex.emplace(historyKeys[i], i);
+    }
+}
+
+void GpuProfiler::startCapture(int frameCount) {
+    traceEvents.clear();
+    capturedFrames = 0;
+    captureRemaining = std::max(frameCount, 0);
+}
+
+bool GpuProfiler::exportTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open GPU trace file: " << path << std::endl;
+        return false;
+    }
+
+    // Chrome trace 的时间单位为微秒；以第一帧开始为 0
+    uint64_t origin = traceEvents.empty() ? 0 : traceEvents.front().startNs;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+    for (const TraceEvent& event : traceEvents) {
+        file << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << static_cast<double>(event.startNs - origin) / 1000.0
+            << ",\"dur\":" << static_cast<double>(event.durationNs) / 1000.0
+            << ",\"args\":{\"depth\":" << event.depth << "}}";
+    }
+    file << "\n]}\n";
+    std::cout << "GPU trace saved to " << path << " (" << traceEvents.size() << " events)" << std::endl;
+    return true;
+}
@@ -0,0 +1,157 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// GPU 分阶段计时
+// - 每个作用域在开始和结束时各写一个 GL_TIMESTAMP 查询；GL_TIME_ELAPSED 不能嵌套，
+//   时间戳可以表示"阴影 / 每个光源"这样的层级；界面上各阶段的耗时和动态分辨率都取自这里的结果
+// - 查询按帧分成 FRAME_LATENCY 组轮流使用，beginFrame 读取最旧一组的结果；
+//   结果还没有准备好时丢弃该帧而不是等待，不会造成流水线停顿
+// - 每个作用域保留最近 HISTORY 帧的耗时用于界面曲线，连续 HISTORY 帧没有出现的作用域（例如已删除的光源）会被移除；
+//   录制期间的结果可导出为 Chrome trace（chrome://tracing）
+// - 作用域名必须是字符串字面量等静态字符串，可附带一个下标（例如光源序号）；
+//   只有第一次出现时才拼接显示名和路径，之后每帧记录和读取都不分配字符串
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY = 3;
+    static constexpr int HISTORY = 120;
+
+    // 一帧中的一个作用域，时间相对于帧开始
+    struct ScopeResult {
+        std::string name;
+        int depth;
+        double startMs;
+        double durationMs;
+    };
+
+    // 按路径（父作用域名/名字）汇总的历史，顺序为首次出现的顺序
+    struct ScopeHistory {
+        std::string path;
+        std::string name;
+        int depth;
+        float samples[HISTORY];
+        int head;               // 下一个写入位置，即最旧的样本
+        int count;              // 已写入的样本数（不超过 HISTORY）
+        float lastMs;
+        float averageMs;
+        int absentFrames;       // 连续没有出现的帧数
+    };
+
+    static GpuProfiler& instance();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    void setEnabled(bool value) { enabled = value; }
+    bool isEnabled() const { return enabled; }
+
+    // 每帧开始和结束时调用，整帧作为根作用域 "Frame"
+    void beginFrame();
+    void endFrame();
+
+    // 嵌套的作用域；不在帧内或未启用时忽略。index >= 0 时显示为 "name index"
+    void push(const char* name, int index = -1);
+    void pop();
+
+    const std::vector<ScopeResult>& getLastResults() const { return lastResults; }
+    const std::vector<ScopeHistory>& getHistory() const { return history; }
+    // 按路径（例如 "Frame/Shadows"）取最近一次读取到的耗时，没有该作用域时返回 0
+    float getLastMs(const char* path) const;
+    size_t getDroppedFrames() const { return droppedFrames; }
+    // 成功读取的帧数；读取与丢弃按提交顺序进行，基准测试据此把 getHistory() 的 lastMs 对应到具体帧
+    size_t getCollectedFrames() const { return collectedFrames; }
+
+    // 等待 GPU 并读取最旧一组未读取的结果，没有未读取的帧时返回 false；
+    // 用于基准测试开始前和结束时清空队列，渲染循环中不要调用
+    bool collectPending();
+
+    // 录制接下来 frameCount 帧的结果，完成后可导出
+    void startCapture(int frameCount);
+    bool isCapturing() const { return captureRemaining > 0; }
+    size_t getCapturedFrames() const { return capturedFrames; }
+    bool exportTrace(const std::string& path) const;
+
+private:
+    // 查询对象随上下文一起释放，单例析构时上下文已经销毁
+    GpuProfiler() = default;
+
+    struct Scope {
+        const char* name;
+        int index;
+        int parent;             // 父作用域在 scopes 中的下标，根为 -1
+        int depth;
+        size_t startQuery;
+        size_t endQuery;
+    };
+
+    // 历史条目的键：父条目的 id + 名字 + 下标；id 在移除条目后保持不变
+    struct ScopeKey {
+        uint32_t parentId;
+        const char* name;
+        int index;
+        bool operator<(const ScopeKey& other) const;
+    };
+
+    struct Frame {
+        std::vector<GLuint> queries;    // 按需增长，之后各帧复用
+        size_t queriesUsed = 0;
+        std::vector<Scope> scopes;
+        bool pending = false;
+    };
+
+    // 导出用的原始事件，时间为 GPU 时间戳（纳秒）
+    struct TraceEvent {
+        std::string name;
+        int depth;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    bool enabled = true;
+    bool inFrame = false;
+    Frame frames[FRAME_LATENCY];
+    int current = 0;
+    std::vector<size_t> stack;          // 当前打开的作用域在 scopes 中的下标
+
+    std::vector<ScopeResult> lastResults;
+    std::vector<ScopeHistory> history;
+    std::vector<ScopeKey> historyKeys;          // 与 history 一一对应
+    std::vector<uint32_t> historyIds;
+    std::map<ScopeKey, size_t> historyIndex;
+    uint32_t nextHistoryId = 1;                 // 0 表示没有父条目
+
+    // collect 中复用的临时数组
+    std::vector<GLuint64> timestamps;
+    std::vector<float> frameSamples;
+    std::vector<size_t> scopeEntries;
+    size_t droppedFrames = 0;
+    size_t collectedFrames = 0;
+
+    int captureRemaining = 0;
+    size_t capturedFrames = 0;
+    std::vector<TraceEvent> traceEvents;
+
+    size_t allocateQuery(Frame& frame);
+    size_t findHistory(const Frame& frame, size_t scope);
+    void pruneHistory();
+
+    // 读取一组查询的结果；返回 false 表示还没有完成
+    bool collect(Frame& frame);
+};
+
+// 作用域内的 GPU 计时
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name, int index = -1) { GpuProfiler::instance().push(name, index); }
+    ~GpuProfileScope() { GpuProfiler::instance().pop(); }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+#endif // GPU_PROFILER_H
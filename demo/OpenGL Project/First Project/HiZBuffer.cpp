@@ -0,0 +1,128 @@
+#include "HiZBuffer.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+HiZBuffer::HiZBuffer(unsigned int width, unsigned int height)
+    : width(width), height(height), levelCount(0), depthFBO(0), depthTex(0), pyramidTex(0),
+    viewProjection(1.0f), valid(false) {
+}
+
+HiZBuffer::~HiZBuffer() {
+    releaseTextures();
+    if (buildShader) GL_STATE.deleteProgram(buildShader->ID);
+}
+
+bool HiZBuffer::initialize() {
+    buildShader = std::make_unique<Shader>("./shaders/hiz_build.comp");
+    return createTextures();
+}
+
+bool HiZBuffer::resize(unsigned int newWidth, unsigned int newHeight) {
+    if (newWidth == 0 || newHeight == 0 || (newWidth == width && newHeight == height))
+        return true;
+    width = newWidth;
+    height = newHeight;
+    releaseTextures();
+    return createTextures();
+}
+
+bool HiZBuffer::createTextures() {
+    valid = false;
+    levelCount = 1;
+    for (unsigned int size = std::max(width, height); size > 1; size /= 2) {
+        ++levelCount;
+    }
+
+    glGenTextures(1, &depthTex);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, depthTex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &depthFBO);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        std::cerr << "Hi-Z depth framebuffer is not complete!" << std::endl;
+    }
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // texelFetch 指定层级读取，使用最近点过滤即可
+    glGenTextures(1, &pyramidTex);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, pyramidTex);
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, 0);
+    return complete;
+}
+
+void HiZBuffer::releaseTextures() {
+    if (depthFBO) GL_STATE.deleteFramebuffers(1, &depthFBO);
+    if (depthTex) GL_STATE.deleteTextures(1, &depthTex);
+    if (pyramidTex) GL_STATE.deleteTextures(1, &pyramidTex);
+    depthFBO = depthTex = pyramidTex = 0;
+    valid = false;
+}
+
+glm::ivec2 HiZBuffer::getLevelSize(int level) const {
+    return glm::ivec2(std::max(1u, width >> level), std::max(1u, height >> level));
+}
+
+void HiZBuffer::build(GLuint sourceFBO, const glm::mat4& viewProj, unsigned int sourceWidth, unsigned int sourceHeight) {
+    GLuint previousFBO = GL_STATE.getDrawFramebuffer();
+
+    // 拷贝深度到可采样的纹理
+    GL_STATE.bindFramebuffer(GL_READ_FRAMEBUFFER, sourceFBO);
+    GL_STATE.bindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFBO);
+    glBlitFramebuffer(0, 0, sourceWidth, sourceHeight, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+
+    buildShader->use();
+    buildShader->setInt("source", 0);
+
+    // 第 0 级直接拷贝深度，之后每级由上一级取最大值
+    for (int level = 0; level < levelCount; ++level) {
+        glm::ivec2 size = getLevelSize(level);
+        if (level == 0) {
+            GL_STATE.bindTexture(0, GL_TEXTURE_2D, depthTex);
+            buildShader->setInt("sourceLevel", 0);
+            buildShader->setInt("copyDepth", 1);
+        }
+        else {
+            GL_STATE.bindTexture(0, GL_TEXTURE_2D, pyramidTex);
+            buildShader->setInt("sourceLevel", level - 1);
+            buildShader->setInt("copyDepth", 0);
+        }
+        RENDER_STATS_TEXTURE();
+        glBindImageTexture(0, pyramidTex, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+        RENDER_STATS_DISPATCH();
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, 0);
+
+    viewProjection = viewProj;
+    valid = true;
+}
+
+std::vector<std::vector<float>> HiZBuffer::readLevels() const {
+    std::vector<std::vector<float>> levels(levelCount);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, pyramidTex);
+    for (int level = 0; level < levelCount; ++level) {
+        glm::ivec2 size = getLevelSize(level);
+        levels[level].resize(static_cast<size_t>(size.x) * size.y);
+        glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, levels[level].data());
+    }
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, 0);
+    return levels;
+}
@@ -0,0 +1,59 @@
+#ifndef HIZ_BUFFER_H
+#define HIZ_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "shader.h"
+
+// 深度金字塔（Hi-Z），供 GPU 遮挡剔除使用
+// - 每帧场景绘制后从目标帧缓冲拷贝深度，逐级取 2x2 最大值生成 R32F mip 链
+// - 奇数尺寸时最后一行/列额外并入，任一级的纹素都保守覆盖其下所有纹素
+// - 下一帧用保存的 viewProjection 把包围盒投影到这一帧的深度上做测试
+class HiZBuffer {
+public:
+    HiZBuffer(unsigned int width, unsigned int height);
+    ~HiZBuffer();
+
+    HiZBuffer(const HiZBuffer&) = delete;
+    HiZBuffer& operator=(const HiZBuffer&) = delete;
+
+    // 初始化资源
+    bool initialize();
+
+    // 窗口尺寸变化时重建，旧内容作废
+    bool resize(unsigned int width, unsigned int height);
+
+    // 从 sourceFBO 左下角 sourceWidth x sourceHeight 的区域拷贝深度并生成金字塔，记录生成时的 viewProjection；
+    // 动态分辨率下区域小于金字塔，拷贝时最近点放大，金字塔始终覆盖整个视口
+    void build(GLuint sourceFBO, const glm::mat4& viewProjection, unsigned int sourceWidth, unsigned int sourceHeight);
+
+    // 读回所有层级（用于与 CPU 剔除结果对比）
+    std::vector<std::vector<float>> readLevels() const;
+
+    bool isValid() const { return valid; }
+    GLuint getTexture() const { return pyramidTex; }
+    int getLevelCount() const { return levelCount; }
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    const glm::mat4& getViewProjection() const { return viewProjection; }
+
+    // 第 level 级的尺寸
+    glm::ivec2 getLevelSize(int level) const;
+
+private:
+    unsigned int width, height;
+    int levelCount;
+    GLuint depthFBO;     // 深度拷贝目标
+    GLuint depthTex;     // DEPTH24_STENCIL8，与 G-buffer、后处理 FBO 一致，便于 blit
+    GLuint pyramidTex;   // R32F mip 链
+    std::unique_ptr<Shader> buildShader;
+    glm::mat4 viewProjection;
+    bool valid;
+
+    bool createTextures();
+    void releaseTextures();
+};
+
+#endif // HIZ_BUFFER_H
@@ -3,7 +3,8 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <string>
+#include <array>
+#include <cstdint>
 
 enum class LightType {
     Directional,
@@ -11,43 +12,24 @@ enum class LightType {
     Spot
 };
 
-class Light {
-public:
-    virtual ~Light() = default;
+// 光源句柄：slot 指向 LightStorage 的间接表，generation 用于识别已被删除的光源
+struct LightHandle {
+    static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
 
-    // 获取光源类型
-    virtual LightType getType() const = 0;
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
 
-    // 获取光源的投影矩阵
-    virtual glm::mat4 getProjectionMatrix() const = 0;
-
-    // 获取光源的视图矩阵
-    virtual glm::mat4 getViewMatrix() const = 0;
-
-    // 获取光源位置
-    virtual glm::vec3 getPosition() const = 0;
-
-    // 获取光源方向
-    virtual glm::vec3 getDirection() const = 0;
-
-    // 获取光源颜色
-    virtual glm::vec3 getColor() const { return glm::vec3(1.0f); }
+    bool isValid() const { return slot != INVALID_SLOT; }
+    bool operator==(const LightHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const LightHandle& other) const { return !(*this == other); }
+};
 
-    // 获取光源强度
-    virtual float getIntensity() const { return 1.0f; }
+// 以下光源类型都是普通的值类型，用于创建和编辑光源；
+// 存入 LightStorage 后按类型拆分为 SoA 数组，不再使用虚函数
 
-    // 设置光源属性
-    virtual void setPosition(const glm::vec3& position) { throw std::runtime_error("This light type does not support setting position!"); }
-    
-    virtual void setDirection(const glm::vec3& direction) { throw std::runtime_error("This light type does not support setting direction!"); }
-    
-    virtual void setColor(const glm::vec3& color) { throw std::runtime_error("This light type does not support setting color!"); }
-    
-    virtual void setIntensity(float intensity) { throw std::runtime_error("This light type does not support setting intensity!"); }
-};
+struct DirectionalLight {
+    static constexpr LightType type = LightType::Directional;
 
-class DirectionalLight : public Light {
-private:
     glm::vec3 direction;  // 光源方向
     glm::vec3 color;      // 光源颜色
     float intensity;      // 光源强度
@@ -55,19 +37,16 @@ private:
     float nearPlane, farPlane; // 投影的裁剪面
     float shadowBias = 0.005f;
 
-public:
     DirectionalLight(glm::vec3 dir, glm::vec3 col = glm::vec3(1.0f), float intensity = 1.0f,
                      float size = 64.0f, float nearP = 1.0f, float farP = 100.0f)
         : direction(glm::normalize(dir)), color(col), intensity(intensity),
           orthoSize(size), nearPlane(nearP), farPlane(farP) {}
 
-    LightType getType() const override { return LightType::Directional; }
-
-    glm::mat4 getProjectionMatrix() const override {
+    glm::mat4 getProjectionMatrix() const {
         return glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, nearPlane, farPlane);
     }
 
-    glm::mat4 getViewMatrix() const override{
+    glm::mat4 getViewMatrix() const {
         glm::vec3 lightTarget = glm::vec3(0.0f, 0.0f, 0.0f);
         glm::vec3 lightPos = getPosition();
         glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -76,154 +55,67 @@ public:
         return glm::lookAt(lightPos, lightTarget, up);
     }
 
-    glm::vec3 getPosition() const override { return -40.0f * direction; }
-
-    glm::vec3 getDirection() const override { return direction; }
-
-    glm::vec3 getColor() const override { return color; }
-
-    float getIntensity() const override { return intensity; }
-
-    void setDirection(const glm::vec3& newDirection) override {
-        direction = glm::normalize(newDirection);
-    }
-
-    void setColor(const glm::vec3& newColor) override {
-        color = newColor;
-    }
-
-    void setIntensity(float newIntensity) override {
-        intensity = newIntensity;
-    }
-
-    void setOrthoSize(float size) {
-        orthoSize = size;
-    }
-    
-    void setShadowBias(float bias) {
-        shadowBias = bias;
-    }
+    glm::vec3 getPosition() const { return -40.0f * direction; }
 };
 
-class PointLight : public Light {
-private:
+struct PointLight {
+    static constexpr LightType type = LightType::Point;
+
     glm::vec3 position;  // 光源位置
     glm::vec3 color;     // 光源颜色
     float intensity;     // 光源强度
     float nearPlane, farPlane; // 投影的裁剪面
+    float range = 30.0f; // 影响半径，超出后光照衰减为 0（用于分簇）
 
-public:
     PointLight(glm::vec3 pos, glm::vec3 col = glm::vec3(1.0f), float intensity = 1.0f,
                float nearP = 1.0f, float farP = 100.0f)
         : position(pos), color(col), intensity(intensity),
           nearPlane(nearP), farPlane(farP) {}
 
-    LightType getType() const override { return LightType::Point; }
-
-    glm::mat4 getProjectionMatrix() const override {
+    glm::mat4 getProjectionMatrix() const {
         return glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
     }
 
-    std::vector<glm::mat4> getViewMatrices() const{
-        std::vector<glm::mat4> views;
-        views.push_back(glm::lookAt(position, position + glm::vec3(1, 0, 0), glm::vec3(0, -1, 0)));  // +X
-        views.push_back(glm::lookAt(position, position + glm::vec3(-1, 0, 0), glm::vec3(0, -1, 0))); // -X
-        views.push_back(glm::lookAt(position, position + glm::vec3(0, 1, 0), glm::vec3(0, 0, 1)));   // +Y
-        views.push_back(glm::lookAt(position, position + glm::vec3(0, -1, 0), glm::vec3(0, 0, -1))); // -Y
-        views.push_back(glm::lookAt(position, position + glm::vec3(0, 0, 1), glm::vec3(0, -1, 0)));  // +Z
-        views.push_back(glm::lookAt(position, position + glm::vec3(0, 0, -1), glm::vec3(0, -1, 0))); // -Z
-        return views;
-    }
-
-    glm::mat4 getViewMatrix() const override {
-    throw std::runtime_error("PointLight does not have a single view matrix!");
-    }
-
-    glm::vec3 getPosition() const override { return position; }
-
-    glm::vec3 getDirection() const override {
-        throw std::runtime_error("PointLight does not have a single direction!");
-    }
-
-    glm::vec3 getColor() const override { return color; }
-
-    float getFarPlane() const { return farPlane; }
-
-    float getNearPlane() const { return nearPlane; }
-
-    float getIntensity() const override { return intensity; }
-
-    void setPosition(const glm::vec3& newPosition) override {
-        position = newPosition;
-    }
-
-    void setColor(const glm::vec3& newColor) override {
-        color = newColor;
-    }
-
-    void setIntensity(float newIntensity) override {
-        intensity = newIntensity;
+    // 立方体 6 个面的视图矩阵，顺序为 +X, -X, +Y, -Y, +Z, -Z
+    std::array<glm::mat4, 6> getViewMatrices() const {
+        return {
+            glm::lookAt(position, position + glm::vec3(1, 0, 0), glm::vec3(0, -1, 0)),  // +X
+            glm::lookAt(position, position + glm::vec3(-1, 0, 0), glm::vec3(0, -1, 0)), // -X
+            glm::lookAt(position, position + glm::vec3(0, 1, 0), glm::vec3(0, 0, 1)),   // +Y
+            glm::lookAt(position, position + glm::vec3(0, -1, 0), glm::vec3(0, 0, -1)), // -Y
+            glm::lookAt(position, position + glm::vec3(0, 0, 1), glm::vec3(0, -1, 0)),  // +Z
+            glm::lookAt(position, position + glm::vec3(0, 0, -1), glm::vec3(0, -1, 0))  // -Z
+        };
     }
 };
 
-class SpotLight : public Light {
-private:
+struct SpotLight {
+    static constexpr LightType type = LightType::Spot;
+
     glm::vec3 position;  // 光源位置
     glm::vec3 direction; // 光源方向
     glm::vec3 color;     // 光源颜色
     float intensity;     // 光源强度
     float cutoffAngle;   // 聚光锥的角度（FOV）
     float nearPlane, farPlane; // 投影的裁剪面
+    float range;         // 影响距离，默认与远裁剪面相同（用于分簇）
 
-public:
     SpotLight(glm::vec3 pos, glm::vec3 dir, glm::vec3 col = glm::vec3(1.0f), float intensity = 1.0f,
               float cutoff = 45.0f, float nearP = 1.0f, float farP = 100.0f)
         : position(pos), direction(glm::normalize(dir)), color(col), intensity(intensity),
-          cutoffAngle(cutoff), nearPlane(nearP), farPlane(farP) {}
+          cutoffAngle(cutoff), nearPlane(nearP), farPlane(farP), range(farP) {}
 
-    LightType getType() const override { return LightType::Spot; }
-
-    glm::mat4 getProjectionMatrix() const override {
+    glm::mat4 getProjectionMatrix() const {
         return glm::perspective(glm::radians(cutoffAngle * 2.0f), 1.0f, nearPlane, farPlane);
     }
 
-    glm::mat4 getViewMatrix() const override {
+    glm::mat4 getViewMatrix() const {
         glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
         if (glm::abs(glm::dot(direction, up)) > 0.99f){
             up = glm::vec3(1.0f, 0.0f, 0.0f); // 避免方向与 up 矢量平行
         }
         return glm::lookAt(position, position + direction, up);
     }
-
-    glm::vec3 getPosition() const override { return position; }
-
-    glm::vec3 getDirection() const override { return direction; }
-
-    glm::vec3 getColor() const override { return color; }
-
-    float getIntensity() const override { return intensity; }
-
-    float getCutoffAngle() const { return cutoffAngle; }
-
-    void setPosition(const glm::vec3& newPosition) override {
-        position = newPosition;
-    }
-
-    void setDirection(const glm::vec3& newDirection) override {
-        direction = glm::normalize(newDirection);
-    }
-
-    void setColor(const glm::vec3& newColor) override {
-        color = newColor;
-    }
-
-    void setIntensity(float newIntensity) override {
-        intensity = newIntensity;
-    }
-
-    void setCutoffAngle(float newcutoffAngle) {
-        cutoffAngle = newcutoffAngle;
-    }
 };
 
-#endif // LIGHT_H
\ No newline at end of file
+#endif // LIGHT_H
@@ -0,0 +1,270 @@
+#include "LightBinning.h"
+#include "CpuProfiler.h"
+#include "CpuWorkers.h"
+
+#include <algorithm>
+#include <cmath>
+
+LightBinning::LightBinning()
+    : workerCount(defaultCpuWorkerCount())
+{
+}
+
+void LightBinning::configure(int newTilesX, int newTilesY, int newSlicesZ, float newFovY, float newAspect, float newNear, float newFar)
+{
+    if (newTilesX == tilesX && newTilesY == tilesY && newSlicesZ == slicesZ &&
+        newFovY == fovY && newAspect == aspect && newNear == nearPlane && newFar == farPlane && !minX.empty())
+        return;
+
+    tilesX = std::max(newTilesX, 1);
+    tilesY = std::max(newTilesY, 1);
+    slicesZ = std::max(newSlicesZ, 1);
+    fovY = newFovY;
+    aspect = newAspect;
+    nearPlane = newNear;
+    farPlane = newFar;
+    buildClusterBounds();
+}
+
+int LightBinning::getSlice(float viewDepth) const
+{
+    if (viewDepth <= nearPlane)
+        return 0;
+    float slice = std::log(viewDepth / nearPlane) / std::log(farPlane / nearPlane) * slicesZ;
+    return std::min(static_cast<int>(slice), slicesZ - 1);
+}
+
+float LightBinning::getSliceDepth(int z) const
+{
+    return nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / slicesZ);
+}
+
+glm::vec2 LightBinning::getDepthSliceParams() const
+{
+    float logRatio = std::log(farPlane / nearPlane);
+    return glm::vec2(slicesZ / logRatio, -slicesZ * std::log(nearPlane) / logRatio);
+}
+
+void LightBinning::getClusterBounds(int cluster, glm::vec3& aabbMin, glm::vec3& aabbMax) const
+{
+    int tilesPerSlice = tilesX * tilesY;
+    int c = cluster % tilesPerSlice + cluster / tilesPerSlice * sliceStride;
+    aabbMin = glm::vec3(minX[c], minY[c], minZ[c]);
+    aabbMax = glm::vec3(maxX[c], maxY[c], maxZ[c]);
+}
+
+// 计算每个簇的视空间包围盒：取 tile 四条边界射线在切片近/远端的 8 个交点
+void LightBinning::buildClusterBounds()
+{
+    // 补齐部分放到极远处，任何光源都不会与之相交
+    sliceStride = (tilesX * tilesY + 3) / 4 * 4;
+    size_t padded = static_cast<size_t>(sliceStride) * slicesZ;
+    for (auto* v : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ, &centerX, &centerY, &centerZ })
+        v->assign(padded, 1e30f);
+    radius.assign(padded, 0.0f);
+
+    float tanY = std::tan(fovY * 0.5f);
+    float tanX = tanY * aspect;
+
+    for (int z = 0; z < slicesZ; ++z)
+    {
+        float depths[2] = { getSliceDepth(z), getSliceDepth(z + 1) };
+        for (int y = 0; y < tilesY; ++y)
+        {
+            float ndcY0 = -1.0f + 2.0f * y / tilesY;
+            float ndcY1 = -1.0f + 2.0f * (y + 1) / tilesY;
+            for (int x = 0; x < tilesX; ++x)
+            {
+                float ndcX0 = -1.0f + 2.0f * x / tilesX;
+                float ndcX1 = -1.0f + 2.0f * (x + 1) / tilesX;
+
+                glm::vec3 lo(1e30f), hi(-1e30f);
+                for (float d : depths)
+                {
+                    for (float nx : { ndcX0, ndcX1 })
+                    {
+                        for (float ny : { ndcY0, ndcY1 })
+                        {
+                            glm::vec3 p(nx * tanX * d, ny * tanY * d, -d);
+                            lo = glm::min(lo, p);
+                            hi = glm::max(hi, p);
+                        }
+                    }
+                }
+
+                int c = x + y * tilesX + z * sliceStride;
+                minX[c] = lo.x; minY[c] = lo.y; minZ[c] = lo.z;
+                maxX[c] = hi.x; maxY[c] = hi.y; maxZ[c] = hi.z;
+                glm::vec3 center = (lo + hi) * 0.5f;
+                centerX[c] = center.x; centerY[c] = center.y; centerZ[c] = center.z;
+                radius[c] = glm::length(hi - center);
+            }
+        }
+    }
+}
+
+bool LightBinning::sphereIntersectsAABB(const glm::vec3& center, float r, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+{
+    glm::vec3 d = glm::max(glm::vec3(0.0f), glm::max(aabbMin - center, center - aabbMax));
+    return glm::dot(d, d) <= r * r;
+}
+
+// 锥体与包围盒的测试：用包围盒的包围球近似，判断球是否在锥体的角度、前后范围之外
+bool LightBinning::coneIntersectsAABB(const LightVolume& spot, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+{
+    if (!sphereIntersectsAABB(spot.position, spot.range, aabbMin, aabbMax))
+        return false;
+
+    glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+    float r = glm::length(aabbMax - center);
+    glm::vec3 v = center - spot.position;
+    float lenSq = glm::dot(v, v);
+    float v1Len = glm::dot(v, spot.direction);
+    float distClosest = spot.cosAngle * std::sqrt(std::max(lenSq - v1Len * v1Len, 0.0f)) - v1Len * spot.sinAngle;
+    bool angleCull = distClosest > r;
+    bool frontCull = v1Len > r + spot.range;
+    bool backCull = v1Len < -r;
+    return !(angleCull || frontCull || backCull);
+}
+
+unsigned int LightBinning::testFour(const LightVolume& light, int first) const
+{
+#ifdef ENGINE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 px = _mm_set1_ps(light.position.x);
+    const __m128 py = _mm_set1_ps(light.position.y);
+    const __m128 pz = _mm_set1_ps(light.position.z);
+    const __m128 range = _mm_set1_ps(light.range);
+
+    // 球与包围盒：每个轴上到盒子的距离平方和
+    __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[first]), px), _mm_sub_ps(px, _mm_loadu_ps(&maxX[first]))));
+    __m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[first]), py), _mm_sub_ps(py, _mm_loadu_ps(&maxY[first]))));
+    __m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[first]), pz), _mm_sub_ps(pz, _mm_loadu_ps(&maxZ[first]))));
+    __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 hit = _mm_cmple_ps(distSq, _mm_mul_ps(range, range));
+
+    if (light.isSpot && _mm_movemask_ps(hit) != 0)
+    {
+        // 锥体测试，使用簇的包围球
+        __m128 r = _mm_loadu_ps(&radius[first]);
+        __m128 vx = _mm_sub_ps(_mm_loadu_ps(&centerX[first]), px);
+        __m128 vy = _mm_sub_ps(_mm_loadu_ps(&centerY[first]), py);
+        __m128 vz = _mm_sub_ps(_mm_loadu_ps(&centerZ[first]), pz);
+        __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 v1Len = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(vx, _mm_set1_ps(light.direction.x)),
+            _mm_mul_ps(vy, _mm_set1_ps(light.direction.y))),
+            _mm_mul_ps(vz, _mm_set1_ps(light.direction.z)));
+        __m128 perp = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(lenSq, _mm_mul_ps(v1Len, v1Len))));
+        __m128 distClosest = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(light.cosAngle), perp), _mm_mul_ps(v1Len, _mm_set1_ps(light.sinAngle)));
+        __m128 angleCull = _mm_cmpgt_ps(distClosest, r);
+        __m128 frontCull = _mm_cmpgt_ps(v1Len, _mm_add_ps(r, range));
+        __m128 backCull = _mm_cmplt_ps(v1Len, _mm_sub_ps(zero, r));
+        __m128 culled = _mm_or_ps(angleCull, _mm_or_ps(frontCull, backCull));
+        hit = _mm_andnot_ps(culled, hit);
+    }
+    return static_cast<unsigned int>(_mm_movemask_ps(hit));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        int c = first + i;
+        glm::vec3 lo(minX[c], minY[c], minZ[c]);
+        glm::vec3 hi(maxX[c], maxY[c], maxZ[c]);
+        bool hit = light.isSpot ? coneIntersectsAABB(light, lo, hi) : sphereIntersectsAABB(light.position, light.range, lo, hi);
+        if (hit)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+void LightBinning::binSlices(const std::vector<LightVolume>& lights, int sliceBegin, int sliceEnd, WorkerOutput& out) const
+{
+    CPU_PROFILE_SCOPE("LightBinning::binSlices");
+    const int tilesPerSlice = tilesX * tilesY;
+    out.clusters.assign(static_cast<size_t>(sliceEnd - sliceBegin) * tilesPerSlice, glm::uvec2(0));
+    out.indices.clear();
+    out.tileLists.resize(tilesPerSlice);
+
+    std::vector<size_t> candidates;
+    candidates.reserve(lights.size());
+
+    for (int z = sliceBegin; z < sliceEnd; ++z)
+    {
+        // 只测试深度范围覆盖该切片的光源
+        candidates.clear();
+        for (size_t i = 0; i < lights.size(); ++i)
+        {
+            if (lightSlices[i].x <= z && z <= lightSlices[i].y)
+                candidates.push_back(i);
+        }
+
+        for (auto& list : out.tileLists)
+            list.clear();
+
+        int sliceFirst = z * sliceStride;
+        for (size_t li : candidates)
+        {
+            const LightVolume& light = lights[li];
+            for (int t = 0; t < tilesPerSlice; t += 4)
+            {
+                unsigned int mask = testFour(light, sliceFirst + t);
+                while (mask != 0)
+                {
+                    int lane = 0;
+                    while (!(mask & (1u << lane)))
+                        ++lane;
+                    mask &= ~(1u << lane);
+                    if (t + lane < tilesPerSlice) // 补齐的簇
+                        out.tileLists[t + lane].push_back(light.lightIndex);
+                }
+            }
+        }
+
+        for (int t = 0; t < tilesPerSlice; ++t)
+        {
+            const auto& list = out.tileLists[t];
+            out.clusters[static_cast<size_t>(z - sliceBegin) * tilesPerSlice + t] =
+                glm::uvec2(static_cast<uint32_t>(out.indices.size()), static_cast<uint32_t>(list.size()));
+            out.indices.insert(out.indices.end(), list.begin(), list.end());
+        }
+    }
+}
+
+void LightBinning::bin(const std::vector<LightVolume>& lights)
+{
+    if (minX.empty())
+        buildClusterBounds();
+
+    // 每个光源在深度方向覆盖的切片范围（视空间 z 为负）
+    lightSlices.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        float centerDepth = -lights[i].position.z;
+        float nearDepth = centerDepth - lights[i].range;
+        float farDepth = centerDepth + lights[i].range;
+        if (farDepth < nearPlane || nearDepth > farPlane)
+            lightSlices[i] = glm::ivec2(1, 0); // 完全在视锥深度范围之外
+        else
+            lightSlices[i] = glm::ivec2(getSlice(nearDepth), getSlice(farDepth));
+    }
+
+    // 光源很少时多线程的开销大于收益
+    int workers = lights.size() < 128 ? 1 : std::min(workerCount, slicesZ);
+    workerOutputs.resize(workers);
+    runOnWorkers(workers, slicesZ, [this, &lights](int worker, int begin, int end) {
+        binSlices(lights, begin, end, workerOutputs[worker]);
+    });
+
+    // 拼接各线程的结果，修正偏移
+    clusters.clear();
+    lightIndices.clear();
+    for (const auto& out : workerOutputs)
+    {
+        uint32_t base = static_cast<uint32_t>(lightIndices.size());
+        for (const auto& c : out.clusters)
+            clusters.push_back(glm::uvec2(c.x + base, c.y));
+        lightIndices.insert(lightIndices.end(), out.indices.begin(), out.indices.end());
+    }
+}
@@ -0,0 +1,99 @@
+// LightBinning.h
+#ifndef LIGHT_BINNING_H
+#define LIGHT_BINNING_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// 分簇前向渲染的光源分配阶段：把点光源/聚光灯分到视空间 froxel 网格中
+// 纯 CPU 实现，不依赖 OpenGL，可以单独测试
+class LightBinning
+{
+public:
+    // 视空间中的光源体积（相机朝 -Z 看）
+    struct LightVolume
+    {
+        glm::vec3 position;   // 点光源球心 / 聚光灯锥顶
+        float range;          // 影响半径
+        glm::vec3 direction;  // 聚光灯方向（单位向量）
+        float cosAngle;       // 聚光灯半角的余弦
+        float sinAngle;       // 聚光灯半角的正弦
+        bool isSpot;
+        uint32_t lightIndex;  // 在光源缓冲中的下标
+    };
+
+    LightBinning();
+
+    // 设置网格尺寸与相机投影，参数变化时重建每个簇的视空间包围盒
+    void configure(int tilesX, int tilesY, int slicesZ, float fovY, float aspect, float nearPlane, float farPlane);
+
+    // 设置工作线程数（<= 1 时在调用线程中完成）
+    void setWorkerCount(int count) { workerCount = count < 1 ? 1 : count; }
+    int getWorkerCount() const { return workerCount; }
+
+    // 把光源分配到各个簇
+    void bin(const std::vector<LightVolume>& lights);
+
+    // 每个簇的 (偏移, 数量)，簇下标为 x + y * tilesX + z * tilesX * tilesY
+    const std::vector<glm::uvec2>& getClusters() const { return clusters; }
+    // 所有簇的光源下标列表，按簇依次排列
+    const std::vector<uint32_t>& getLightIndices() const { return lightIndices; }
+
+    int getTilesX() const { return tilesX; }
+    int getTilesY() const { return tilesY; }
+    int getSlicesZ() const { return slicesZ; }
+    int getClusterCount() const { return tilesX * tilesY * slicesZ; }
+
+    // 视距（正值）所在的 z 切片
+    int getSlice(float viewDepth) const;
+    // 第 z 个切片的近端视距
+    float getSliceDepth(int z) const;
+    // 着色器中由视距求切片的参数：slice = log(视距) * x + y
+    glm::vec2 getDepthSliceParams() const;
+
+    // 簇的视空间包围盒
+    void getClusterBounds(int cluster, glm::vec3& aabbMin, glm::vec3& aabbMax) const;
+
+    // 单个相交测试（标量版本，SIMD 路径的参考实现）
+    static bool sphereIntersectsAABB(const glm::vec3& center, float radius, const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+    static bool coneIntersectsAABB(const LightVolume& spot, const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+
+private:
+    int tilesX = 16;
+    int tilesY = 9;
+    int slicesZ = 24;
+    float fovY = 0.0f;
+    float aspect = 0.0f;
+    float nearPlane = 0.0f;
+    float farPlane = 0.0f;
+    int workerCount = 1;
+
+    // 每个簇的包围盒及其包围球，按分量分开存储（SoA）
+    // 每个切片的长度补齐到 4 的倍数（sliceStride），按 4 个一组读取时不会越过切片或数组末尾
+    int sliceStride = 0;
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    std::vector<float> centerX, centerY, centerZ, radius;
+
+    std::vector<glm::uvec2> clusters;
+    std::vector<uint32_t> lightIndices;
+
+    // 每个工作线程负责一段连续的切片，结果最后拼接
+    struct WorkerOutput
+    {
+        std::vector<glm::uvec2> clusters;
+        std::vector<uint32_t> indices;
+        std::vector<std::vector<uint32_t>> tileLists; // 单个切片内每个簇的临时列表
+    };
+    std::vector<WorkerOutput> workerOutputs;
+
+    // 每个光源覆盖的切片范围
+    std::vector<glm::ivec2> lightSlices;
+
+    void buildClusterBounds();
+    void binSlices(const std::vector<LightVolume>& lights, int sliceBegin, int sliceEnd, WorkerOutput& out) const;
+    // 测试一个光源与 SoA 数组中从 first 开始的 4 个簇，返回相交簇的位掩码
+    unsigned int testFour(const LightVolume& light, int first) const;
+};
+
+#endif // LIGHT_BINNING_H
@@ -2,196 +2,469 @@
 #define LIGHT_MANAGER_H
 
 #include <vector>
-#include <memory>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
 #include <nlohmann/json.hpp>
 #include "Light.h"
+#include "LightStorage.h"
+#include "LightBinning.h"
+#include "RenderStats.h"
 #include "shader.h"
 
 class LightManager {
 private:
-    std::vector<std::shared_ptr<Light>> lights; // 存储光源
-    unsigned int ubo;                           // UBO ID
+    LightStorage storage;                       // 按类型分组的光源数据
     unsigned int maxLights;                     // 最大支持的光源数
+    LightHandle cameraLight;                    // 跟随相机的聚光灯
 
+    // 着色器中的光源结构（std430），与 Model Shader.fs 中的 LightData 对应
     struct LightData {
-        alignas(16) glm::vec4 position;    // 光源位置 (16字节对齐)
-        alignas(16) glm::vec4 direction;   // 光源方向 (16字节对齐)
-        alignas(16) glm::vec4 color;       // 光源颜色和强度 (16字节对齐)
-        alignas(16) glm::vec4 params;      // 额外参数 (16字节对齐)
+        glm::vec4 position;    // 光源位置
+        glm::vec4 direction;   // 光源方向
+        glm::vec4 color;       // 光源颜色和强度
+        glm::vec4 params;      // (cutoffAngle, type, 0, range)
     };
 
+    // 光源数组的 CPU 镜像；每项记录来源光源的版本，只有变化的项才重新填充
+    // （版本号全局唯一，增删光源导致下标上换了光源时版本也必然不同）
+    std::vector<LightData> mirror;
+    std::vector<uint64_t> mirrorVersions;
+    std::vector<uint64_t> mirrorStamps;      // 每项最近一次改写时的全局计数
+    uint64_t stampCounter = 0;
+
+    // 光源 SSBO：支持 GL 4.4 时使用持久映射的三重缓冲，每帧写入一个区域，
+    // 用 fence 保证 GPU 读完后才覆盖；否则退化为单缓冲 + glBufferSubData
+    static constexpr int LIGHT_BUFFER_REGIONS = 3;
+    unsigned int lightBuffer = 0;
+    bool persistentMapping = false;
+    LightData* mappedLights = nullptr;
+    int regionCount = 1;
+    int currentRegion = 0;
+    size_t regionSize = 0;                   // 每个区域的字节数（已按偏移对齐）
+    GLsync regionFences[LIGHT_BUFFER_REGIONS] = { nullptr, nullptr, nullptr };
+    std::vector<uint64_t> regionStamps[LIGHT_BUFFER_REGIONS]; // 每个区域中各项对应的镜像计数
+    size_t lastUploadCount = 0;              // 上一次实际写入的光源数，用于统计
+
+    // SSBO：每个簇的 (偏移, 数量)、簇的光源下标列表
+    unsigned int clusterBuffer = 0;
+    unsigned int indexBuffer = 0;
+    size_t clusterBufferSize = 0;
+    size_t indexBufferSize = 0;
+
+    // 分簇的 CPU 分配阶段
+    LightBinning binning;
+    std::vector<LightBinning::LightVolume> volumes;
+    std::vector<int> directionalLights; // 方向光不参与分簇，对每个片段都计算
+
+    // 按需增长 SSBO 并上传数据
+    static void uploadStorage(unsigned int buffer, size_t& capacity, const void* data, size_t size) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        if (size > capacity) {
+            capacity = std::max(size, capacity * 2);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+        if (size > 0) {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+            RENDER_STATS_UPLOAD(size);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // 创建光源缓冲，可用时使用持久映射
+    void createLightBuffer() {
+        GLint alignment = 16;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        regionSize = sizeof(LightData) * maxLights;
+        regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+        glGenBuffers(1, &lightBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+        if (GLAD_GL_VERSION_4_4 && glBufferStorage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, regionSize * LIGHT_BUFFER_REGIONS, nullptr, flags);
+            mappedLights = static_cast<LightData*>(
+                glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, regionSize * LIGHT_BUFFER_REGIONS, flags));
+        }
+        if (mappedLights) {
+            persistentMapping = true;
+            regionCount = LIGHT_BUFFER_REGIONS;
+        }
+        else {
+            std::cerr << "Persistent buffer mapping unavailable, light buffer uses glBufferSubData." << std::endl;
+            if (GLAD_GL_VERSION_4_4 && glBufferStorage) {
+                // 不可变存储无法再次分配，换一个新缓冲
+                glDeleteBuffers(1, &lightBuffer);
+                glGenBuffers(1, &lightBuffer);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+            }
+            glBufferData(GL_SHADER_STORAGE_BUFFER, regionSize, nullptr, GL_DYNAMIC_DRAW);
+            regionCount = 1;
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // 等待 GPU 读完该区域
+    void waitForRegion(int region) {
+        GLsync& fence = regionFences[region];
+        if (!fence) return;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // 把镜像中的一段连续光源写入当前区域
+    void writeLightRange(size_t first, size_t count) {
+        if (persistentMapping) {
+            LightData* region = reinterpret_cast<LightData*>(
+                reinterpret_cast<char*>(mappedLights) + regionSize * currentRegion);
+            std::memcpy(region + first, mirror.data() + first, count * sizeof(LightData));
+        }
+        else {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(LightData),
+                count * sizeof(LightData), mirror.data() + first);
+        }
+        RENDER_STATS_UPLOAD(count * sizeof(LightData));
+    }
+
+    // 同步 CPU 镜像，按 方向光、点光源、聚光灯 依次线性遍历各类型的数组
+    void syncMirror() {
+        size_t count = storage.size();
+        mirror.resize(count);
+        mirrorVersions.resize(count, 0);
+        mirrorStamps.resize(count, 0);
+
+        const auto& dirs = storage.directionals();
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            if (beginEntry(i, dirs.version[i])) {
+                LightData& d = mirror[i];
+                d.position = glm::vec4(0.0f);
+                d.direction = glm::vec4(dirs.direction[i], 0.0f);
+                d.color = glm::vec4(dirs.color[i], dirs.intensity[i]);
+                d.params = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+            }
+        }
+
+        const auto& points = storage.points();
+        size_t base = storage.pointBase();
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (beginEntry(base + i, points.version[i])) {
+                LightData& d = mirror[base + i];
+                d.position = glm::vec4(points.position[i], 1.0f);
+                d.direction = glm::vec4(0.0f);
+                d.color = glm::vec4(points.color[i], points.intensity[i]);
+                d.params = glm::vec4(0.0f, 1.0f, 0.0f, points.range[i]);
+            }
+        }
+
+        const auto& spots = storage.spots();
+        base = storage.spotBase();
+        for (size_t i = 0; i < spots.size(); ++i) {
+            if (beginEntry(base + i, spots.version[i])) {
+                LightData& d = mirror[base + i];
+                d.position = glm::vec4(spots.position[i], 1.0f);
+                d.direction = glm::vec4(spots.direction[i], 1.0f);
+                d.color = glm::vec4(spots.color[i], spots.intensity[i]);
+                d.params = glm::vec4(spots.cutoffAngle[i], 2.0f, 0.0f, spots.range[i]);
+            }
+        }
+    }
+
+    // 判断镜像中的一项是否需要重新填充，需要时更新其版本和计数
+    bool beginEntry(size_t index, uint64_t version) {
+        if (mirrorVersions[index] == version) {
+            return false;
+        }
+        mirrorVersions[index] = version;
+        mirrorStamps[index] = ++stampCounter;
+        return true;
+    }
+
+    // 方向光排在光源数组的最前面，下标只依赖其数量
+    void rebuildDirectionalList() {
+        size_t count = std::min<size_t>(storage.directionals().size(), MAX_DIRECTIONAL_LIGHTS);
+        if (directionalLights.size() == count) {
+            return;
+        }
+        directionalLights.clear();
+        for (size_t i = 0; i < count; ++i) {
+            directionalLights.push_back(static_cast<int>(i));
+        }
+    }
+
 public:
-    LightManager(unsigned int maxLights = 16)
+    // 分簇网格尺寸
+    static constexpr int CLUSTER_TILES_X = 16;
+    static constexpr int CLUSTER_TILES_Y = 9;
+    static constexpr int CLUSTER_SLICES_Z = 24;
+    // 着色器中方向光下标数组的长度
+    static constexpr int MAX_DIRECTIONAL_LIGHTS = 4;
+
+    LightManager(unsigned int maxLights = 1024)
         : maxLights(maxLights){
-        const size_t blockSize = 4 * sizeof(glm::vec4) * maxLights; // 4个数组，每个数组maxLights个vec4
-        // 初始化 UBO
-        glGenBuffers(1, &ubo);
-        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-        glBufferData(GL_UNIFORM_BUFFER, blockSize, nullptr, GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        // 初始化 SSBO，光源缓冲按最大数量一次分配
+        createLightBuffer();
+        glGenBuffers(1, &clusterBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // 空缓冲也需要有效的存储才能绑定
+        glm::uvec2 emptyCluster(0);
+        uint32_t emptyIndex = 0;
+        uploadStorage(clusterBuffer, clusterBufferSize, &emptyCluster, sizeof(emptyCluster));
+        uploadStorage(indexBuffer, indexBufferSize, &emptyIndex, sizeof(emptyIndex));
     }
 
     ~LightManager() {
-        glDeleteBuffers(1, &ubo);
+        for (GLsync& fence : regionFences) {
+            if (fence) glDeleteSync(fence);
+        }
+        if (mappedLights) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &lightBuffer);
+        glDeleteBuffers(1, &clusterBuffer);
+        glDeleteBuffers(1, &indexBuffer);
     }
 
-    // 添加光源
-    void addLight(std::shared_ptr<Light> light) {
-        if (lights.size() < maxLights) {
-            lights.push_back(light);
-        }
-        else {
+    // 添加光源，返回用于之后访问该光源的句柄
+    template <typename T>
+    LightHandle addLight(const T& light) {
+        if (storage.size() >= maxLights) {
             throw std::runtime_error("Maximum number of lights exceeded!");
         }
+        return storage.add(light);
     }
 
     // 移除光源
-    void removeLight(int index) {
-        if (index >= 0 && index < static_cast<int>(lights.size())) {
-            lights.erase(lights.begin() + index);
+    void removeLight(LightHandle handle) {
+        if (!storage.remove(handle)) {
+            throw std::runtime_error("Invalid light handle!");
         }
-        else {
-            throw std::runtime_error("Invalid light index!");
+        if (handle == cameraLight) {
+            cameraLight = LightHandle();
         }
     }
 
     // 获取光源数量
     size_t getLightCount() const {
-        return lights.size();
+        return storage.size();
     }
 
-    // 获取指定索引的光源
-    std::shared_ptr<Light> getLight(int index) const {
-        if (index >= 0 && index < static_cast<int>(lights.size())) {
-            return lights[index];
-        }
-        else {
-            throw std::runtime_error("Invalid light index!");
-        }
+    // 最大支持的光源数
+    unsigned int getMaxLights() const {
+        return maxLights;
     }
 
-    // 获取所有光源的引用
-    std::vector<std::shared_ptr<Light>>& getLights() {
-        return lights;
+    // 着色器下标对应的光源句柄（下标按 方向光、点光源、聚光灯 排列）
+    LightHandle getHandle(size_t index) const {
+        return storage.getHandle(index);
     }
 
-    // 获取原始光源指针列表
-    std::vector<Light*> getRawLights() const {
-        std::vector<Light*> rawLights;
-        for (const auto& light : lights) {
-            rawLights.push_back(light.get());
-        }
-        return rawLights;
+    bool isValid(LightHandle handle) const {
+        return storage.isValid(handle);
     }
 
-    // 更新 UBO 数据
-    void updateUBO() const {
-        // 为每种数据类型创建临时数组
-        std::vector<glm::vec4> positions(maxLights, glm::vec4(0.0f));
-        std::vector<glm::vec4> directions(maxLights, glm::vec4(0.0f));
-        std::vector<glm::vec4> colors(maxLights, glm::vec4(0.0f));
-        std::vector<glm::vec4> params(maxLights, glm::vec4(0.0f));
+    LightType getType(LightHandle handle) const {
+        return storage.getType(handle);
+    }
 
-        // 填充数据
-        for (size_t i = 0; i < lights.size(); ++i) {
-            const auto& light = lights[i];
+    // 按类型读取、写回光源
+    template <typename T>
+    T getLight(LightHandle handle) const {
+        return storage.get<T>(handle);
+    }
 
-            // 设置颜色和强度
-            colors[i] = glm::vec4(light->getColor(), light->getIntensity());
+    template <typename T>
+    void setLight(LightHandle handle, const T& light) {
+        storage.set(handle, light);
+    }
 
-            switch (light->getType()) {
-            case LightType::Directional: {
-                directions[i] = glm::vec4(glm::normalize(light->getDirection()), 0.0f);
-                positions[i] = glm::vec4(0.0f);
-                params[i] = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
-                break;
-            }
-            case LightType::Point: {
-                positions[i] = glm::vec4(light->getPosition(), 1.0f);
-                directions[i] = glm::vec4(0.0f);
-                params[i] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
-                break;
-            }
-            case LightType::Spot: {
-                positions[i] = glm::vec4(light->getPosition(), 1.0f);
-                directions[i] = glm::vec4(glm::normalize(light->getDirection()), 1.0f);
-                auto* spotLight = static_cast<const SpotLight*>(light.get());
-                params[i] = glm::vec4(spotLight->getCutoffAngle(), 2.0f, 0.0f, 0.0f);
-                break;
+    void setPosition(LightHandle handle, const glm::vec3& position) {
+        storage.setPosition(handle, position);
+    }
+
+    void setDirection(LightHandle handle, const glm::vec3& direction) {
+        storage.setDirection(handle, direction);
+    }
+
+    // 光源数据，供阴影等系统按类型遍历
+    const LightStorage& getStorage() const {
+        return storage;
+    }
+
+    // 跟随相机的聚光灯
+    void setCameraLight(LightHandle handle) {
+        cameraLight = handle;
+    }
+
+    LightHandle getCameraLight() const {
+        return storage.isValid(cameraLight) ? cameraLight : LightHandle();
+    }
+
+    // 指定光源的版本号，阴影缓存等系统可据此判断光源是否变化
+    uint64_t getLightVersion(size_t index) const {
+        return storage.getVersion(storage.getHandle(index));
+    }
+
+    // 更新光源 SSBO 数据：先同步变化的光源到 CPU 镜像，再只写入本区域过期的项
+    void updateLightBuffer() {
+        syncMirror();
+        rebuildDirectionalList();
+
+        // 切换到下一个区域，前一个区域在此之前提交的绘制结束后才能再写
+        if (persistentMapping) {
+            if (regionFences[currentRegion]) glDeleteSync(regionFences[currentRegion]);
+            regionFences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            currentRegion = (currentRegion + 1) % regionCount;
+            waitForRegion(currentRegion);
+        }
+
+        // 找出本区域中过期的项，连续的项合并为一次写入
+        std::vector<uint64_t>& stamps = regionStamps[currentRegion];
+        stamps.resize(mirror.size(), 0);
+        lastUploadCount = 0;
+        size_t i = 0;
+        if (!persistentMapping) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+        }
+        while (i < mirror.size()) {
+            if (stamps[i] == mirrorStamps[i]) {
+                ++i;
+                continue;
             }
+            size_t begin = i;
+            while (i < mirror.size() && stamps[i] != mirrorStamps[i]) {
+                stamps[i] = mirrorStamps[i];
+                ++i;
             }
+            writeLightRange(begin, i - begin);
+            lastUploadCount += i - begin;
+        }
+        if (!persistentMapping) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+    }
+
+    // 上一帧实际写入 GPU 的光源项数
+    size_t getLastUploadCount() const {
+        return lastUploadCount;
+    }
+
+    // 把点光源和聚光灯分配到当前相机的 froxel 网格，并上传簇数据
+    void updateClusters(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane) {
+        binning.configure(CLUSTER_TILES_X, CLUSTER_TILES_Y, CLUSTER_SLICES_Z, fovY, aspect, nearPlane, farPlane);
+
+        // 转换到视空间；方向光不参与分簇，点光源和聚光灯各自连续存放
+        const auto& points = storage.points();
+        const auto& spots = storage.spots();
+        volumes.resize(points.size() + spots.size());
+        size_t pointBase = storage.pointBase();
+        for (size_t i = 0; i < points.size(); ++i) {
+            LightBinning::LightVolume& v = volumes[i];
+            v.lightIndex = static_cast<uint32_t>(pointBase + i);
+            v.position = glm::vec3(view * glm::vec4(points.position[i], 1.0f));
+            v.range = points.range[i];
+            v.direction = glm::vec3(0.0f, 0.0f, -1.0f);
+            v.cosAngle = -1.0f;
+            v.sinAngle = 0.0f;
+            v.isSpot = false;
+        }
+        size_t spotBase = storage.spotBase();
+        for (size_t i = 0; i < spots.size(); ++i) {
+            LightBinning::LightVolume& v = volumes[points.size() + i];
+            // 着色器在 cutoff 外还有一段渐变，放宽一点角度
+            float angle = glm::radians(std::min(spots.cutoffAngle[i] + 5.0f, 89.0f));
+            v.lightIndex = static_cast<uint32_t>(spotBase + i);
+            v.position = glm::vec3(view * glm::vec4(spots.position[i], 1.0f));
+            v.range = spots.range[i];
+            v.direction = glm::normalize(glm::vec3(view * glm::vec4(spots.direction[i], 0.0f)));
+            v.cosAngle = std::cos(angle);
+            v.sinAngle = std::sin(angle);
+            v.isSpot = true;
         }
 
-        // 绑定缓冲区并更新数据
-        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        binning.bin(volumes);
+
+        const auto& clusters = binning.getClusters();
+        const auto& indices = binning.getLightIndices();
+        uploadStorage(clusterBuffer, clusterBufferSize, clusters.data(), clusters.size() * sizeof(glm::uvec2));
+        uploadStorage(indexBuffer, indexBufferSize, indices.data(), indices.size() * sizeof(uint32_t));
+    }
 
-        // 更新每个数组的数据，注意偏移量
-        size_t offset = 0;
-        const size_t arraySize = sizeof(glm::vec4) * maxLights;
+    // 绑定光源与簇的 SSBO（绑定点与着色器中的 binding 对应）
+    void bindLightBuffers() const {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, lightBuffer,
+            static_cast<GLintptr>(regionSize * currentRegion), static_cast<GLsizeiptr>(regionSize));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, clusterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indexBuffer);
+    }
 
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, arraySize, positions.data());
-        offset += arraySize;
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, arraySize, directions.data());
-        offset += arraySize;
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, arraySize, colors.data());
-        offset += arraySize;
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, arraySize, params.data());
+    // 分簇网格尺寸与方向光下标，由 Renderer 写入每帧常量缓冲
+    glm::uvec3 getClusterGrid() const {
+        return glm::uvec3(CLUSTER_TILES_X, CLUSTER_TILES_Y, CLUSTER_SLICES_Z);
+    }
 
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    const std::vector<int>& getDirectionalLights() const {
+        return directionalLights;
     }
 
-    // 绑定 UBO 到指定 Shader 的绑定点
-    void bindUBOToShader(const Shader& shader, unsigned int bindingPoint = 0) const {
-        // 获取Uniform块索引
-        unsigned int blockIndex = glGetUniformBlockIndex(shader.ID, "LightBlock");
-        if (blockIndex != GL_INVALID_INDEX) {
-            // 将Uniform块绑定到绑定点
-            glUniformBlockBinding(shader.ID, blockIndex, bindingPoint);
-            // 将UBO绑定到相同的绑定点
-            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo);
-        }
-        else {
-            std::cout << "Warning: LightBlock not found in shader program" << std::endl;
-        }
+    // 分簇结果，用于界面统计
+    const LightBinning& getBinning() const {
+        return binning;
     }
 
     // 清空光源
     void clearLights() {
-        lights.clear();
+        storage.clear();
+        cameraLight = LightHandle();
     }
 
     // 序列化光源
     nlohmann::json serialize() const {
         nlohmann::json lightsJson;
-        for (const auto& light : lights) {
+        for (size_t index = 0; index < storage.size(); ++index) {
+            LightHandle handle = storage.getHandle(index);
             nlohmann::json lightJson;
-            lightJson["type"] = static_cast<int>(light->getType());
-            lightJson["color"] = { light->getColor().r, light->getColor().g, light->getColor().b };
-            lightJson["intensity"] = light->getIntensity();
-
-            if (light->getType() == LightType::Directional) {
-                lightJson["direction"] = {
-                    light->getDirection().x,
-                    light->getDirection().y,
-                    light->getDirection().z
-                };
+            lightJson["type"] = static_cast<int>(storage.getType(handle));
+
+            switch (storage.getType(handle)) {
+            case LightType::Directional: {
+                DirectionalLight light = storage.get<DirectionalLight>(handle);
+                lightJson["color"] = { light.color.r, light.color.g, light.color.b };
+                lightJson["intensity"] = light.intensity;
+                lightJson["direction"] = { light.direction.x, light.direction.y, light.direction.z };
+                break;
             }
-            else if (light->getType() == LightType::Point || light->getType() == LightType::Spot) {
-                lightJson["position"] = {
-                    light->getPosition().x,
-                    light->getPosition().y,
-                    light->getPosition().z
-                };
-                if (light->getType() == LightType::Spot) {
-                    lightJson["direction"] = {
-                        light->getDirection().x,
-                        light->getDirection().y,
-                        light->getDirection().z
-                    };
-                    auto* spotLight = static_cast<const SpotLight*>(light.get());
-                    lightJson["cutoffAngle"] = spotLight->getCutoffAngle();
+            case LightType::Point: {
+                PointLight light = storage.get<PointLight>(handle);
+                lightJson["color"] = { light.color.r, light.color.g, light.color.b };
+                lightJson["intensity"] = light.intensity;
+                lightJson["position"] = { light.position.x, light.position.y, light.position.z };
+                lightJson["range"] = light.range;
+                break;
+            }
+            case LightType::Spot: {
+                SpotLight light = storage.get<SpotLight>(handle);
+                lightJson["color"] = { light.color.r, light.color.g, light.color.b };
+                lightJson["intensity"] = light.intensity;
+                lightJson["position"] = { light.position.x, light.position.y, light.position.z };
+                lightJson["direction"] = { light.direction.x, light.direction.y, light.direction.z };
+                lightJson["cutoffAngle"] = light.cutoffAngle;
+                lightJson["range"] = light.range;
+                if (handle == cameraLight) {
+                    lightJson["followCamera"] = true;
                 }
+                break;
+            }
             }
             lightsJson.push_back(lightJson);
         }
@@ -201,6 +474,9 @@ public:
     // 反序列化光源
     void deserialize(const nlohmann::json& lightsJson) {
         clearLights();
+        bool hasCameraFlag = false;
+        LightHandle lastHandle;
+        LightType lastType = LightType::Directional;
         for (const auto& lightJson : lightsJson) {
             LightType type = static_cast<LightType>(lightJson["type"].get<int>());
             glm::vec3 color = glm::vec3(
@@ -213,8 +489,7 @@ public:
                     lightJson["direction"][1],
                     lightJson["direction"][2]
                 );
-                auto dirLight = std::make_shared<DirectionalLight>(direction, color, intensity);
-                addLight(dirLight);
+                lastHandle = addLight(DirectionalLight(direction, color, intensity));
             }
             else if (type == LightType::Point) {
                 glm::vec3 position = glm::vec3(
@@ -222,8 +497,11 @@ public:
                     lightJson["position"][1],
                     lightJson["position"][2]
                 );
-                auto pointLight = std::make_shared<PointLight>(position, color, intensity);
-                addLight(pointLight);
+                PointLight pointLight(position, color, intensity);
+                if (lightJson.contains("range")) {
+                    pointLight.range = lightJson["range"].get<float>();
+                }
+                lastHandle = addLight(pointLight);
             }
             else if (type == LightType::Spot) {
                 glm::vec3 position = glm::vec3(
@@ -237,9 +515,23 @@ public:
                     lightJson["direction"][2]
                 );
                 float cutoffAngle = lightJson["cutoffAngle"];
-                auto spotLight = std::make_shared<SpotLight>(position, direction, color, intensity, cutoffAngle);
-                addLight(spotLight);
+                SpotLight spotLight(position, direction, color, intensity, cutoffAngle);
+                if (lightJson.contains("range")) {
+                    spotLight.range = lightJson["range"].get<float>();
+                }
+                LightHandle handle = addLight(spotLight);
+                if (lightJson.value("followCamera", false)) {
+                    cameraLight = handle;
+                }
+                lastHandle = handle;
             }
+            lastType = type;
+            hasCameraFlag = hasCameraFlag || lightJson.contains("followCamera");
+        }
+
+        // 旧场景文件没有 followCamera 标记：与之前一样，最后一个聚光灯作为相机聚光灯
+        if (!hasCameraFlag && lastType == LightType::Spot) {
+            cameraLight = lastHandle;
         }
     }
 };
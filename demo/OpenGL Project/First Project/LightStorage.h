@@ -0,0 +1,405 @@
+// LightStorage.h
+#ifndef LIGHT_STORAGE_H
+#define LIGHT_STORAGE_H
+
+#include <vector>
+#include <tuple>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Light.h"
+
+// 光源的数据导向存储
+// - 每种光源一组 SoA 数组，逐帧的上传、分簇、阴影都按类型线性遍历，没有虚函数调用和类型转换
+// - 删除时与同类型的末尾元素交换，数组保持紧密；外部通过带代数的句柄稳定地引用光源
+// - 着色器中的光源下标按 方向光、点光源、聚光灯 的顺序连续排列
+class LightStorage {
+public:
+    struct DirectionalPool {
+        std::vector<glm::vec3> direction;
+        std::vector<glm::vec3> color;
+        std::vector<float> intensity;
+        std::vector<float> orthoSize;
+        std::vector<float> nearPlane;
+        std::vector<float> farPlane;
+        std::vector<float> shadowBias;
+        std::vector<uint64_t> version;  // 属性变化时更新，供上传和阴影缓存判断
+        std::vector<uint32_t> slot;     // 反向指向句柄表
+
+        size_t size() const { return direction.size(); }
+
+        auto arrays() { return std::tie(direction, color, intensity, orthoSize, nearPlane, farPlane, shadowBias, version, slot); }
+
+        void push(const DirectionalLight& l) {
+            direction.push_back(l.direction);
+            color.push_back(l.color);
+            intensity.push_back(l.intensity);
+            orthoSize.push_back(l.orthoSize);
+            nearPlane.push_back(l.nearPlane);
+            farPlane.push_back(l.farPlane);
+            shadowBias.push_back(l.shadowBias);
+        }
+
+        DirectionalLight get(size_t i) const {
+            DirectionalLight l(direction[i], color[i], intensity[i], orthoSize[i], nearPlane[i], farPlane[i]);
+            l.shadowBias = shadowBias[i];
+            return l;
+        }
+
+        bool set(size_t i, const DirectionalLight& l) {
+            bool changed = assign(direction[i], glm::normalize(l.direction));
+            changed |= assign(color[i], l.color);
+            changed |= assign(intensity[i], l.intensity);
+            changed |= assign(orthoSize[i], l.orthoSize);
+            changed |= assign(nearPlane[i], l.nearPlane);
+            changed |= assign(farPlane[i], l.farPlane);
+            changed |= assign(shadowBias[i], l.shadowBias);
+            return changed;
+        }
+    };
+
+    struct PointPool {
+        std::vector<glm::vec3> position;
+        std::vector<glm::vec3> color;
+        std::vector<float> intensity;
+        std::vector<float> nearPlane;
+        std::vector<float> farPlane;
+        std::vector<float> range;
+        std::vector<uint64_t> version;
+        std::vector<uint32_t> slot;
+
+        size_t size() const { return position.size(); }
+
+        auto arrays() { return std::tie(position, color, intensity, nearPlane, farPlane, range, version, slot); }
+
+        void push(const PointLight& l) {
+            position.push_back(l.position);
+            color.push_back(l.color);
+            intensity.push_back(l.intensity);
+            nearPlane.push_back(l.nearPlane);
+            farPlane.push_back(l.farPlane);
+            range.push_back(l.range);
+        }
+
+        PointLight get(size_t i) const {
+            PointLight l(position[i], color[i], intensity[i], nearPlane[i], farPlane[i]);
+            l.range = range[i];
+            return l;
+        }
+
+        bool set(size_t i, const PointLight& l) {
+            bool changed = assign(position[i], l.position);
+            changed |= assign(color[i], l.color);
+            changed |= assign(intensity[i], l.intensity);
+            changed |= assign(nearPlane[i], l.nearPlane);
+            changed |= assign(farPlane[i], l.farPlane);
+            changed |= assign(range[i], l.range);
+            return changed;
+        }
+    };
+
+    struct SpotPool {
+        std::vector<glm::vec3> position;
+        std::vector<glm::vec3> direction;
+        std::vector<glm::vec3> color;
+        std::vector<float> intensity;
+        std::vector<float> cutoffAngle;
+        std::vector<float> nearPlane;
+        std::vector<float> farPlane;
+        std::vector<float> range;
+        std::vector<uint64_t> version;
+        std::vector<uint32_t> slot;
+
+        size_t size() const { return position.size(); }
+
+        auto arrays() { return std::tie(position, direction, color, intensity, cutoffAngle, nearPlane, farPlane, range, version, slot); }
+
+        void push(const SpotLight& l) {
+            position.push_back(l.position);
+            direction.push_back(l.direction);
+            color.push_back(l.color);
+            intensity.push_back(l.intensity);
+            cutoffAngle.push_back(l.cutoffAngle);
+            nearPlane.push_back(l.nearPlane);
+            farPlane.push_back(l.farPlane);
+            range.push_back(l.range);
+        }
+
+        SpotLight get(size_t i) const {
+            SpotLight l(position[i], direction[i], color[i], intensity[i], cutoffAngle[i], nearPlane[i], farPlane[i]);
+            l.range = range[i];
+            return l;
+        }
+
+        bool set(size_t i, const SpotLight& l) {
+            bool changed = assign(position[i], l.position);
+            changed |= assign(direction[i], glm::normalize(l.direction));
+            changed |= assign(color[i], l.color);
+            changed |= assign(intensity[i], l.intensity);
+            changed |= assign(cutoffAngle[i], l.cutoffAngle);
+            changed |= assign(nearPlane[i], l.nearPlane);
+            changed |= assign(farPlane[i], l.farPlane);
+            changed |= assign(range[i], l.range);
+            return changed;
+        }
+    };
+
+    // 添加光源，返回句柄
+    template <typename T>
+    LightHandle add(const T& light) {
+        auto& p = pool<T>();
+        uint32_t slotIndex;
+        if (!freeSlots.empty()) {
+            slotIndex = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.push_back(SlotEntry());
+        }
+
+        SlotEntry& entry = slots[slotIndex];
+        entry.type = T::type;
+        entry.dense = static_cast<uint32_t>(p.size());
+        entry.alive = true;
+
+        p.push(light);
+        p.version.push_back(nextVersion());
+        p.slot.push_back(slotIndex);
+        ++structureVersion;
+        return LightHandle{ slotIndex, entry.generation };
+    }
+
+    // 删除光源；句柄失效后返回 false
+    bool remove(LightHandle handle) {
+        if (!isValid(handle)) {
+            return false;
+        }
+        SlotEntry& entry = slots[handle.slot];
+        switch (entry.type) {
+        case LightType::Directional: swapRemove(directionalPool, entry.dense); break;
+        case LightType::Point: swapRemove(pointPool, entry.dense); break;
+        case LightType::Spot: swapRemove(spotPool, entry.dense); break;
+        }
+        entry.alive = false;
+        ++entry.generation;
+        freeSlots.push_back(handle.slot);
+        ++structureVersion;
+        return true;
+    }
+
+    void clear() {
+        clearPool(directionalPool);
+        clearPool(pointPool);
+        clearPool(spotPool);
+        freeSlots.clear();
+        for (uint32_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].alive) {
+                slots[i].alive = false;
+                ++slots[i].generation;
+            }
+            freeSlots.push_back(static_cast<uint32_t>(slots.size()) - 1 - i);
+        }
+        ++structureVersion;
+    }
+
+    bool isValid(LightHandle handle) const {
+        return handle.slot < slots.size() && slots[handle.slot].alive
+            && slots[handle.slot].generation == handle.generation;
+    }
+
+    LightType getType(LightHandle handle) const {
+        return entryOf(handle).type;
+    }
+
+    // 按类型读取光源的副本，类型不符时抛出异常
+    template <typename T>
+    T get(LightHandle handle) const {
+        return pool<T>().get(denseOf<T>(handle));
+    }
+
+    // 按类型写回光源；只有值真正改变时才更新版本号
+    template <typename T>
+    void set(LightHandle handle, const T& light) {
+        auto& p = pool<T>();
+        size_t dense = denseOf<T>(handle);
+        if (p.set(dense, light)) {
+            p.version[dense] = nextVersion();
+        }
+    }
+
+    // 只修改位置 / 方向，用于每帧跟随相机的聚光灯等高频更新
+    void setPosition(LightHandle handle, const glm::vec3& position) {
+        const SlotEntry& entry = entryOf(handle);
+        if (entry.type == LightType::Point) {
+            touch(pointPool, entry.dense, assign(pointPool.position[entry.dense], position));
+        }
+        else if (entry.type == LightType::Spot) {
+            touch(spotPool, entry.dense, assign(spotPool.position[entry.dense], position));
+        }
+        else {
+            throw std::runtime_error("This light type does not support setting position!");
+        }
+    }
+
+    void setDirection(LightHandle handle, const glm::vec3& direction) {
+        const SlotEntry& entry = entryOf(handle);
+        if (entry.type == LightType::Directional) {
+            touch(directionalPool, entry.dense, assign(directionalPool.direction[entry.dense], glm::normalize(direction)));
+        }
+        else if (entry.type == LightType::Spot) {
+            touch(spotPool, entry.dense, assign(spotPool.direction[entry.dense], glm::normalize(direction)));
+        }
+        else {
+            throw std::runtime_error("This light type does not support setting direction!");
+        }
+    }
+
+    // 光源的版本号，阴影缓存等系统可据此判断光源是否变化
+    uint64_t getVersion(LightHandle handle) const {
+        const SlotEntry& entry = entryOf(handle);
+        switch (entry.type) {
+        case LightType::Directional: return directionalPool.version[entry.dense];
+        case LightType::Point: return pointPool.version[entry.dense];
+        default: return spotPool.version[entry.dense];
+        }
+    }
+
+    // 添加、删除光源时递增，表示着色器下标可能变化
+    uint64_t getStructureVersion() const { return structureVersion; }
+
+    size_t size() const { return directionalPool.size() + pointPool.size() + spotPool.size(); }
+
+    // 各类型在着色器光源数组中的起始下标
+    size_t pointBase() const { return directionalPool.size(); }
+    size_t spotBase() const { return directionalPool.size() + pointPool.size(); }
+
+    // 光源在着色器光源数组中的下标
+    size_t getIndex(LightHandle handle) const {
+        const SlotEntry& entry = entryOf(handle);
+        switch (entry.type) {
+        case LightType::Directional: return entry.dense;
+        case LightType::Point: return pointBase() + entry.dense;
+        default: return spotBase() + entry.dense;
+        }
+    }
+
+    // 由着色器下标得到类型和同类型数组中的下标
+    LightType locate(size_t index, size_t& dense) const {
+        if (index < pointBase()) {
+            dense = index;
+            return LightType::Directional;
+        }
+        if (index < spotBase()) {
+            dense = index - pointBase();
+            return LightType::Point;
+        }
+        if (index < size()) {
+            dense = index - spotBase();
+            return LightType::Spot;
+        }
+        throw std::runtime_error("Invalid light index!");
+    }
+
+    LightHandle getHandle(size_t index) const {
+        size_t dense = 0;
+        uint32_t slotIndex = 0;
+        switch (locate(index, dense)) {
+        case LightType::Directional: slotIndex = directionalPool.slot[dense]; break;
+        case LightType::Point: slotIndex = pointPool.slot[dense]; break;
+        case LightType::Spot: slotIndex = spotPool.slot[dense]; break;
+        }
+        return LightHandle{ slotIndex, slots[slotIndex].generation };
+    }
+
+    const DirectionalPool& directionals() const { return directionalPool; }
+    const PointPool& points() const { return pointPool; }
+    const SpotPool& spots() const { return spotPool; }
+
+private:
+    struct SlotEntry {
+        LightType type = LightType::Point;
+        uint32_t dense = 0;        // 在同类型数组中的下标
+        uint32_t generation = 0;   // 删除后递增，使旧句柄失效
+        bool alive = false;
+    };
+
+    DirectionalPool directionalPool;
+    PointPool pointPool;
+    SpotPool spotPool;
+    std::vector<SlotEntry> slots;
+    std::vector<uint32_t> freeSlots;
+    uint64_t structureVersion = 0;
+
+    template <typename T>
+    auto& pool() {
+        static_assert(std::is_same_v<T, DirectionalLight> || std::is_same_v<T, PointLight> || std::is_same_v<T, SpotLight>,
+            "Unsupported light type");
+        if constexpr (std::is_same_v<T, DirectionalLight>) return directionalPool;
+        else if constexpr (std::is_same_v<T, PointLight>) return pointPool;
+        else return spotPool;
+    }
+
+    template <typename T>
+    const auto& pool() const {
+        return const_cast<LightStorage*>(this)->pool<T>();
+    }
+
+    const SlotEntry& entryOf(LightHandle handle) const {
+        if (!isValid(handle)) {
+            throw std::runtime_error("Invalid light handle!");
+        }
+        return slots[handle.slot];
+    }
+
+    template <typename T>
+    size_t denseOf(LightHandle handle) const {
+        const SlotEntry& entry = entryOf(handle);
+        if (entry.type != T::type) {
+            throw std::runtime_error("Light handle refers to a different light type!");
+        }
+        return entry.dense;
+    }
+
+    // 与末尾元素交换后弹出，并修正被移动元素的句柄
+    template <typename Pool>
+    void swapRemove(Pool& p, size_t dense) {
+        size_t last = p.size() - 1;
+        if (dense != last) {
+            slots[p.slot[last]].dense = static_cast<uint32_t>(dense);
+        }
+        std::apply([&](auto&... arrays) {
+            ((arrays[dense] = arrays[last], arrays.pop_back()), ...);
+        }, p.arrays());
+    }
+
+    template <typename Pool>
+    static void clearPool(Pool& p) {
+        std::apply([](auto&... arrays) { (arrays.clear(), ...); }, p.arrays());
+    }
+
+    template <typename Pool>
+    static void touch(Pool& p, size_t dense, bool changed) {
+        if (changed) {
+            p.version[dense] = nextVersion();
+        }
+    }
+
+    template <typename V>
+    static bool assign(V& field, const V& value) {
+        if (field == value) {
+            return false;
+        }
+        field = value;
+        return true;
+    }
+
+    // 版本号取自全局计数，不会重复，删除后复用的槽位也能被识别为新光源
+    static uint64_t nextVersion() {
+        static uint64_t counter = 0;
+        return ++counter;
+    }
+};
+
+#endif // LIGHT_STORAGE_H
@@ -0,0 +1,155 @@
+#include "OffscreenContext.h"
+#include <EGL/eglext.h>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) {
+        return false;
+    }
+    size_t length = std::strlen(name);
+    for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + length, name)) {
+        // 只接受完整的扩展名
+        bool start = p == extensions || p[-1] == ' ';
+        bool end = p[length] == ' ' || p[length] == '\0';
+        if (start && end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void* loadProc(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+} // namespace
+
+OffscreenContext::~OffscreenContext() {
+    destroy();
+}
+
+GLADloadproc OffscreenContext::loader() {
+    return loadProc;
+}
+
+bool OffscreenContext::openDisplay() {
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    // 优先使用第一块 GPU 设备，不依赖 X11 / Wayland
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+        auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+        EGLDeviceEXT devices[8];
+        EGLint deviceCount = 0;
+        if (queryDevices && queryDevices(8, devices, &deviceCount)) {
+            for (EGLint i = 0; i < deviceCount && display == EGL_NO_DISPLAY; ++i) {
+                EGLDisplay candidate = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                if (candidate != EGL_NO_DISPLAY && eglInitialize(candidate, nullptr, nullptr)) {
+                    display = candidate;
+                    platformName = "device";
+                }
+            }
+        }
+    }
+    if (display == EGL_NO_DISPLAY && getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        EGLDisplay candidate = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (candidate != EGL_NO_DISPLAY && eglInitialize(candidate, nullptr, nullptr)) {
+            display = candidate;
+            platformName = "surfaceless";
+        }
+    }
+    if (display == EGL_NO_DISPLAY) {
+        EGLDisplay candidate = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (candidate != EGL_NO_DISPLAY && eglInitialize(candidate, nullptr, nullptr)) {
+            display = candidate;
+            platformName = "default";
+        }
+    }
+    return display != EGL_NO_DISPLAY;
+}
+
+bool OffscreenContext::create(int width, int height) {
+    if (!openDisplay()) {
+        std::cerr << "Failed to open an EGL display." << std::endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL display does not support desktop OpenGL." << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cerr << "No EGL config with a pbuffer and depth buffer." << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) {
+        std::cerr << "Failed to create a " << width << "x" << height << " pbuffer surface." << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 4.3 core context." << std::endl;
+        destroy();
+        return false;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Failed to make the offscreen context current." << std::endl;
+        destroy();
+        return false;
+    }
+
+    if (!gladLoadGLLoader(loader())) {
+        std::cerr << "Failed to initialize GLAD." << std::endl;
+        destroy();
+        return false;
+    }
+    std::cout << "Offscreen context (" << platformName << "): " << glGetString(GL_RENDERER) << ", "
+        << glGetString(GL_VERSION) << std::endl;
+    return true;
+}
+
+void OffscreenContext::destroy() {
+    if (display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT) {
+        eglDestroyContext(display, context);
+        context = EGL_NO_CONTEXT;
+    }
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+        surface = EGL_NO_SURFACE;
+    }
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,38 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+
+// 无窗口的 OpenGL 上下文，用于在没有显示器的机器上渲染和跑基准
+// - 依次尝试 EGL 的 GPU 设备平台、Mesa 的 surfaceless 平台和默认显示；
+//   没有 GPU 时 Mesa 会回退到 llvmpipe（也可以设置 LIBGL_ALWAYS_SOFTWARE=1 强制使用）
+// - 创建与目标分辨率相同、带深度缓冲的 pbuffer 作为默认帧缓冲，渲染器直接绘制到帧缓冲 0，截图照常读取
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // 创建 OpenGL 4.3 core 上下文并设为当前，同时加载 glad；失败时打印原因并返回 false
+    bool create(int width, int height);
+    void destroy();
+
+    // 供 glad 和 ShaderCache 查询扩展函数
+    static GLADloadproc loader();
+
+    // 实际使用的显示平台和驱动，便于确认跑在 GPU 还是 llvmpipe 上
+    const char* getPlatformName() const { return platformName; }
+
+private:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+    const char* platformName = "none";
+
+    bool openDisplay();
+};
+
+#endif // OFFSCREEN_CONTEXT_H
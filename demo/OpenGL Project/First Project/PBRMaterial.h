@@ -4,7 +4,7 @@
 
 #include <string>
 #include <vector>
-#include "Mesh.h" // ȷ Texture ṹ
+#include "mesh.h" // ȷ Texture ṹ
 
 struct PBRMaterial {
     glm::vec3 albedo;
@@ -0,0 +1,175 @@
+#include "PostCompute.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr int TILE_SIZE = 16;          // 与 post_tiled.glsl 的 TILE_SIZE 一致
+constexpr size_t BYTES_PER_PIXEL = 4;  // RGBA8
+
+} // namespace
+
+PostCompute::PostCompute(unsigned int width, unsigned int height)
+    : width(width), height(height), readFBO(0) {
+}
+
+PostCompute::~PostCompute() {
+    releaseTargets();
+    if (readFBO) GL_STATE.deleteFramebuffers(1, &readFBO);
+    if (upsampleShader) GL_STATE.deleteProgram(upsampleShader->ID);
+}
+
+bool PostCompute::initialize() {
+    glGenFramebuffers(1, &readFBO);
+    upsampleShader = std::make_unique<Shader>("./effects/post_upsample.comp");
+    upsampleShader->use();
+    upsampleShader->setInt("fullInput", 0);
+    upsampleShader->setInt("lowInput", 1);
+    upsampleShader->setInt("lowOutput", 2);
+    GL_STATE.useProgram(0);
+    return upsampleShader->ID != 0;
+}
+
+void PostCompute::resize(unsigned int newWidth, unsigned int newHeight) {
+    if (newWidth == 0 || newHeight == 0 || (newWidth == width && newHeight == height))
+        return;
+    width = newWidth;
+    height = newHeight;
+    releaseTargets();
+}
+
+void PostCompute::beginFrame() {
+    stats = {};
+    nextFull = 0;
+}
+
+PostCompute::Target& PostCompute::target(Tier tier, int slot) {
+    Target& entry = pool[tier][slot];
+    if (entry.texture) {
+        return entry;
+    }
+
+    entry.width = std::max(1, static_cast<int>(width) >> tier);
+    entry.height = std::max(1, static_cast<int>(height) >> tier);
+
+    // imageStore 需要固定格式的存储
+    glGenTextures(1, &entry.texture);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, entry.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, entry.width, entry.height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, 0);
+
+    GLuint previousFBO = GL_STATE.getDrawFramebuffer();
+    glGenFramebuffers(1, &entry.fbo);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, entry.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, entry.texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Post compute target (" << tierName(tier) << ") is not complete!" << std::endl;
+    }
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    return entry;
+}
+
+void PostCompute::releaseTargets() {
+    for (auto& tierTargets : pool) {
+        for (Target& entry : tierTargets) {
+            if (entry.fbo) GL_STATE.deleteFramebuffers(1, &entry.fbo);
+            if (entry.texture) GL_STATE.deleteTextures(1, &entry.texture);
+            entry = Target();
+        }
+    }
+}
+
+GLuint PostCompute::run(GLuint input, Shader& chain, Tier tier, const std::function<void(Shader&)>& configure) {
+    Target& output = target(FULL, nextFull);
+    nextFull = 1 - nextFull;
+
+    // 运行效果链：输入和输出同尺寸
+    auto runChain = [&](GLuint source, const Target& destination) {
+        chain.use();
+        chain.setInt("screenTexture", 0);
+        chain.setIVec2("outputSize", destination.width, destination.height);
+        if (configure) {
+            configure(chain);
+        }
+        GL_STATE.bindTexture(0, GL_TEXTURE_2D, source);
+        RENDER_STATS_TEXTURE();
+        glBindImageTexture(0, destination.texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        dispatch(destination.width, destination.height);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+        stats.bytes += static_cast<size_t>(destination.width) * destination.height * BYTES_PER_PIXEL * 2;
+    };
+
+    if (tier == FULL) {
+        runChain(input, output);
+        return output.texture;
+    }
+
+    // 逐级降采样，每级双线性取 2x2 的平均，避免直接缩小到 1/4 时的走样
+    GLuint source = input;
+    int sourceWidth = static_cast<int>(width);
+    int sourceHeight = static_cast<int>(height);
+    for (int level = HALF; level <= tier; ++level) {
+        Target& low = target(static_cast<Tier>(level), 0);
+        blit(source, sourceWidth, sourceHeight, low.fbo, low.width, low.height);
+        stats.bytes += (pixels(static_cast<Tier>(level - 1)) + pixels(static_cast<Tier>(level))) * BYTES_PER_PIXEL;
+        source = low.texture;
+        sourceWidth = low.width;
+        sourceHeight = low.height;
+    }
+
+    Target& lowInput = target(tier, 0);
+    Target& lowOutput = target(tier, 1);
+    runChain(lowInput.texture, lowOutput);
+
+    upsampleShader->use();
+    upsampleShader->setFloat("sharpness", 32.0f);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, input);
+    GL_STATE.bindTexture(1, GL_TEXTURE_2D, lowInput.texture);
+    GL_STATE.bindTexture(2, GL_TEXTURE_2D, lowOutput.texture);
+    RENDER_STATS_TEXTURES(3);
+    glBindImageTexture(0, output.texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    dispatch(output.width, output.height);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+    stats.bytes += (pixels(FULL) * 2 + pixels(tier) * 2) * BYTES_PER_PIXEL;
+    return output.texture;
+}
+
+void PostCompute::present(GLuint texture) {
+    blit(texture, static_cast<int>(width), static_cast<int>(height), 0, static_cast<int>(width), static_cast<int>(height));
+    stats.bytes += pixels(FULL) * BYTES_PER_PIXEL * 2;
+}
+
+void PostCompute::blit(GLuint source, int sourceWidth, int sourceHeight, GLuint targetFBO, int targetWidth, int targetHeight) {
+    GL_STATE.bindFramebuffer(GL_READ_FRAMEBUFFER, readFBO);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0);
+    GL_STATE.bindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+    glBlitFramebuffer(0, 0, sourceWidth, sourceHeight, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT,
+        (sourceWidth == targetWidth && sourceHeight == targetHeight) ? GL_NEAREST : GL_LINEAR);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+    ++stats.blits;
+}
+
+void PostCompute::dispatch(int dispatchWidth, int dispatchHeight) {
+    glDispatchCompute((dispatchWidth + TILE_SIZE - 1) / TILE_SIZE, (dispatchHeight + TILE_SIZE - 1) / TILE_SIZE, 1);
+    RENDER_STATS_DISPATCH();
+    ++stats.dispatches;
+}
+
+size_t PostCompute::pixels(Tier tier) const {
+    return static_cast<size_t>(std::max(1u, width >> tier)) * std::max(1u, height >> tier);
+}
+
+const char* PostCompute::tierName(Tier tier) {
+    switch (tier) {
+    case FULL: return "Full";
+    case HALF: return "Half";
+    case QUARTER: return "Quarter";
+    default: return "Unknown";
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef POST_COMPUTE_H
+#define POST_COMPUTE_H
+
+#include <glad/glad.h>
+#include <functional>
+#include <memory>
+#include "shader.h"
+
+// 计算着色器后处理后端
+// - 效果链由 PostProcessing 生成（effects/post_tiled.glsl + 各效果的 applyEffect），每个工作组处理 16x16 分块，
+//   邻域采样优先读取共享内存
+// - 每个 pass 可选全分辨率、1/2 或 1/4 分辨率：低分辨率档位先降采样输入，效果在低分辨率下运行，
+//   再以全分辨率输入为引导做联合双边上采样
+// - 中间纹理按分辨率档位放在池中，首次使用时创建，窗口尺寸变化时全部释放重建
+class PostCompute {
+public:
+    enum Tier {
+        FULL = 0,
+        HALF = 1,
+        QUARTER = 2,
+        TIER_COUNT
+    };
+
+    struct Stats {
+        int dispatches;     // 上一帧的计算着色器调度数（含上采样）
+        int blits;          // 降采样和输出到屏幕的拷贝数
+        size_t bytes;       // 估计的纹理读写量
+    };
+
+    PostCompute(unsigned int width, unsigned int height);
+    ~PostCompute();
+
+    PostCompute(const PostCompute&) = delete;
+    PostCompute& operator=(const PostCompute&) = delete;
+
+    // 编译上采样着色器
+    bool initialize();
+
+    // 窗口尺寸变化时释放所有中间纹理，之后按需重建
+    void resize(unsigned int width, unsigned int height);
+
+    // 每帧开始时重置统计和交替下标
+    void beginFrame();
+
+    // 以 input（全分辨率）为输入运行一个效果链程序，返回全分辨率的输出纹理；
+    // configure 在程序激活后调用，用于设置效果参数
+    GLuint run(GLuint input, Shader& chain, Tier tier, const std::function<void(Shader&)>& configure);
+
+    // 把结果拷贝到默认帧缓冲
+    void present(GLuint texture);
+
+    const Stats& getStats() const { return stats; }
+
+    static const char* tierName(Tier tier);
+
+private:
+    // 池中的一张中间纹理，同时附着到一个 FBO 上用于拷贝
+    struct Target {
+        GLuint texture = 0;
+        GLuint fbo = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    unsigned int width, height;
+    Target pool[TIER_COUNT][2];     // 每个档位两张：全分辨率交替读写，低分辨率为输入和输出
+    int nextFull = 0;               // 下一个 pass 写入的全分辨率纹理
+    GLuint readFBO;                 // 拷贝时临时附着外部纹理
+    std::unique_ptr<Shader> upsampleShader;
+    Stats stats = {};
+
+    Target& target(Tier tier, int slot);
+    void releaseTargets();
+
+    // 把纹理拷贝到目标（带线性过滤的缩放）
+    void blit(GLuint source, int sourceWidth, int sourceHeight, GLuint targetFBO, int targetWidth, int targetHeight);
+
+    // 按 16x16 分块调度
+    void dispatch(int dispatchWidth, int dispatchHeight);
+
+    size_t pixels(Tier tier) const;
+};
+
+#endif // POST_COMPUTE_H
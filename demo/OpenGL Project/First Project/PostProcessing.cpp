@@ -1,25 +1,62 @@
 #include "PostProcessing.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 
 PostProcessing::PostProcessing(unsigned int width, unsigned int height)
-    : width(width), height(height), fbo(0), rbo(0), texture(0), quadVAO(0), quadVBO(0) {
+    : width(width), height(height), renderWidth(width), renderHeight(height),
+    fbo(0), rbo(0), texture(0), quadVAO(0), quadVBO(0),
+    pingPongFBO{ 0, 0 }, pingPongTex{ 0, 0 }, compute(width, height) {
 }
 
 PostProcessing::~PostProcessing() {
-    glDeleteFramebuffers(1, &fbo);
-    glDeleteRenderbuffers(1, &rbo);
-    glDeleteTextures(1, &texture);
-    glDeleteVertexArrays(1, &quadVAO);
+    releaseTargets();
+    GL_STATE.deleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
+    for (auto& kv : fusedShaders) {
+        GL_STATE.deleteProgram(kv.second.ID);
+    }
+    for (auto& kv : computeShaders) {
+        GL_STATE.deleteProgram(kv.second.ID);
+    }
+    if (upscaleShader) GL_STATE.deleteProgram(upscaleShader->ID);
 }
 
 bool PostProcessing::initialize() {
+    if (!createTargets()) {
+        return false;
+    }
+    initQuad();
+    upscaleShader = std::make_unique<Shader>("./effects/post_process.vs", "./effects/upscale.fs");
+    return compute.initialize();
+}
+
+bool PostProcessing::resize(unsigned int newWidth, unsigned int newHeight) {
+    if (newWidth == 0 || newHeight == 0 || (newWidth == width && newHeight == height))
+        return true;
+    width = newWidth;
+    height = newHeight;
+    setRenderScale(renderScale);
+    releaseTargets();
+    compute.resize(width, height);
+    return createTargets();
+}
+
+void PostProcessing::setRenderScale(float scale) {
+    renderScale = std::min(std::max(scale, 0.01f), 1.0f);
+    renderWidth = std::max(1u, static_cast<unsigned int>(width * renderScale + 0.5f));
+    renderHeight = std::max(1u, static_cast<unsigned int>(height * renderScale + 0.5f));
+}
+
+bool PostProcessing::createTargets() {
     //  FBO
     glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, fbo);
 
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -38,118 +75,302 @@ bool PostProcessing::initialize() {
         return false;
     }
     // 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// м FBO
-    glGenFramebuffers(1, &intermediateFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
+    // м FBOŽдͬһ
+    glGenFramebuffers(2, pingPongFBO);
+    glGenTextures(2, pingPongTex);
+    for (int i = 0; i < 2; ++i) {
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, pingPongFBO[i]);
 
-    glGenTextures(1, &intermediateTex);
-    glBindTexture(GL_TEXTURE_2D, intermediateTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GL_STATE.bindTexture(0, GL_TEXTURE_2D, pingPongTex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, intermediateTex, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingPongTex[i], 0);
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cerr << "Intermediate Framebuffer is not complete!" << std::endl;
-        return false;
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Intermediate Framebuffer is not complete!" << std::endl;
+            return false;
+        }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    initQuad();
-
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
     return true;
 }
 
-void PostProcessing::registerEffect(const std::string& name, const Shader& shader, std::function<void(Shader&)> configure) {
-    effects[name] = shader;
-    effectStates[name] = false; // ĬϹر
-    effectConfigurations[name] = configure;
+void PostProcessing::releaseTargets() {
+    if (fbo) GL_STATE.deleteFramebuffers(1, &fbo);
+    if (rbo) glDeleteRenderbuffers(1, &rbo);
+    if (texture) GL_STATE.deleteTextures(1, &texture);
+    GL_STATE.deleteFramebuffers(2, pingPongFBO);
+    GL_STATE.deleteTextures(2, pingPongTex);
+    fbo = rbo = texture = 0;
+    pingPongFBO[0] = pingPongFBO[1] = 0;
+    pingPongTex[0] = pingPongTex[1] = 0;
+}
+
+void PostProcessing::registerEffect(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+    bool samplesNeighbors, std::function<void(Shader&)> configure) {
+    Effect effect;
+    effect.vertexPath = vertexPath;
+    effect.fragmentPath = fragmentPath;
+    effect.shader = Shader(vertexPath.c_str(), fragmentPath.c_str());
+    effect.samplesNeighbors = samplesNeighbors;
+    effect.enabled = false; // ĬϹر
+    effect.tier = PostCompute::FULL;
+    effect.configure = configure;
+    effects[name] = effect;
 }
 
 void PostProcessing::enableEffect(const std::string& name, bool enable) {
-    if (effectStates.find(name) != effectStates.end()) {
-        effectStates[name] = enable;
+    auto it = effects.find(name);
+    if (it != effects.end()) {
+        it->second.enabled = enable;
     }
 }
 
 bool PostProcessing::isEffectEnabled(const std::string& name) const {
-    auto it = effectStates.find(name);
-    return it != effectStates.end() ? it->second : false;
+    auto it = effects.find(name);
+    return it != effects.end() ? it->second.enabled : false;
 }
 
 void PostProcessing::setEffectConfig(const std::string& name, std::function<void(Shader&)> configure) {
-    if (effectConfigurations.find(name) != effectConfigurations.end()) {
-        effectConfigurations[name] = configure;
+    auto it = effects.find(name);
+    if (it != effects.end()) {
+        it->second.configure = configure;
     }
 }
 
 std::map<std::string, bool> PostProcessing::getEffectsState() const {
-    return effectStates;
+    std::map<std::string, bool> states;
+    for (const auto& kv : effects) {
+        states[kv.first] = kv.second.enabled;
+    }
+    return states;
+}
+
+void PostProcessing::setEffectTier(const std::string& name, PostCompute::Tier tier) {
+    auto it = effects.find(name);
+    if (it != effects.end()) {
+        it->second.tier = tier;
+    }
+}
+
+PostCompute::Tier PostProcessing::getEffectTier(const std::string& name) const {
+    auto it = effects.find(name);
+    return it != effects.end() ? it->second.tier : PostCompute::FULL;
 }
 
 void PostProcessing::begin() {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, fbo);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void PostProcessing::endAndRender()
 {
+    std::vector<Segment> segments = buildSegments();
+    stats.passes = static_cast<int>(segments.size());
+    stats.effects = 0;
+    stats.bytes = 0;
+
     unsigned int currentTexture = texture;
 
-    glBindVertexArray(quadVAO);
+    // ֻȾ½ǣ֮ pass Ŀ
+    GL_STATE.viewport(0, 0, width, height);
+
+    // ֱ̬ʣȰȾŴȫмдڶмһЧ pass дһţûЧʱֱĻ
+    if (isScaled()) {
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, segments.empty() ? 0 : pingPongFBO[1]);
+        glClear(GL_COLOR_BUFFER_BIT);
+        upscaleShader->use();
+        upscaleShader->setInt("screenTexture", 0);
+        upscaleShader->setVec2("renderScale", static_cast<float>(renderWidth) / width, static_cast<float>(renderHeight) / height);
+        GL_STATE.bindTexture(0, GL_TEXTURE_2D, texture);
+        RENDER_STATS_TEXTURE();
+        GL_STATE.bindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        RENDER_STATS_DRAW(2);
+        GL_STATE.bindVertexArray(0);
+
+        currentTexture = pingPongTex[1];
+        stats.passes += 1;
+        stats.bytes += (static_cast<size_t>(renderWidth) * renderHeight + static_cast<size_t>(width) * height) * 4;
+        if (segments.empty()) {
+            return;
+        }
+    }
 
-    // Ч
-    bool firstEnabled = true;
-    unsigned int enabledCount = 0;
-    for (auto& kv : effectStates) {
-        if (kv.second) enabledCount++;
+    if (backend == COMPUTE) {
+        compute.beginFrame();
+        for (const Segment& segment : segments) {
+            Shader& shader = computeShaderFor(segment);
+            currentTexture = compute.run(currentTexture, shader, segment.tier, [&segment](Shader& chain) {
+                for (const Effect* effect : segment.effects) {
+                    if (effect->configure) {
+                        effect->configure(chain);
+                    }
+                }
+            });
+            stats.effects += static_cast<int>(segment.effects.size());
+        }
+        // ɫдĬ֡壬󿽱һ
+        compute.present(currentTexture);
+        stats.bytes += compute.getStats().bytes;
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
     }
 
-    for (auto& kv : effects) {
-        const std::string& name = kv.first;
-        Shader& shader = kv.second;
+    GL_STATE.bindVertexArray(quadVAO);
 
-        if (effectStates[name]) {
-            bool isLastPass = (--enabledCount == 0);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const Segment& segment = segments[i];
+        bool isLastPass = (i + 1 == segments.size());
 
-            if (!isLastPass) {
-                // мFBOԽ intermediateTex
-                glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
-                glClear(GL_COLOR_BUFFER_BIT);
-            }
-            else {
-                // һPassֱĻ
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                glClear(GL_COLOR_BUFFER_BIT);
-            }
+        // һ pass ֱĻд벻ͬм
+        unsigned int target = isLastPass ? 0 : pingPongFBO[i % 2];
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, target);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-            shader.use();
-            glBindTexture(GL_TEXTURE_2D, currentTexture);
+        Shader& shader = shaderFor(segment);
+        shader.use();
+        GL_STATE.bindTexture(0, GL_TEXTURE_2D, currentTexture);
+        RENDER_STATS_TEXTURE();
 
-            // ɫ
-            if (effectConfigurations[name]) {
-                effectConfigurations[name](shader);
+        // ɫƴӳиЧ uniform ͬһ
+        for (const Effect* effect : segment.effects) {
+            if (effect->configure) {
+                effect->configure(shader);
             }
+        }
 
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        RENDER_STATS_DRAW(2);
 
-            // һPassмΪһPass
-            if (!isLastPass) {
-                currentTexture = intermediateTex;
-            }
+        // һPassмΪһPass
+        if (!isLastPass) {
+            currentTexture = pingPongTex[i % 2];
         }
+
+        stats.effects += static_cast<int>(segment.effects.size());
+        stats.bytes += static_cast<size_t>(width) * height * 4 * 2;
+    }
+
+    GL_STATE.bindVertexArray(0);
+}
+
+std::vector<PostProcessing::Segment> PostProcessing::buildSegments() {
+    std::vector<Segment> segments;
+    for (auto& kv : effects) {
+        Effect& effect = kv.second;
+        if (!effect.enabled) {
+            continue;
+        }
+        // ЧҪǰЧĽ뿪ʼµ passƴʱÿЧһ pass
+        // ɫзֱʵλͬЧҲͬһ pass
+        PostCompute::Tier tier = backend == COMPUTE ? effect.tier : PostCompute::FULL;
+        if (segments.empty() || effect.samplesNeighbors || !fusionEnabled || segments.back().tier != tier) {
+            segments.emplace_back();
+            segments.back().tier = tier;
+        }
+        Segment& segment = segments.back();
+        segment.effects.push_back(&effect);
+        if (!segment.key.empty()) {
+            segment.key += '|';
+        }
+        segment.key += kv.first;
+    }
+    return segments;
+}
+
+Shader& PostProcessing::shaderFor(const Segment& segment) {
+    if (segment.effects.size() == 1) {
+        return segment.effects.front()->shader;
+    }
+
+    auto it = fusedShaders.find(segment.key);
+    if (it != fusedShaders.end()) {
+        return it->second;
     }
 
-    glBindVertexArray(0);
+    std::string vertexSource = Shader::loadSource(segment.effects.front()->vertexPath.c_str());
+    Shader shader = Shader::fromSource(vertexSource, generateChainSource(segment, false), "post chain: " + segment.key);
+    stats.fusedPrograms = fusedShaders.size() + computeShaders.size() + 1;
+    return fusedShaders.emplace(segment.key, shader).first->second;
 }
 
+Shader& PostProcessing::computeShaderFor(const Segment& segment) {
+    // ɫûеЧ򣬵ЧҲЧ
+    auto it = computeShaders.find(segment.key);
+    if (it != computeShaders.end()) {
+        return it->second;
+    }
+
+    Shader shader;
+    shader.ID = ShaderCache::instance().createProgram({ { GL_COMPUTE_SHADER, generateChainSource(segment, true) } },
+        "post compute chain: " + segment.key);
+    stats.fusedPrograms = fusedShaders.size() + computeShaders.size() + 1;
+    return computeShaders.emplace(segment.key, shader).first->second;
+}
+
+std::string PostProcessing::generateChainSource(const Segment& segment, bool computeBackend) {
+    std::ostringstream source;
+    if (computeBackend) {
+        // ֿȡ samplePost ҪЧԴ֮ǰ
+        source << "#version 430 core\n";
+        source << "#define POST_CHAIN\n";
+        source << "#define POST_COMPUTE\n";
+        source << Shader::loadSource("./effects/post_tiled.glsl");
+    }
+    else {
+        source << "#version 330 core\n";
+        source << "#define POST_CHAIN\n";
+    }
+
+    // ÿЧ applyEffect úΪ applyEffect_iõ post_common.glsl ıȥ
+    for (size_t i = 0; i < segment.effects.size(); ++i) {
+        std::string effectSource = Shader::loadSource(segment.effects[i]->fragmentPath.c_str());
+        // ȥ #version УУϢекŲ䣩
+        size_t version = effectSource.find("#version");
+        if (version != std::string::npos) {
+            size_t lineEnd = effectSource.find('\n', version);
+            effectSource.erase(version, lineEnd == std::string::npos ? std::string::npos : lineEnd - version);
+        }
+        source << "#define applyEffect applyEffect_" << i << "\n";
+        source << "#line 1 " << i + 1 << "\n";
+        source << effectSource << "\n";
+        source << "#undef applyEffect\n";
+    }
+
+    source << "void main()\n{\n";
+    if (computeBackend) {
+        // 鶼Ҫֿ飬Խ֮߳ŷ
+        source << "    loadTile();\n";
+        source << "    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n";
+        source << "    if (pixel.x >= outputSize.x || pixel.y >= outputSize.y)\n        return;\n";
+        source << "    vec2 uv = (vec2(pixel) + 0.5) / vec2(outputSize);\n";
+        source << "    vec3 color = tileColor(pixel);\n";
+    }
+    else {
+        source << "    vec2 uv = TexCoords;\n";
+        source << "    vec3 color = texture(screenTexture, uv).rgb;\n";
+    }
+    // м RGB8 pass ʱÿЧĽᱻضϵ [0, 1]ƴӺ󱣳ͬĽ
+    for (size_t i = 0; i < segment.effects.size(); ++i) {
+        source << "    color = clamp(applyEffect_" << i << "(color, uv), 0.0, 1.0);\n";
+    }
+    if (computeBackend) {
+        source << "    imageStore(outputImage, pixel, vec4(color, 1.0));\n}\n";
+    }
+    else {
+        source << "    FragColor = vec4(color, 1.0);\n}\n";
+    }
+    return source.str();
+}
 
 bool PostProcessing::hasEnabledEffects() const {
-    for (const auto& effect : effectStates) {
-        if (effect.second) {
+    for (const auto& kv : effects) {
+        if (kv.second.enabled) {
             return true;
         }
     }
@@ -171,12 +392,12 @@ void PostProcessing::initQuad() {
 
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
+    GL_STATE.bindVertexArray(quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glBindVertexArray(0);
+    GL_STATE.bindVertexArray(0);
 }
@@ -4,19 +4,46 @@
 #include <glad/glad.h>
 #include <map>
 #include <string>
+#include <vector>
 #include <functional>
-#include "Shader.h"
+#include <memory>
+#include "shader.h"
+#include "PostCompute.h"
 
+// 
+// - ÿЧƬɫʵ vec3 applyEffect(vec3 color, vec2 uv)ʹʱ #ifndef POST_CHAIN е main 
+// - Ч˳ƴӳһɵƬɫһ pass ɣЧϺ˳򻺴
+// - ҪЧǰЧֻΪһ pass ĵһЧ
+//   ǰ֮мд
+// - ƴӺЧһ uniform ռ䣬ͬЧ uniform 
+// - ɫˣPostComputeʹͬЧԴͷֶΣ֧ÿЧķֱʵλ
+// - ֱ̬ʣֻȾĿ½ǵЧ֮ǰ˫ηŴȫڳߴ䣬ű仯·
 class PostProcessing {
 public:
+    enum Backend {
+        FRAGMENT,   // ȫı
+        COMPUTE     // 16x16 ֿļɫ
+    };
+
+    struct Stats {
+        int passes;             // һ֡ȫ pass 
+        int effects;            // һ֡õЧ
+        size_t bytes;           // Ƶдÿ pass һΡдһȫ
+        size_t fusedPrograms;   // ɵƴӳ
+    };
+
     PostProcessing(unsigned int width, unsigned int height);
     ~PostProcessing();
 
     // ʼԴ
     bool initialize();
 
-    // עµĺЧ
-    void registerEffect(const std::string& name, const Shader& shader, std::function<void(Shader&)> configure = nullptr);
+    // ڳߴ仯ʱؽȾĿ
+    bool resize(unsigned int width, unsigned int height);
+
+    // עµĺЧsamplesNeighbors ʾЧλò
+    void registerEffect(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+        bool samplesNeighbors, std::function<void(Shader&)> configure = nullptr);
 
     // /رĳЧ
     void enableEffect(const std::string& name, bool enable);
@@ -28,6 +55,17 @@ public:
     // ȡעЧб
     std::map<std::string, bool> getEffectsState() const;
 
+    // ЧķֱʵλֻԼɫЧ
+    void setEffectTier(const std::string& name, PostCompute::Tier tier);
+    PostCompute::Tier getEffectTier(const std::string& name) const;
+
+    void setBackend(Backend value) { backend = value; }
+    Backend getBackend() const { return backend; }
+
+    // ǷƴЧرʱÿЧһ passڶԱ
+    void setFusionEnabled(bool enable) { fusionEnabled = enable; }
+    bool isFusionEnabled() const { return fusionEnabled; }
+
     // ʼ FBO
     void begin();
 
@@ -36,18 +74,71 @@ public:
 
     bool hasEnabledEffects() const;
 
+    // Ⱦţÿ(0, 1]ȾʱӿΪ getRenderWidth() x getRenderHeight()
+    void setRenderScale(float scale);
+    float getRenderScale() const { return renderScale; }
+    unsigned int getRenderWidth() const { return renderWidth; }
+    unsigned int getRenderHeight() const { return renderHeight; }
+    bool isScaled() const { return renderWidth != width || renderHeight != height; }
+
+    // ǷҪȾĿ꣨õЧҪŴ
+    bool isActive() const { return hasEnabledEffects() || isScaled(); }
+
+    // ȾĿ꣬ӳɫҪȿ
+    unsigned int getFramebuffer() const { return fbo; }
+
+    const Stats& getStats() const { return stats; }
+    const PostCompute::Stats& getComputeStats() const { return compute.getStats(); }
+
 private:
+    struct Effect {
+        std::string vertexPath;
+        std::string fragmentPath;
+        Shader shader;                          // ʹʱĳ
+        bool samplesNeighbors;
+        bool enabled;
+        PostCompute::Tier tier;
+        std::function<void(Shader&)> configure; // Զ
+    };
+
+    // һ pass ִеЧ
+    struct Segment {
+        std::vector<Effect*> effects;
+        std::string key;                        // Ч˳ '|' 
+        PostCompute::Tier tier;
+    };
+
     unsigned int width, height;
+    float renderScale = 1.0f;
+    unsigned int renderWidth, renderHeight; // ʵȾ
     unsigned int fbo, rbo, texture;       // ֡
     unsigned int quadVAO, quadVBO;       // Ļı
-    unsigned int intermediateFBO;
-    unsigned int intermediateTex;
-    std::map<std::string, Shader> effects; // 洢Ч
-    std::map<std::string, bool> effectStates; // 洢Ч״̬
-    std::map<std::string, std::function<void(Shader&)>> effectConfigurations; // Զ
+    unsigned int pingPongFBO[2];         // мΪ
+    unsigned int pingPongTex[2];
+    std::map<std::string, Effect> effects; // 洢Ч˳Ӧ
+    std::map<std::string, Shader> fusedShaders; // ƴӺĳ򣬼ΪЧϺ˳
+    std::map<std::string, Shader> computeShaders; // ɫ˵Ч
+    PostCompute compute;
+    std::unique_ptr<Shader> upscaleShader;
+    Backend backend = FRAGMENT;
+    bool fusionEnabled = true;
+    Stats stats = {};
 
     // ʼĻı
     void initQuad();
+
+    bool createTargets();
+    void releaseTargets();
+
+    // õЧΪ pass
+    std::vector<Segment> buildSegments();
+
+    // ȡ pass ʹõĳ򣬶Чʱɲƴӳ
+    Shader& shaderFor(const Segment& segment);
+    Shader& computeShaderFor(const Segment& segment);
+
+    // ƴӵƬɫɫԴ
+    static std::string generateChainSource(const Segment& segment, bool computeBackend);
 };
 
 #endif
@@ -0,0 +1,91 @@
+#include "RenderStats.h"
+
+#ifdef RENDER_STATS_ENABLED
+
+#include <iostream>
+
+RenderStats& RenderStats::instance() {
+    static RenderStats stats;
+    return stats;
+}
+
+void RenderStats::beginFrame() {
+    if (frameIndex > 0) {
+        for (int i = 0; i < PASS_COUNT; ++i) {
+            last[i] = current[i];
+        }
+        if (csv.is_open()) {
+            writeCsvRows();
+        }
+    }
+    for (Counters& counters : current) {
+        counters = {};
+    }
+    pass = SETUP;
+    ++frameIndex;
+}
+
+RenderStats::Counters RenderStats::getLastTotal() const {
+    Counters total = {};
+    for (const Counters& counters : last) {
+        total.drawCalls += counters.drawCalls;
+        total.indirectCommands += counters.indirectCommands;
+        total.triangles += counters.triangles;
+        total.dispatches += counters.dispatches;
+        total.programBinds += counters.programBinds;
+        total.textureBinds += counters.textureBinds;
+        total.uniformUpdates += counters.uniformUpdates;
+        total.uploadBytes += counters.uploadBytes;
+    }
+    return total;
+}
+
+const char* RenderStats::passName(Pass value) {
+    switch (value) {
+    case SETUP: return "Setup";
+    case SHADOW: return "Shadow";
+    case CULLING: return "Culling";
+    case GEOMETRY: return "Geometry";
+    case LIGHTING: return "Lighting";
+    case FORWARD: return "Forward";
+    case SKYBOX: return "Skybox";
+    case POST_PROCESS: return "Post-Process";
+    case UI: return "UI";
+    default: return "Unknown";
+    }
+}
+
+bool RenderStats::startCsv(const std::string& path) {
+    stopCsv();
+    csv.open(path, std::ios::trunc);
+    if (!csv.is_open()) {
+        std::cerr << "Failed to open render stats file: " << path << std::endl;
+        return false;
+    }
+    csv << "frame,pass,draw_calls,indirect_commands,triangles,dispatches,program_binds,texture_binds,"
+        "uniform_updates,upload_bytes\n";
+    csvFrames = 0;
+    std::cout << "Writing render stats to " << path << std::endl;
+    return true;
+}
+
+void RenderStats::stopCsv() {
+    if (csv.is_open()) {
+        csv.close();
+        std::cout << "Render stats: wrote " << csvFrames << " frames." << std::endl;
+    }
+}
+
+void RenderStats::writeCsvRows() {
+    // 每个通道一行，完全没有开销的通道也写出，便于按列对比
+    for (int i = 0; i < PASS_COUNT; ++i) {
+        const Counters& counters = current[i];
+        csv << frameIndex << ',' << passName(static_cast<Pass>(i)) << ',' << counters.drawCalls << ','
+            << counters.indirectCommands << ',' << counters.triangles << ',' << counters.dispatches << ','
+            << counters.programBinds << ',' << counters.textureBinds << ',' << counters.uniformUpdates << ','
+            << counters.uploadBytes << '\n';
+    }
+    ++csvFrames;
+}
+
+#endif // RENDER_STATS_ENABLED
@@ -0,0 +1,123 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// 渲染统计：每帧按通道累计绘制调用、三角形、程序 / 纹理绑定、uniform 设置和上传字节数
+// - 计数写在各个 GL 调用旁边（RENDER_STATS_* 宏），通道由 Renderer 在切换阶段时设置
+// - 默认只在 Debug 构建中启用；Release 构建（定义了 NDEBUG）中宏展开为空，类本身也不参与编译，
+//   需要在 Release 中统计时定义 RENDER_STATS_IN_RELEASE
+// - 可以把每帧每个通道的计数追加写入 CSV，用于对比改动前后的开销
+#if !defined(NDEBUG) || defined(RENDER_STATS_IN_RELEASE)
+#define RENDER_STATS_ENABLED 1
+#endif
+
+#ifdef RENDER_STATS_ENABLED
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+class RenderStats {
+public:
+    enum Pass {
+        SETUP,          // 帧开始时的数据上传（实例、光源、帧常量）
+        SHADOW,
+        CULLING,        // 相机视图的 GPU 剔除和 Hi-Z 生成
+        GEOMETRY,       // 延迟着色几何阶段
+        LIGHTING,       // 延迟着色光照阶段
+        FORWARD,
+        SKYBOX,
+        POST_PROCESS,
+        UI,             // ImGui、截图录屏和包围球
+        PASS_COUNT
+    };
+
+    struct Counters {
+        uint64_t drawCalls;         // 包括多重间接绘制，每次调用计一次
+        uint64_t indirectCommands;  // 多重间接绘制中的命令数
+        uint64_t triangles;         // 提交的三角形；间接绘制按剔除前的实例数计算
+        uint64_t dispatches;
+        uint64_t programBinds;
+        uint64_t textureBinds;
+        uint64_t uniformUpdates;
+        uint64_t uploadBytes;       // glBufferData / glBufferSubData / 持久映射写入的字节数
+    };
+
+    static RenderStats& instance();
+
+    RenderStats(const RenderStats&) = delete;
+    RenderStats& operator=(const RenderStats&) = delete;
+
+    // 结束上一帧（保存结果并写入 CSV），开始新的一帧
+    void beginFrame();
+    void setPass(Pass value) { pass = value; }
+
+    void recordDraw(uint64_t triangles) {
+        Counters& counters = current[pass];
+        ++counters.drawCalls;
+        counters.triangles += triangles;
+    }
+    void recordIndirectDraw(uint64_t commands, uint64_t triangles) {
+        Counters& counters = current[pass];
+        ++counters.drawCalls;
+        counters.indirectCommands += commands;
+        counters.triangles += triangles;
+    }
+    void recordDispatch() { ++current[pass].dispatches; }
+    void recordProgramBind() { ++current[pass].programBinds; }
+    void recordTextureBinds(uint64_t count) { current[pass].textureBinds += count; }
+    void recordUniform() { ++current[pass].uniformUpdates; }
+    void recordUpload(uint64_t bytes) { current[pass].uploadBytes += bytes; }
+
+    // 上一帧的结果
+    const Counters& getLast(Pass value) const { return last[value]; }
+    Counters getLastTotal() const;
+
+    static const char* passName(Pass value);
+
+    // 从下一帧开始把每帧的计数写入 CSV
+    bool startCsv(const std::string& path);
+    void stopCsv();
+    bool isWritingCsv() const { return csv.is_open(); }
+    uint64_t getCsvFrames() const { return csvFrames; }
+
+private:
+    RenderStats() = default;
+
+    Counters current[PASS_COUNT] = {};
+    Counters last[PASS_COUNT] = {};
+    Pass pass = SETUP;
+    uint64_t frameIndex = 0;
+
+    std::ofstream csv;
+    uint64_t csvFrames = 0;
+
+    void writeCsvRows();
+};
+
+#define RENDER_STATS_FRAME() RenderStats::instance().beginFrame()
+#define RENDER_STATS_PASS(value) RenderStats::instance().setPass(RenderStats::value)
+#define RENDER_STATS_DRAW(triangles) RenderStats::instance().recordDraw(triangles)
+#define RENDER_STATS_INDIRECT_DRAW(commands, triangles) RenderStats::instance().recordIndirectDraw(commands, triangles)
+#define RENDER_STATS_DISPATCH() RenderStats::instance().recordDispatch()
+#define RENDER_STATS_PROGRAM() RenderStats::instance().recordProgramBind()
+#define RENDER_STATS_TEXTURE() RenderStats::instance().recordTextureBinds(1)
+#define RENDER_STATS_TEXTURES(count) RenderStats::instance().recordTextureBinds(count)
+#define RENDER_STATS_UNIFORM() RenderStats::instance().recordUniform()
+#define RENDER_STATS_UPLOAD(bytes) RenderStats::instance().recordUpload(bytes)
+
+#else
+
+#define RENDER_STATS_FRAME() ((void)0)
+#define RENDER_STATS_PASS(value) ((void)0)
+#define RENDER_STATS_DRAW(triangles) ((void)0)
+#define RENDER_STATS_INDIRECT_DRAW(commands, triangles) ((void)0)
+#define RENDER_STATS_DISPATCH() ((void)0)
+#define RENDER_STATS_PROGRAM() ((void)0)
+#define RENDER_STATS_TEXTURE() ((void)0)
+#define RENDER_STATS_TEXTURES(count) ((void)0)
+#define RENDER_STATS_UNIFORM() ((void)0)
+#define RENDER_STATS_UPLOAD(bytes) ((void)0)
+
+#endif // RENDER_STATS_ENABLED
+
+#endif // RENDER_STATS_H
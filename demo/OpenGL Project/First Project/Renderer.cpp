@@ -1,3 +1,4 @@
+#ifdef _WIN32
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #define RPC_NO_WINDOWS_H
@@ -9,13 +10,22 @@
 #undef byte
 #undef FAR
 #undef near
+#endif
 
 // Renderer.cpp
 #include "Renderer.h"
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
@@ -25,21 +35,23 @@ std::vector<std::string> Renderer::availableScenes = {}; // 
 int Renderer::selectedSceneIndex = 0; // Ĭѡеĳ
 float Resolution = 5000.0f;
 float far_plane = 100.0f;
+// ̬ʼʱ¼Ϊʱ̣޴ģʽʱ𣬶Ӧģʽд glfwInit ʼ glfwGetTime
+static const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
 
 // 캯
 Renderer::Renderer(GLFWwindow* win, unsigned int width, unsigned int height, Camera& cam,
     LightManager& lm, ShadowManager& sm, Scene& sc)
-    : window(win), SCR_WIDTH(width), SCR_HEIGHT(height),
+    : SCR_WIDTH(width), SCR_HEIGHT(height), window(win), headless(win == nullptr),
     camera(cam), lightManager(lm), shadowManager(sm), scene(sc),
     lightingShader("./shaders/Model Shader.vs", "./shaders/Model Shader.fs"),
-    shadowShader("./shadow/shadow.vs", "./shadow/shadow.fs"),
-    pointshadowShader("./shadow/shadow_point.vs", "./shadow/shadow_point.fs", "./shadow/shadow_point.gs"),
+    shadowShader("./Shadow/shadow.vs", "./Shadow/shadow.fs"),
+    pointshadowShader("./Shadow/shadow_point.vs", "./Shadow/shadow_point.fs", "./Shadow/shadow_point.gs"),
+    postProcessing(width, height),
     deltaTime(0.0f), lastFrame(0.0f),
     mouseCaptured(true), lastX(width / 2.0f), lastY(height / 2.0f),
     firstMouse(true), mouseLeftButtonDown(false), selectedObject(nullptr), dragOffset(0.0f),
     debugLightView(false), debugLightIndex(0),
     debugMaterialView(false), debugMaterialIndex(0),
-    postProcessing(width, height),
     showBoundingSpheres(false), // Χʾ־
     enableSkybox(true) // Ĭպ
 {
@@ -49,23 +61,24 @@ Renderer::Renderer(GLFWwindow* win, unsigned int width, unsigned int height, Cam
 
 bool Renderer::initialize()
 {
-    if (window == nullptr) {
-        std::cerr << "Renderer received a null window pointer." << std::endl;
-        return false;
-    }
-
     std::cout << "Configuring OpenGL..." << std::endl;
     // OpenGL״̬
     configureOpenGL();
 
-    std::cout << "Setting callbacks..." << std::endl;
+    // ޴ģʽûͽ
+    if (headless) {
+        std::cout << "Running headless, input and ImGui are disabled." << std::endl;
+    }
+    else {
+        std::cout << "Setting callbacks..." << std::endl;
 
-    // ûص
-    setCallbacks();
+        // ûص
+        setCallbacks();
 
-    std::cout << "Initializing ImGui..." << std::endl;
-    // ʼ ImGui
-    initImGui();
+        std::cout << "Initializing ImGui..." << std::endl;
+        // ʼ ImGui
+        initImGui();
+    }
 
     // ʼ
     if (!postProcessing.initialize()) {
@@ -80,26 +93,20 @@ bool Renderer::initialize()
         return false;
     }
 
-    // 1) Shader
-    Shader GrayShader("./effects/post_process.vs", "./effects/post_process_Grayscale.fs");
-    Shader InvertShader("./effects/post_process.vs", "./effects/post_process_Invert.fs");
-    Shader SepiaShader("./effects/post_process.vs", "./effects/post_process_Sepia.fs");
-    Shader VignetteShader("./effects/post_process.vs", "./effects/post_process_Vignette.fs");
-    Shader RgbShiftShader("./effects/post_process.vs", "./effects/post_process_rgb_shift.fs");
-
-    // 2) עShaderϵͳ
+    // עЧЧᱻƴӵͬһ passRGB Shift Ҫ
     // ޲ڵЧֱд nullptr дûص
-    postProcessing.registerEffect("Grayscale", GrayShader, nullptr);
-    postProcessing.registerEffect("Invert", InvertShader, nullptr);
-    postProcessing.registerEffect("Sepia", SepiaShader, nullptr);
+    const std::string postVertex = "./effects/post_process.vs";
+    postProcessing.registerEffect("Grayscale", postVertex, "./effects/post_process_Grayscale.fs", false, nullptr);
+    postProcessing.registerEffect("Invert", postVertex, "./effects/post_process_Invert.fs", false, nullptr);
+    postProcessing.registerEffect("Sepia", postVertex, "./effects/post_process_Sepia.fs", false, nullptr);
 
     // ĬõЧɴʼ lambda
-    postProcessing.registerEffect("Vignette", VignetteShader, [](Shader& shader) {
+    postProcessing.registerEffect("Vignette", postVertex, "./effects/post_process_Vignette.fs", false, [](Shader& shader) {
         shader.setFloat("radius", 0.5f);  // ʼǰ뾶
         shader.setFloat("softness", 0.2f);  // ʼͶ
     });
 
-    postProcessing.registerEffect("RGB Shift", RgbShiftShader, [](Shader& shader) {
+    postProcessing.registerEffect("RGB Shift", postVertex, "./effects/post_process_rgb_shift.fs", true, [](Shader& shader) {
         shader.setFloat("strength", 0.01f); // ʼɫǿ
     });
 
@@ -107,7 +114,9 @@ bool Renderer::initialize()
     captureManager = std::make_unique<CaptureManager>(SCR_WIDTH, SCR_HEIGHT);
 
     //  Renderer ڵûָ
-    glfwSetWindowUserPointer(window, this);
+    if (!headless) {
+        glfwSetWindowUserPointer(window, this);
+    }
 
     // ʼɫ
     basicShader = std::make_unique<Shader>("./shaders/basic.vs", "./shaders/basic.fs");
@@ -123,13 +132,68 @@ bool Renderer::initialize()
         return false;
     }
 
+    // ԴӰ޼ɫ·ʹöɫѡ㣬
+    pointShadowFaceShader = std::make_unique<Shader>("./Shadow/shadow_point_face.vs", "./Shadow/shadow_point.fs");
+    if (ShadowManager::supportsVertexLayer()) {
+        pointShadowLayeredShader = std::make_unique<Shader>("./Shadow/shadow_point_layered.vs", "./Shadow/shadow_point.fs");
+        shadowManager.setPointShadowPath(PointShadowPath::VertexLayer);
+    }
+    else {
+        shadowManager.setPointShadowPath(PointShadowPath::PerFace);
+    }
+
+    // ӳɫԴ
+    gBuffer = std::make_unique<GBuffer>(SCR_WIDTH, SCR_HEIGHT);
+    if (!gBuffer->initialize()) {
+        std::cerr << "Failed to initialize G-buffer, deferred shading disabled." << std::endl;
+        gBuffer.reset();
+    }
+    gBufferShader = std::make_unique<Shader>("./shaders/Model Shader.vs", "./shaders/gbuffer.fs");
+
+    // ڵ޳õȽ
+    hiZBuffer = std::make_unique<HiZBuffer>(SCR_WIDTH, SCR_HEIGHT);
+    if (!hiZBuffer->initialize()) {
+        std::cerr << "Failed to initialize Hi-Z buffer, occlusion culling disabled." << std::endl;
+        hiZBuffer.reset();
+    }
+    deferredLightingShader = std::make_unique<Shader>("./shaders/deferred_lighting.vs", "./shaders/deferred_lighting.fs");
+
+    // ׶εɫȫύȴбɲ
+    ShaderCache::instance().finishPending();
+
+    // Ӱ̶ռ 16~19 Ԫֻһ
+    for (Shader* shader : { &lightingShader, deferredLightingShader.get() }) {
+        shader->use();
+        shader->setInt("shadowMapArray", 16);
+        shader->setInt("shadowCubeArray", 17);
+        // 18/19 ŵԪͬʹòȽϵĲȡԭʼ
+        shader->setInt("shadowDepthArray", 18);
+        shader->setInt("shadowDepthCubeArray", 19);
+    }
+
+    // ɫ״õʱ룻ǰͬҪӰԪ
+    forwardVariants = std::make_unique<ShaderVariants>("./shaders/Model Shader.vs", "./shaders/Model Shader.fs",
+        ShaderVariants::ALL_FEATURES, [](Shader& shader) {
+            shader.setInt("shadowMapArray", 16);
+            shader.setInt("shadowCubeArray", 17);
+            shader.setInt("shadowDepthArray", 18);
+            shader.setInt("shadowDepthCubeArray", 19);
+        });
+    gBufferVariants = std::make_unique<ShaderVariants>("./shaders/Model Shader.vs", "./shaders/gbuffer.fs",
+        ShaderVariants::SKINNED | ShaderVariants::INSTANCED | ShaderVariants::MATERIAL_MAP_MASK);
+
+    // G-buffer ռ 0~2 Ԫ
+    deferredLightingShader->setInt("gAlbedoAO", 0);
+    deferredLightingShader->setInt("gNormalMR", 1);
+    deferredLightingShader->setInt("gDepth", 2);
+
     std::cout << "Renderer initialized successfully." << std::endl;
     return true;
 }
 
 void Renderer::configureOpenGL()
 {
-    glEnable(GL_DEPTH_TEST);
+    GL_STATE.enable(GL_DEPTH_TEST);
 }
 
 void Renderer::initImGui()
@@ -162,21 +226,22 @@ void Renderer::setCallbacks()
 void Renderer::run()
 {
     std::cout << "Starting render loop..." << std::endl;
+    bool firstFrame = true;
     while (!glfwWindowShouldClose(window))
     {
+        CPU_PROFILE_SCOPE("Frame");
+
         // ʱ
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        CpuProfiler::instance().recordFrameTime(deltaTime * 1000.0f);
 
         //std::cout << "Frame time: " << deltaTime << " seconds." << std::endl;
 
         // 
         processInput();
 
-        // Ӱͼ
-        updateShadowMaps();
-
         // ³
         scene.update(deltaTime, lightingShader);
 
@@ -184,8 +249,20 @@ void Renderer::run()
         renderFrame();
 
         // ѯ¼
+        CPU_PROFILE_BEGIN("Swap Buffers");
         glfwSwapBuffers(window);
+        CPU_PROFILE_END();
         glfwPollEvents();
+
+        // ʱGLFW ʱ glfwInit ʼȵһ֡ɺټ¼
+        if (firstFrame) {
+            firstFrame = false;
+            glFinish();
+            const ShaderCache::Stats& shaderStats = ShaderCache::instance().getStats();
+            std::cout << "Time to first frame: " << glfwGetTime() * 1000.0 << " ms (shader programs: "
+                << shaderStats.compiled << " compiled, " << shaderStats.loaded << " from cache, "
+                << shaderStats.submitMs + shaderStats.finishMs << " ms)" << std::endl;
+        }
     }
 
     std::cout << "Exiting render loop." << std::endl;
@@ -194,10 +271,80 @@ void Renderer::run()
     cleanup();
 }
 
-void Renderer::renderFrame()
+bool Renderer::runHeadless(int frameCount, float frameTime, bool validateCulling)
 {
+    std::cout << "Rendering " << frameCount << " headless frames..." << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+    auto previous = start;
+    hasCullingValidation = false;
+    for (int frame = 0; frame < frameCount; ++frame) {
+        // һ֡ Hi-Z һ֡׶ڵԶᱻǵ
+        validateCullingRequested = validateCulling && frame == frameCount - 1;
+        renderHeadlessFrame(frameTime);
+
+        // ûнȴ GPU ɺټʱ
+        glFinish();
+        auto now = std::chrono::high_resolution_clock::now();
+        double frameMs = std::chrono::duration<double, std::milli>(now - previous).count();
+        previous = now;
+        CpuProfiler::instance().recordFrameTime(static_cast<float>(frameMs));
+        // ʱĴɫͳأ봰ģʽһ
+        if (frame == 0) {
+            double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+            const ShaderCache::Stats& shaderStats = ShaderCache::instance().getStats();
+            std::cout << "Time to first frame: " << startupMs << " ms (first frame " << frameMs << " ms, shader programs: "
+                << shaderStats.compiled << " compiled, " << shaderStats.loaded << " from cache, "
+                << shaderStats.submitMs + shaderStats.finishMs << " ms)" << std::endl;
+        }
+    }
+
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (frameCount > 0) {
+        std::cout << "Rendered " << frameCount << " frames in " << totalMs << " ms ("
+            << totalMs / frameCount << " ms/frame, p95 "
+            << CpuProfiler::instance().getFrameTimePercentile(0.95f) << " ms)" << std::endl;
+    }
 
-    // ImGui֡
+    if (!validateCulling || !hasCullingValidation) {
+        return true;
+    }
+    const GpuCulling::ValidationResult& result = lastCullingValidation;
+    std::cout << "GPU culling validation: " << result.gpuVisible << " / " << result.cpuVisible
+        << " visible (GPU / CPU) of " << result.instances << " instances, "
+        << result.mismatchedCommands << " mismatched commands" << std::endl;
+    if (result.mismatchedCommands != 0) {
+        std::cerr << "GPU culling does not match the CPU reference." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Renderer::renderHeadlessFrame(float frameTime)
+{
+    CPU_PROFILE_SCOPE("Frame");
+
+    // ̶ʱ䲽ʵʺʱ޹أظ
+    deltaTime = frameTime;
+    lastFrame += frameTime;
+
+    if (gameLogicCallback) {
+        gameLogicCallback();
+    }
+    scene.update(deltaTime, lightingShader);
+    renderFrame();
+}
+
+bool Renderer::captureScreenshot(const std::string& directory)
+{
+    return captureManager && captureManager->captureScreen(directory);
+}
+
+void Renderer::buildUI()
+{
+    CPU_PROFILE_SCOPE("Build UI");
+    GpuProfiler& profiler = GpuProfiler::instance();
+
+    // ImGui֡Ϊ湹
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -301,6 +448,37 @@ void Renderer::renderFrame()
                         }
                     }
                 }
+
+                ImGui::Separator();
+                int backend = postProcessing.getBackend();
+                if (ImGui::Combo("Backend", &backend, "Fragment (Quad)\0Compute (16x16 Tiles)\0")) {
+                    postProcessing.setBackend(static_cast<PostProcessing::Backend>(backend));
+                }
+                bool fuse = postProcessing.isFusionEnabled();
+                if (ImGui::Checkbox("Fuse Per-Pixel Effects", &fuse)) {
+                    postProcessing.setFusionEnabled(fuse);
+                }
+
+                // ֱʵλֻԼɫЧ
+                if (backend == PostProcessing::COMPUTE && ImGui::TreeNode("Quality Tiers")) {
+                    for (const auto& effect : effectsState) {
+                        int tier = postProcessing.getEffectTier(effect.first);
+                        if (ImGui::Combo(effect.first.c_str(), &tier, "Full\0Half\0Quarter\0")) {
+                            postProcessing.setEffectTier(effect.first, static_cast<PostCompute::Tier>(tier));
+                        }
+                    }
+                    ImGui::TreePop();
+                }
+
+                const PostProcessing::Stats& postStats = postProcessing.getStats();
+                ImGui::Text("Effects: %d, Passes: %d", postStats.effects, postStats.passes);
+                if (backend == PostProcessing::COMPUTE) {
+                    const PostCompute::Stats& computeStats = postProcessing.getComputeStats();
+                    ImGui::Text("Dispatches: %d, Blits: %d", computeStats.dispatches, computeStats.blits);
+                }
+                ImGui::Text("Texture Traffic: %.1f MB/frame", postStats.bytes / (1024.0 * 1024.0));
+                ImGui::Text("Fused Programs: %zu", postStats.fusedPrograms);
+                ImGui::Text("Post-Processing GPU: %.3f ms", GpuProfiler::instance().getLastMs("Frame/Post-Processing"));
             }
 
         }
@@ -369,6 +547,188 @@ void Renderer::renderFrame()
 
         ImGui::Separator();
 
+        //------------------------------------------------------
+        // Ӱ
+        //------------------------------------------------------
+        {
+            int cascades = shadowManager.getCascadeCount();
+            if (ImGui::SliderInt("Shadow Cascades", &cascades, 2, 4)) {
+                shadowManager.setCascadeCount(cascades);
+            }
+            float lambda = shadowManager.getCascadeSplitLambda();
+            if (ImGui::SliderFloat("Cascade Split Lambda", &lambda, 0.0f, 1.0f)) {
+                shadowManager.setCascadeSplitLambda(lambda);
+            }
+            float distance = shadowManager.getShadowDistance();
+            if (ImGui::SliderFloat("Shadow Distance", &distance, 10.0f, 100.0f)) {
+                shadowManager.setShadowDistance(distance);
+            }
+
+            // ԴӰ·лԱ GPU ʱ
+            const char* pathNames[] = { "Geometry Shader", "Vertex Layer", "Per Face" };
+            int path = static_cast<int>(shadowManager.getPointShadowPath());
+            if (ImGui::Combo("Point Shadow Path", &path, pathNames, IM_ARRAYSIZE(pathNames))) {
+                if (path == static_cast<int>(PointShadowPath::VertexLayer) && !pointShadowLayeredShader) {
+                    std::cerr << "Vertex layer output is not supported by this driver." << std::endl;
+                }
+                else {
+                    shadowManager.setPointShadowPath(static_cast<PointShadowPath>(path));
+                }
+            }
+            ImGui::Text("Point Shadow GPU: %.3f ms", GpuProfiler::instance().getLastMs("Frame/Shadows/Point Lights"));
+
+            // Ӱ˵λ
+            const char* qualityNames[] = { "Hard", "PCF 4-tap", "Poisson 16-tap", "PCSS" };
+            ImGui::Combo("Shadow Filter", &shadowQuality, qualityNames, IM_ARRAYSIZE(qualityNames));
+            if (shadowQuality == 3) {
+                ImGui::SliderFloat("PCSS Light Size", &pcssLightSize, 0.001f, 0.05f);
+            }
+        }
+
+        ImGui::Separator();
+
+        //------------------------------------------------------
+        // Ⱦ·ǰ / ӳɫԱ
+        //------------------------------------------------------
+        {
+            ImGui::Checkbox("Deferred Shading", &deferredShading);
+            if (deferredShading && !gBuffer) {
+                ImGui::Text("G-buffer unavailable, using forward shading.");
+            }
+            if (deferredShading && (debugLightView || debugMaterialView)) {
+                ImGui::Text("Debug views use the forward path.");
+            }
+            // ׶κʱȡ GpuProfilerر GPU ʱΪ 0
+            const GpuProfiler& gpuProfiler = GpuProfiler::instance();
+            ImGui::Text("Forward Pass GPU: %.3f ms", gpuProfiler.getLastMs("Frame/Forward"));
+            ImGui::Text("G-buffer Pass GPU: %.3f ms", gpuProfiler.getLastMs("Frame/G-buffer"));
+            ImGui::Text("Deferred Lighting GPU: %.3f ms", gpuProfiler.getLastMs("Frame/Deferred Lighting"));
+
+            // ֱ̬
+            if (ImGui::TreeNode("Dynamic Resolution")) {
+                ImGui::Checkbox("Enabled", &dynamicResolution.enabled);
+                ImGui::SliderFloat("GPU Budget (ms)", &dynamicResolution.targetMs, 4.0f, 50.0f);
+                ImGui::SliderFloat("Min Scale", &dynamicResolution.minScale, 0.25f, 1.0f);
+                ImGui::Text("Frame GPU: %.3f ms", gpuProfiler.getLastMs("Frame"));
+                ImGui::Text("Render Scale: %.0f%% (%u x %u)", postProcessing.getRenderScale() * 100.0f,
+                    renderWidth, renderHeight);
+                ImGui::TreePop();
+            }
+
+            // ɫ壺ÿĲֵͳСͳҪ룬ִ
+            ImGui::Checkbox("Shader Permutations", &shaderPermutations);
+            if (shaderPermutations) {
+                ImGui::Text("Program Switches: %zu", scene.getLastProgramSwitchCount());
+                for (ShaderVariants* variants : { forwardVariants.get(), gBufferVariants.get() }) {
+                    const char* label = variants == forwardVariants.get() ? "Forward Variants" : "G-buffer Variants";
+                    if (ImGui::TreeNode(label, "%s: %zu (%.1f ms compile)", label,
+                        variants->getVariantCount(), variants->getTotalCompileMs())) {
+                        if (ImGui::Button("Analyze")) {
+                            variants->analyze();
+                        }
+                        for (const ShaderVariants::VariantInfo& info : variants->getVariantInfos()) {
+                            if (info.analyzed) {
+                                ImGui::Text("%s: VS out %d (%d comp), FS in %d (%d comp), %d uniforms, %d bytes",
+                                    info.name.c_str(), info.vertexOutputs, info.vertexOutputComponents,
+                                    info.fragmentInputs, info.fragmentInputComponents, info.activeUniforms, info.binarySize);
+                            }
+                            else {
+                                ImGui::Text("%s: %.1f ms", info.name.c_str(), info.compileMs);
+                            }
+                        }
+                        ImGui::TreePop();
+                    }
+                }
+            }
+        }
+
+        ImGui::Separator();
+
+        //------------------------------------------------------
+        // ʵ
+        //------------------------------------------------------
+        {
+            bool instancing = scene.isInstancingEnabled();
+            if (ImGui::Checkbox("Instanced Rendering", &instancing)) {
+                scene.setInstancingEnabled(instancing);
+            }
+            ImGui::Text("Objects: %zu, Draw Calls: %zu", scene.getGameObjects().size(), scene.getLastDrawCallCount());
+            ImGui::Text("Indirect Commands: %zu, Material Buckets: %zu",
+                scene.getIndirectCommandCount(), scene.getMaterialBucketCount());
+
+            // ȫּλʹ
+            GeometryArena::Stats arenaStats = GeometryArena::instance().getStats();
+            ImGui::Text("Geometry: %zu meshes", arenaStats.allocations);
+            ImGui::Text("Vertices: %zu / %zu, free blocks %zu, fragmentation %.2f",
+                arenaStats.vertexUsed, arenaStats.vertexCapacity, arenaStats.vertexFreeBlocks, arenaStats.vertexFragmentation);
+            ImGui::Text("Indices: %zu / %zu, free blocks %zu, fragmentation %.2f",
+                arenaStats.indexUsed, arenaStats.indexCapacity, arenaStats.indexFreeBlocks, arenaStats.indexFragmentation);
+            ImGui::Text("Defragments: %zu, Grows: %zu", arenaStats.defragmentCount, arenaStats.growCount);
+            if (ImGui::Button("Defragment Geometry")) {
+                GeometryArena::instance().defragment();
+            }
+
+            // 壺֡д峣Ͳ
+            FrameUniforms::Stats uniformStats = FrameUniforms::instance().getStats();
+            ImGui::Text("Object Constants: %zu (%zu bytes), Materials: %zu",
+                uniformStats.objectsWritten, uniformStats.objectBytes, uniformStats.materialsWritten);
+            ImGui::Text("Constant Ring: %zu KB, Wraps: %zu", uniformStats.ringCapacity / 1024, uniformStats.ringWraps);
+
+            // GPU ޳
+            bool gpuCulling = scene.isGpuCullingEnabled();
+            if (ImGui::Checkbox("GPU Culling", &gpuCulling)) {
+                scene.setGpuCullingEnabled(gpuCulling);
+            }
+            if (gpuCulling) {
+                ImGui::Checkbox("Hi-Z Occlusion Culling", &occlusionCulling);
+                if (ImGui::Button("Validate Against CPU")) {
+                    validateCullingRequested = true;
+                }
+                if (hasCullingValidation) {
+                    const auto& result = lastCullingValidation;
+                    ImGui::Text("Visible GPU/CPU: %zu / %zu of %zu", result.gpuVisible, result.cpuVisible, result.instances);
+                    if (result.mismatchedCommands == 0) {
+                        ImGui::TextColored(ImVec4(0, 1, 0, 1), "GPU culling matches CPU.");
+                    }
+                    else {
+                        ImGui::TextColored(ImVec4(1, 0, 0, 1), "Mismatched commands: %zu", result.mismatchedCommands);
+                    }
+                }
+            }
+
+            // CPU ڵ޳
+            ImGui::Checkbox("CPU Occlusion Culling", &softwareOcclusionEnabled);
+            if (softwareOcclusionEnabled) {
+                float coverage = scene.getAutoOccluderCoverage() * 100.0f;
+                if (ImGui::SliderFloat("Auto Occluder Coverage (%)", &coverage, 0.5f, 50.0f)) {
+                    scene.setAutoOccluderCoverage(coverage / 100.0f);
+                }
+                const SoftwareOcclusion::Stats& occlusionStats = softwareOcclusion.getStats();
+                ImGui::Text("Occluders: %zu, Triangles: %zu", occlusionStats.occluders, occlusionStats.triangles);
+                ImGui::Text("Occluded: %zu / %zu, Raster: %.3f ms (%d threads)",
+                    occlusionStats.culled, occlusionStats.tested, occlusionStats.rasterMs, softwareOcclusion.getWorkerCount());
+            }
+
+            // ѹԣ100 x 100 Уͬһģ
+            if (ImGui::Button("Add 10k Cubes")) {
+                for (int z = 0; z < 100; ++z) {
+                    for (int x = 0; x < 100; ++x) {
+                        std::string name = "StressCube_" + std::to_string(z * 100 + x);
+                        glm::vec3 position(-50.0f + x * 1.0f, 0.25f, -50.0f + z * 1.0f);
+                        auto cube = std::make_shared<GameObject>(name, "./resources/objects/Cube/Cube.obj",
+                            position, glm::vec3(0.4f));
+                        // ÿʵͬĴֲڶȣ֤ʵǵĲʳ
+                        PBRMaterial material = cube->getPBRMaterial(0);
+                        material.roughness = 0.1f + 0.8f * (x / 99.0f);
+                        cube->setPBRMaterial(0, material);
+                        scene.addGameObject(cube);
+                    }
+                }
+            }
+        }
+
+        ImGui::Separator();
+
         //------------------------------------------------------
         // ʲ༭
         //------------------------------------------------------
@@ -421,7 +781,9 @@ void Renderer::renderFrame()
                 // ȡѡĲ
                 const auto& selectedObjPtr = gameObjects[selectedObjectM];
                 if (selectedMesh < selectedObjPtr->getModel().meshes.size()) {
-                    PBRMaterial& material = selectedObjPtr->getPBRMaterial(selectedMesh);
+                    // ༭ֻпؼĶֵдأİ汾Ųÿ֡仯
+                    PBRMaterial material = selectedObjPtr->getPBRMaterial(selectedMesh);
+                    bool changed = false;
 
                     ImGui::Separator();
                     ImGui::Text("Editing: %s - Mesh %d",
@@ -431,10 +793,11 @@ void Renderer::renderFrame()
                     float albedo[3] = { material.albedo.r, material.albedo.g, material.albedo.b };
                     if (ImGui::ColorEdit3("Albedo", albedo)) {
                         material.albedo = glm::vec3(albedo[0], albedo[1], albedo[2]);
+                        changed = true;
                     }
-                    ImGui::SliderFloat("Metallic", &material.metallic, 0.0f, 1.0f);
-                    ImGui::SliderFloat("Roughness", &material.roughness, 0.05f, 1.0f);
-                    ImGui::SliderFloat("AO", &material.ao, 0.0f, 1.0f);
+                    changed |= ImGui::SliderFloat("Metallic", &material.metallic, 0.0f, 1.0f);
+                    changed |= ImGui::SliderFloat("Roughness", &material.roughness, 0.05f, 1.0f);
+                    changed |= ImGui::SliderFloat("AO", &material.ao, 0.0f, 1.0f);
 
                     bool hasAlbedo = (material.albedoMap != 0);
                     bool hasMetallic = (material.metallicMap != 0);
@@ -443,35 +806,39 @@ void Renderer::renderFrame()
                     bool hasAO = (material.aoMap != 0);
 
                     if (hasAlbedo) {
-                        ImGui::Checkbox("Use Albedo Map", &material.useAlbedoMap);
+                        changed |= ImGui::Checkbox("Use Albedo Map", &material.useAlbedoMap);
                     }
                     else {
                         ImGui::Text("Use Albedo Map: No Texture");
                     }
                     if (hasMetallic) {
-                        ImGui::Checkbox("Use Metallic Map", &material.useMetallicMap);
+                        changed |= ImGui::Checkbox("Use Metallic Map", &material.useMetallicMap);
                     }
                     else {
                         ImGui::Text("Use Metallic Map: No Texture");
                     }
                     if (hasRoughness) {
-                        ImGui::Checkbox("Use Roughness Map", &material.useRoughnessMap);
+                        changed |= ImGui::Checkbox("Use Roughness Map", &material.useRoughnessMap);
                     }
                     else {
                         ImGui::Text("Use Roughness Map: No Texture");
                     }
                     if (hasNormal) {
-                        ImGui::Checkbox("Use Normal Map", &material.useNormalMap);
+                        changed |= ImGui::Checkbox("Use Normal Map", &material.useNormalMap);
                     }
                     else {
                         ImGui::Text("Use Normal Map: No Texture");
                     }
                     if (hasAO) {
-                        ImGui::Checkbox("Use AO Map", &material.useAOMap);
+                        changed |= ImGui::Checkbox("Use AO Map", &material.useAOMap);
                     }
                     else {
                         ImGui::Text("Use AO Map: No Texture");
                     }
+
+                    if (changed) {
+                        selectedObjPtr->setPBRMaterial(selectedMesh, material);
+                    }
                 }
             }
             else {
@@ -520,6 +887,10 @@ void Renderer::renderFrame()
                 if (ImGui::DragFloat3("Rotation", &rotation.x, 1.0f, 0.0f, 360.0f)) {
                     targetObj->setRotation(rotation);
                 }
+                bool occluder = targetObj->isOccluder();
+                if (ImGui::Checkbox("Occluder", &occluder)) {
+                    targetObj->setOccluder(occluder);
+                }
 
                 // ɾ
                 if (ImGui::Button("Delete This Model")) {
@@ -577,11 +948,12 @@ void Renderer::renderFrame()
                 if (ImGui::Button("Export as OBJ...")) {
                     char filename[128] = "";
                     std::string defaultName = selectedObject->getName() + ".obj";
-                    strcpy_s(filename, sizeof(filename), defaultName.c_str());
+                    std::snprintf(filename, sizeof(filename), "%s", defaultName.c_str());
 
                     // ¼ǰ·
                     auto originalPath = std::filesystem::current_path();
 
+#ifdef _WIN32
                     // ļԻ
                     OPENFILENAMEA ofn;
                     ZeroMemory(&ofn, sizeof(ofn));
@@ -594,7 +966,12 @@ void Renderer::renderFrame()
                     ofn.Flags = OFN_OVERWRITEPROMPT;
                     ofn.lpstrDefExt = "obj";
 
-                    if (GetSaveFileNameA(&ofn)) {
+                    bool confirmed = GetSaveFileNameA(&ofn) != 0;
+#else
+                    // ƽ̨ûϵͳԻֱӵĿ¼µĬļ
+                    bool confirmed = true;
+#endif
+                    if (confirmed) {
                         if (exportToObj(selectedObject, filename)) {
                             std::cout << "Object exported successfully to: " << filename << std::endl;
                         }
@@ -722,7 +1099,6 @@ void Renderer::renderFrame()
         //------------------------------------------------------
         {
             ImGui::Text("Scene Lights");
-            auto& lights = lightManager.getLights();
 
             // ӹԴ
             static int selectedLightType = 0;
@@ -734,98 +1110,110 @@ void Renderer::renderFrame()
             if (ImGui::Button("Add Light")) {
                 if (selectedLightType == 0) {
                     // 
-                    auto dirLight = std::make_shared<DirectionalLight>(
+                    lightManager.addLight(DirectionalLight(
                         glm::vec3(-1.0f, -1.0f, -1.0f),
-                        glm::vec3(1.0f));
-                    lightManager.addLight(dirLight);
-                    shadowManager.syncShadowDataWithLights(lightManager.getRawLights()); // ͬ ShadowManager
+                        glm::vec3(1.0f)));
                 }
                 else if (selectedLightType == 1) {
                     // Դ
-                    auto pointLight = std::make_shared<PointLight>(
+                    lightManager.addLight(PointLight(
                         glm::vec3(0.0f, 5.0f, 0.0f),
-                        glm::vec3(1.0f));
-                    lightManager.addLight(pointLight);
-                    shadowManager.syncShadowDataWithLights(lightManager.getRawLights()); // ͬ ShadowManager
+                        glm::vec3(1.0f)));
                 }
                 else if (selectedLightType == 2) {
                     // ۹
-                    auto spotLight = std::make_shared<SpotLight>(
+                    lightManager.addLight(SpotLight(
                         glm::vec3(0.0f, 5.0f, 0.0f),
                         glm::vec3(0.0f, -1.0f, 0.0f),
-                        glm::vec3(1.0f), 1.0f, 45.0f);
-                    lightManager.addLight(spotLight);
-                    shadowManager.syncShadowDataWithLights(lightManager.getRawLights()); // ͬ ShadowManager
+                        glm::vec3(1.0f), 1.0f, 45.0f));
+                }
+            }
+
+            // ԴڲԷִعգֻǰ 16 ԴͶӰ
+            if (ImGui::Button("Add 64 Random Lights")) {
+                for (int n = 0; n < 64; ++n) {
+                    glm::vec3 position(
+                        (std::rand() / (float)RAND_MAX - 0.5f) * 40.0f,
+                        0.5f + (std::rand() / (float)RAND_MAX) * 4.0f,
+                        (std::rand() / (float)RAND_MAX - 0.5f) * 40.0f);
+                    glm::vec3 color(
+                        std::rand() / (float)RAND_MAX,
+                        std::rand() / (float)RAND_MAX,
+                        std::rand() / (float)RAND_MAX);
+                    PointLight pointLight(position, color, 0.5f);
+                    pointLight.range = 4.0f + (std::rand() / (float)RAND_MAX) * 4.0f;
+                    lightManager.addLight(pointLight);
                 }
             }
+            ImGui::Text("Lights: %zu, Cluster Light Indices: %zu",
+                lightManager.getLightCount(),
+                lightManager.getBinning().getLightIndices().size());
+            ImGui::Text("Light Entries Uploaded: %zu", lightManager.getLastUploadCount());
+
+            // ༭ɾԴѡУɾԴָͬһԴ
+            static LightHandle selectedLight;
+            if (lightManager.getLightCount() > 0) {
+                if (!lightManager.isValid(selectedLight)) {
+                    selectedLight = lightManager.getHandle(0);
+                }
 
-            // ༭ɾԴ
-            static int lightSelectedIndex = 0;
-            if (!lights.empty()) {
                 // б
                 ImGui::BeginChild("Light List", ImVec2(0, 200), true);
-                for (int i = 0; i < (int)lights.size(); ++i) {
+                for (size_t i = 0; i < lightManager.getLightCount(); ++i) {
+                    LightHandle handle = lightManager.getHandle(i);
                     std::string label = "Light " + std::to_string(i);
-                    if (lights[i]->getType() == LightType::Directional) label += " (Directional)";
-                    else if (lights[i]->getType() == LightType::Point) label += " (Point)";
-                    else if (lights[i]->getType() == LightType::Spot) label += " (Spot)";
-                    bool isSelected = (i == lightSelectedIndex);
+                    if (lightManager.getType(handle) == LightType::Directional) label += " (Directional)";
+                    else if (lightManager.getType(handle) == LightType::Point) label += " (Point)";
+                    else if (lightManager.getType(handle) == LightType::Spot) label += " (Spot)";
+                    bool isSelected = (handle == selectedLight);
                     if (ImGui::Selectable(label.c_str(), isSelected)) {
-                        lightSelectedIndex = i;
+                        selectedLight = handle;
                     }
                 }
                 ImGui::EndChild();
 
                 ImGui::Text("Light Controls");
-                auto& selectedLight = lights[lightSelectedIndex];
-                auto lightType = selectedLight->getType();
-                glm::vec3 color = selectedLight->getColor();
-                float intensity = selectedLight->getIntensity();
-
-                // ͨɫǿ
-                if (ImGui::ColorEdit3("LightColor", &color.x)) {
-                    selectedLight->setColor(color);
-                }
-                if (ImGui::SliderFloat("LightIntensity", &intensity, 0.0f, 10.0f)) {
-                    selectedLight->setIntensity(intensity);
-                }
 
-                // ʾͬ
+                // ʾͬݣ༭ֻпؼĶֵʱдأдػøùԴϴ
+                LightType lightType = lightManager.getType(selectedLight);
+                bool changed = false;
                 if (lightType == LightType::Directional) {
-                    glm::vec3 direction = selectedLight->getDirection();
-                    if (ImGui::DragFloat3("LightDirection", &direction.x, 0.1f)) {
-                        selectedLight->setDirection(direction);
+                    DirectionalLight light = lightManager.getLight<DirectionalLight>(selectedLight);
+                    changed |= ImGui::ColorEdit3("LightColor", &light.color.x);
+                    changed |= ImGui::SliderFloat("LightIntensity", &light.intensity, 0.0f, 10.0f);
+                    changed |= ImGui::DragFloat3("LightDirection", &light.direction.x, 0.1f);
+                    if (changed) {
+                        lightManager.setLight(selectedLight, light);
                     }
                 }
                 else if (lightType == LightType::Point) {
-                    glm::vec3 position = selectedLight->getPosition();
-                    if (ImGui::DragFloat3("LightPosition", &position.x, 0.1f)) {
-                        selectedLight->setPosition(position);
+                    PointLight light = lightManager.getLight<PointLight>(selectedLight);
+                    changed |= ImGui::ColorEdit3("LightColor", &light.color.x);
+                    changed |= ImGui::SliderFloat("LightIntensity", &light.intensity, 0.0f, 10.0f);
+                    changed |= ImGui::DragFloat3("LightPosition", &light.position.x, 0.1f);
+                    changed |= ImGui::SliderFloat("Light Range", &light.range, 0.5f, 100.0f);
+                    if (changed) {
+                        lightManager.setLight(selectedLight, light);
                     }
                 }
                 else if (lightType == LightType::Spot) {
-                    glm::vec3 position = selectedLight->getPosition();
-                    glm::vec3 direction = selectedLight->getDirection();
-                    if (ImGui::DragFloat3("LightPosition", &position.x, 0.1f)) {
-                        selectedLight->setPosition(position);
-                    }
-                    if (ImGui::DragFloat3("LightDirection", &direction.x, 0.1f)) {
-                        selectedLight->setDirection(direction);
-                    }
+                    SpotLight light = lightManager.getLight<SpotLight>(selectedLight);
+                    changed |= ImGui::ColorEdit3("LightColor", &light.color.x);
+                    changed |= ImGui::SliderFloat("LightIntensity", &light.intensity, 0.0f, 10.0f);
+                    changed |= ImGui::DragFloat3("LightPosition", &light.position.x, 0.1f);
+                    changed |= ImGui::DragFloat3("LightDirection", &light.direction.x, 0.1f);
                     // ۹ƵCutoff
-                    float cutoffAngle = dynamic_cast<SpotLight*>(selectedLight.get())->getCutoffAngle();
-                    if (ImGui::SliderFloat("Cutoff Angle", &cutoffAngle, 1.0f, 90.0f)) {
-                        dynamic_cast<SpotLight*>(selectedLight.get())->setCutoffAngle(cutoffAngle);
+                    changed |= ImGui::SliderFloat("Cutoff Angle", &light.cutoffAngle, 1.0f, 90.0f);
+                    changed |= ImGui::SliderFloat("Light Range", &light.range, 0.5f, 100.0f);
+                    if (changed) {
+                        lightManager.setLight(selectedLight, light);
                     }
                 }
 
                 // ɾùԴ
                 if (ImGui::Button("Delete This Light")) {
-                    if (lightSelectedIndex >= 0 && lightSelectedIndex < lightManager.getLightCount()) {
-                        lightManager.removeLight(lightSelectedIndex);
-                        shadowManager.syncShadowDataWithLights(lightManager.getRawLights());
-                        lightSelectedIndex = std::max(0, lightSelectedIndex - 1); // ¹Դ
-                    }
+                    lightManager.removeLight(selectedLight);
+                    selectedLight = LightHandle();
                 }
             }
             else {
@@ -833,6 +1221,176 @@ void Renderer::renderFrame()
             }
         }
 
+        //------------------------------------------------------
+        // Ⱦͳƣֻ RENDER_STATS_ENABLED ĹУ
+        //------------------------------------------------------
+
+#ifdef RENDER_STATS_ENABLED
+        ImGui::Separator(); // ָ
+
+        if (ImGui::CollapsingHeader("Render Statistics")) {
+            RenderStats& renderStats = RenderStats::instance();
+            RenderStats::Counters total = renderStats.getLastTotal();
+            ImGui::Text("Draw Calls: %llu (%llu indirect commands)", (unsigned long long)total.drawCalls,
+                (unsigned long long)total.indirectCommands);
+            ImGui::Text("Triangles: %llu", (unsigned long long)total.triangles);
+            ImGui::Text("Program / Texture Binds: %llu / %llu", (unsigned long long)total.programBinds,
+                (unsigned long long)total.textureBinds);
+            ImGui::Text("Uniform Updates: %llu", (unsigned long long)total.uniformUpdates);
+            ImGui::Text("Uploads: %.1f KB, Dispatches: %llu", total.uploadBytes / 1024.0,
+                (unsigned long long)total.dispatches);
+
+            // ͨϸ
+            if (ImGui::BeginTable("RenderStatsTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Pass");
+                ImGui::TableSetupColumn("Draws");
+                ImGui::TableSetupColumn("Tris");
+                ImGui::TableSetupColumn("Prog");
+                ImGui::TableSetupColumn("Tex");
+                ImGui::TableSetupColumn("Unif");
+                ImGui::TableSetupColumn("KB");
+                ImGui::TableHeadersRow();
+                for (int i = 0; i < RenderStats::PASS_COUNT; ++i) {
+                    const RenderStats::Counters& counters = renderStats.getLast(static_cast<RenderStats::Pass>(i));
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", RenderStats::passName(static_cast<RenderStats::Pass>(i)));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", (unsigned long long)counters.drawCalls);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", (unsigned long long)counters.triangles);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", (unsigned long long)counters.programBinds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", (unsigned long long)counters.textureBinds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", (unsigned long long)counters.uniformUpdates);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", counters.uploadBytes / 1024.0);
+                }
+                ImGui::EndTable();
+            }
+
+            // ÿ֡д CSVڻعԱ
+            if (renderStats.isWritingCsv()) {
+                ImGui::Text("Writing render_stats.csv: %llu frames", (unsigned long long)renderStats.getCsvFrames());
+                if (ImGui::Button("Stop CSV")) {
+                    renderStats.stopCsv();
+                }
+            }
+            else if (ImGui::Button("Record CSV")) {
+                renderStats.startCsv("render_stats.csv");
+            }
+        }
+#endif
+
+        //------------------------------------------------------
+        // GL ״̬
+        //------------------------------------------------------
+
+        ImGui::Separator(); // ָ
+
+        if (ImGui::CollapsingHeader("GL State Cache")) {
+            GLStateCache& stateCache = GLStateCache::instance();
+            const GLStateCache::Stats& cacheStats = stateCache.getLastStats();
+            size_t requested = cacheStats.issued + cacheStats.skipped;
+            ImGui::Text("State Calls: %zu issued, %zu skipped (%.1f%%)", cacheStats.issued, cacheStats.skipped,
+                requested > 0 ? 100.0 * cacheStats.skipped / requested : 0.0);
+
+            // ģʽ°λͳظãǰֵĴ
+            bool stateDebug = stateCache.isDebugEnabled();
+            if (ImGui::Checkbox("Track Redundant Call Sites", &stateDebug)) {
+                stateCache.setDebugEnabled(stateDebug);
+            }
+            if (stateDebug) {
+                std::vector<std::pair<std::string, size_t>> sites = stateCache.getRedundantSites();
+                for (size_t i = 0; i < sites.size() && i < 10; ++i) {
+                    ImGui::Text("%8zu  %s", sites[i].second, sites[i].first.c_str());
+                }
+                if (ImGui::Button("Log Sites")) {
+                    stateCache.logRedundantSites();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Clear Sites")) {
+                    stateCache.clearRedundantSites();
+                }
+            }
+        }
+
+        //------------------------------------------------------
+        // CPU ʱ
+        //------------------------------------------------------
+
+        ImGui::Separator(); // ָ
+
+        if (ImGui::CollapsingHeader("CPU Profiler")) {
+            CpuProfiler& cpuProfiler = CpuProfiler::instance();
+            bool cpuProfilerEnabled = cpuProfiler.isEnabled();
+            if (ImGui::Checkbox("Record Zones", &cpuProfilerEnabled)) {
+                cpuProfiler.setEnabled(cpuProfilerEnabled);
+            }
+            ImGui::Text("Threads: %zu", cpuProfiler.getThreadCount());
+
+            // ֲ֡֡ 0 ~ 50 ms
+            ImGui::Text("Frame Time p50 %.2f / p95 %.2f / p99 %.2f ms", cpuProfiler.getFrameTimePercentile(0.5f),
+                cpuProfiler.getFrameTimePercentile(0.95f), cpuProfiler.getFrameTimePercentile(0.99f));
+            ImGui::PlotLines("##frametimes", cpuProfiler.getFrameTimes(), cpuProfiler.getFrameTimeCount(),
+                cpuProfiler.getFrameTimeCount() == CpuProfiler::FRAME_HISTORY ? cpuProfiler.getFrameTimeOffset() : 0,
+                "Frame Time (ms)", 0.0f, 50.0f, ImVec2(0.0f, 50.0f));
+            std::vector<float> histogram = cpuProfiler.buildFrameTimeHistogram(25, 50.0f);
+            ImGui::PlotHistogram("##histogram", histogram.data(), static_cast<int>(histogram.size()), 0,
+                "0 - 50 ms, 2 ms buckets", 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+            if (ImGui::Button("Export CPU Trace (P)")) {
+                cpuProfiler.exportTrace("cpu_trace.json");
+            }
+        }
+
+        //------------------------------------------------------
+        // GPU ֽ׶μʱ
+        //------------------------------------------------------
+
+        ImGui::Separator(); // ָ
+
+        if (ImGui::CollapsingHeader("GPU Profiler")) {
+            bool profilerEnabled = profiler.isEnabled();
+            if (ImGui::Checkbox("Enable Profiler", &profilerEnabled)) {
+                profiler.setEnabled(profilerEnabled);
+            }
+            ImGui::Text("Dropped Frames: %zu", profiler.getDroppedFrames());
+
+            // ÿһ֡ĺʱߣ㼶
+            for (const auto& scope : profiler.getHistory()) {
+                char overlay[64];
+                std::snprintf(overlay, sizeof(overlay), "%.3f ms (avg %.3f)", scope.lastMs, scope.averageMs);
+                ImGui::Indent(scope.depth * 10.0f + 1.0f);
+                ImGui::PushID(scope.path.c_str());
+                ImGui::Text("%s", scope.name.c_str());
+                ImGui::PlotLines("##history", scope.samples, GpuProfiler::HISTORY, scope.head, overlay,
+                    0.0f, FLT_MAX, ImVec2(0.0f, 36.0f));
+                ImGui::PopID();
+                ImGui::Unindent(scope.depth * 10.0f + 1.0f);
+            }
+
+            // ¼֡Ϊ Chrome trace
+            ImGui::InputInt("Trace Frames", &traceFrameCount);
+            traceFrameCount = std::max(1, std::min(traceFrameCount, 1000));
+            if (profiler.isCapturing()) {
+                ImGui::Text("Capturing... %zu / %d", profiler.getCapturedFrames(), traceFrameCount);
+            }
+            else {
+                if (ImGui::Button("Capture Trace")) {
+                    profiler.startCapture(traceFrameCount);
+                }
+                if (profiler.getCapturedFrames() > 0) {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Export Trace")) {
+                        profiler.exportTrace("gpu_trace.json");
+                    }
+                }
+            }
+        }
+
         //------------------------------------------------------
         // պ
         //------------------------------------------------------
@@ -928,139 +1486,209 @@ void Renderer::renderFrame()
 
         ImGui::End(); // end sidebar
     }
+}
+
+void Renderer::renderFrame()
+{
+    CPU_PROFILE_SCOPE("Renderer::renderFrame");
+
+    // ȡ֮ǰ֡ķֽ׶μʱʼ¼֡ʾѾɵ֡
+    GpuProfiler& profiler = GpuProfiler::instance();
+    profiler.beginFrame();
+    RENDER_STATS_FRAME();
+    GLStateCache::instance().beginFrame();
+
+    // ޴ģʽûн
+    if (!headless) {
+        buildUI();
+    }
+
+    // еɾѾɣϲ֡ʵݣӰͳƹ
+    CPU_PROFILE_BEGIN("Scene::prepareInstances");
+    scene.prepareInstances(selectedObject);
+    CPU_PROFILE_END();
+
+    // ֱ̬ʣ֮ǰ֡ GPU ʱ֡ȾĿڳߴ䣬ֻıӿ
+    // ʱ GpuProfiler ֡򣬹ر GPU ʱûݣűֲ
+    postProcessing.setRenderScale(dynamicResolution.update(profiler.getLastMs("Frame")));
+    renderWidth = postProcessing.getRenderWidth();
+    renderHeight = postProcessing.getRenderHeight();
+
+    // Ӱͼ
+    RENDER_STATS_PASS(SHADOW);
+    profiler.push("Shadows");
+    updateShadowMaps();
+    profiler.pop();
+    RENDER_STATS_PASS(SETUP);
     //std::cout << "Rendering frame..." << std::endl;
 
     // 
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    GL_STATE.viewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // ¾۹Ƶλúͷ
-    if (lightManager.getLightCount() > 0) {
-        auto spotLightPtr = std::dynamic_pointer_cast<SpotLight>(lightManager.getLight(lightManager.getLightCount() - 1));
-        if (spotLightPtr) {
-            spotLightPtr->setPosition(camera.Position);
-            spotLightPtr->setDirection(camera.Front);
-            //std::cout << "SpotLight position and direction updated." << std::endl;
-        }
+    LightHandle cameraLight = lightManager.getCameraLight();
+    if (cameraLight.isValid()) {
+        lightManager.setPosition(cameraLight, camera.Position);
+        lightManager.setDirection(cameraLight, camera.Front);
     }
 
-    // ¹UBO
-    lightManager.updateUBO();
-
-    // UBOɫ
-    lightingShader.use();
-    lightManager.bindUBOToShader(lightingShader, 0); //  binding point Ϊ 0
+    // ¹Դ
+    lightManager.updateLightBuffer();
 
     // ͼ/ͶӰ
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-        static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT), 0.1f, 100.0f);
+    float aspect = static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT);
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
     glm::mat4 view = camera.GetViewMatrix();
 
-    // ɫͳһ
-    lightingShader.setInt("debugLightView", debugLightView);
-    lightingShader.setInt("debugLightIndex", debugLightIndex);
-    lightingShader.setInt("debugMaterialView", debugMaterialView);
-    lightingShader.setInt("debugMaterialIndex", debugMaterialIndex);
-
-    lightingShader.setMat4("projection", projection);
-    lightingShader.setMat4("view", view);
-    lightingShader.setVec3("viewPos", camera.Position);
-    lightingShader.setFloat("material.shininess", 32.0f);
-    lightingShader.setFloat("shadowMapResolution", Resolution);
-    lightingShader.setFloat("far_plane", far_plane);
+    // Դִ
+    CPU_PROFILE_BEGIN("LightManager::updateClusters");
+    lightManager.updateClusters(view, glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+    CPU_PROFILE_END();
+    lightManager.bindLightBuffers();
 
-    // йԴĹռ
-    std::vector<glm::mat4> lightSpaceMatrices;
-	std::vector<Light*> lights;
-    for (size_t i = 0; i < lightManager.getLightCount(); ++i) {
-        lights.push_back(lightManager.getLight(i).get());
-        lightSpaceMatrices.push_back(shadowManager.getLightSpaceMatrix(lights, i));
+    // CPU ڵ޳ӰѾ꣬￪ʼֻӰͼ
+    if (softwareOcclusionEnabled) {
+        scene.applyOcclusion(softwareOcclusion, projection * view);
     }
 
-    // ݹռɫ
-    for (size_t i = 0; i < lightSpaceMatrices.size(); ++i) {
-        std::string matrixName = "lightSpaceMatrices[" + std::to_string(i) + "]";
-        lightingShader.setMat4(matrixName, lightSpaceMatrices[i]);
+    // ͼ GPU ޳׶ + һ֡Ƚڵ
+    bool useHiZ = occlusionCulling && hiZBuffer && hiZBuffer->isValid();
+    RENDER_STATS_PASS(CULLING);
+    profiler.push("Culling");
+    scene.cullInstances(GpuCulling::frustumPlanes(projection * view), useHiZ ? hiZBuffer.get() : nullptr);
+    profiler.pop();
+    RENDER_STATS_PASS(SETUP);
+    if (validateCullingRequested) {
+        lastCullingValidation = scene.validateCulling();
+        hasCullingValidation = true;
+        validateCullingRequested = false;
     }
 
-    // Ӱͼ
-    int shadowBaseUnit = 16;
-    for (size_t i = 0; i < lightManager.getLightCount(); ++i)
-    {
-        const auto& light = lightManager.getLight(i);
-        GLuint shadowTexture = shadowManager.getShadowTexture(i);
+    // Ӱ飨йԴ
+    GL_STATE.bindTexture(16, GL_TEXTURE_2D_ARRAY, shadowManager.getShadowArrayTexture());
+    GL_STATE.bindTexture(17, GL_TEXTURE_CUBE_MAP_ARRAY, shadowManager.getShadowCubeArrayTexture());
+    GL_STATE.bindTexture(18, GL_TEXTURE_2D_ARRAY, shadowManager.getShadowArrayTexture());
+    glBindSampler(18, shadowManager.getRawDepthSampler());
+    GL_STATE.bindTexture(19, GL_TEXTURE_CUBE_MAP_ARRAY, shadowManager.getShadowCubeArrayTexture());
+    glBindSampler(19, shadowManager.getRawDepthSampler());
+    RENDER_STATS_TEXTURES(4);
+
+    // ֡һд UBOǰ򡢼κ͹ս׶ι
+    updateFrameUniforms(projection, view);
+
+    // ͼֻǰɫʵ
+    bool useDeferred = deferredShading && gBuffer && !debugLightView && !debugMaterialView;
+
+    // ӳɫν׶Σֻд G-buffer
+    if (useDeferred) {
+        RENDER_STATS_PASS(GEOMETRY);
+        profiler.push("G-buffer");
+        gBuffer->bindForGeometry(renderWidth, renderHeight);
+        if (shaderPermutations) {
+            scene.draw(*gBufferVariants, 0, selectedObject);
+        }
+        else {
+            gBufferShader->use();
+            scene.draw(*gBufferShader, selectedObject);
+        }
+        profiler.pop();
+    }
 
-        if (light->getType() == LightType::Point)
-        {
-            if (shadowTexture != 0) // ȷЧͼ
-            {
-                glActiveTexture(GL_TEXTURE0 + shadowBaseUnit + i);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, shadowTexture);
-                lightingShader.setInt("shadowCubeMaps[" + std::to_string(i) + "]", shadowBaseUnit + i);
-                //std::cout << "shadowCubeMaps[" << i << "] bound to texture: " << i << std::endl;
+    // ȾĿ꣺кʱȾ FBOֱȾĻ
+    unsigned int targetFBO = 0;
+    if (postProcessing.isActive()) {
+        postProcessing.begin();
+        targetFBO = postProcessing.getFramebuffer();
+    }
+    else {
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    GL_STATE.viewport(0, 0, renderWidth, renderHeight);
+
+    if (useDeferred) {
+        // ӳɫս׶ΣȫΣÿذڴرԴ
+        RENDER_STATS_PASS(LIGHTING);
+        profiler.push("Deferred Lighting");
+        deferredLightingShader->use();
+        gBuffer->bindTextures(0);
+        GL_STATE.disable(GL_DEPTH_TEST);
+        gBuffer->drawFullscreenTriangle();
+        GL_STATE.enable(GL_DEPTH_TEST);
+        profiler.pop();
+
+        // ȣպкͰΧȻҪȲ
+        gBuffer->copyDepthTo(targetFBO, renderWidth, renderHeight);
+    }
+    else {
+        RENDER_STATS_PASS(FORWARD);
+        profiler.push("Forward");
+        if (shaderPermutations) {
+            // ͵ͼͨͬڻֵ
+            uint32_t baseKey = ShaderVariants::directionalBits(static_cast<int>(lightManager.getDirectionalLights().size()));
+            if (debugLightView || debugMaterialView) {
+                baseKey |= ShaderVariants::DEBUG_VIEW;
             }
+            scene.draw(*forwardVariants, baseKey, selectedObject);
         }
-        else // DirectionalLight  SpotLight
-        {
-            if (shadowTexture != 0) // ȷЧ 2D Ӱͼ
-            {
-                glActiveTexture(GL_TEXTURE0 + shadowBaseUnit + i);
-                glBindTexture(GL_TEXTURE_2D, shadowTexture);
-                lightingShader.setInt("shadowMaps[" + std::to_string(i) + "]", shadowBaseUnit + i);
-                //std::cout << "shadowMaps[" << i << "] bound to texture: " << i << std::endl;
-            }
+        else {
+            lightingShader.use();
+            scene.draw(lightingShader, selectedObject);
         }
+        profiler.pop();
     }
-    // ȷ0Ԫհ
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 
-    lightingShader.setInt("lightCount", static_cast<int>(lightManager.getLightCount()));
+    // ʱĿֻ֡гȣһ֡޳õĽ
+    if (occlusionCulling && hiZBuffer && scene.isGpuCullingEnabled()) {
+        RENDER_STATS_PASS(CULLING);
+        profiler.push("Hi-Z");
+        hiZBuffer->build(targetFBO, projection * view, renderWidth, renderHeight);
+        profiler.pop();
+    }
 
-    if (postProcessing.hasEnabledEffects()) {
-        postProcessing.begin();
-        scene.draw(lightingShader, selectedObject);
-
-        // Ⱦպ
-        if (enableSkybox && skybox && skyboxShader) {
-            glDepthFunc(GL_LEQUAL);
-            skyboxShader->use();
-            glm::mat4 skyboxView = glm::mat4(glm::mat3(view)); // Ƴƽ
-            skyboxShader->setMat4("view", skyboxView);
-            skyboxShader->setMat4("projection", projection);
-            skybox->Draw(*skyboxShader, glm::mat4(1.0f), skyboxView, projection);
-            glDepthFunc(GL_LESS);
-        }
+    // Ⱦպ
+    if (enableSkybox && skybox && skyboxShader) {
+        RENDER_STATS_PASS(SKYBOX);
+        profiler.push("Skybox");
+        GL_STATE.depthFunc(GL_LEQUAL);
+        skyboxShader->use();
+        glm::mat4 skyboxView = glm::mat4(glm::mat3(view)); // Ƴƽ
+        skyboxShader->setMat4("view", skyboxView);
+        skyboxShader->setMat4("projection", projection);
+        skybox->Draw(*skyboxShader, glm::mat4(1.0f), skyboxView, projection);
+        GL_STATE.depthFunc(GL_LESS);
+        profiler.pop();
+    }
 
+    if (postProcessing.isActive()) {
+        RENDER_STATS_PASS(POST_PROCESS);
+        profiler.push("Post-Processing");
         postProcessing.endAndRender();
-    }
-    else {
-        scene.draw(lightingShader, selectedObject); // ֱȾĻ
-
-        // Ⱦպ
-        if (enableSkybox && skybox && skyboxShader) {
-            glDepthFunc(GL_LEQUAL);
-            skyboxShader->use();
-            glm::mat4 skyboxView = glm::mat4(glm::mat3(view)); // Ƴƽ
-            skyboxShader->setMat4("view", skyboxView);
-            skyboxShader->setMat4("projection", projection);
-            skybox->Draw(*skyboxShader, glm::mat4(1.0f), skyboxView, projection);
-            glDepthFunc(GL_LESS);
-        }
+        profiler.pop();
     }
 
     //std::cout << "Rendering ImGui..." << std::endl;
 
     // ȾImGui
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (!headless) {
+        RENDER_STATS_PASS(UI);
+        CPU_PROFILE_BEGIN("ImGui Render");
+        profiler.push("ImGui");
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // ImGui ֱӵ GL֮󻺴е״̬ٿ
+        GLStateCache::instance().invalidate();
+        profiler.pop();
+        CPU_PROFILE_END();
+    }
 
     //std::cout << "Frame rendered." << std::endl;
 
     if (captureManager) {
+        profiler.push("Capture");
         captureManager->recordFrame();
+        profiler.pop();
     }
 
     // Ⱦɺ˰ΧʾưΧ
@@ -1069,6 +1697,8 @@ void Renderer::renderFrame()
             drawBoundingSphere(obj);
         }
     }
+
+    profiler.endFrame();
 }
 
 bool Renderer::exportToObj(const std::shared_ptr<GameObject>& obj, const std::string& filePath) {
@@ -1128,6 +1758,8 @@ bool Renderer::exportToObj(const std::shared_ptr<GameObject>& obj, const std::st
 
 void Renderer::processInput()
 {
+    CPU_PROFILE_SCOPE("Renderer::processInput");
+
     // ImGuiڽռ룬¼
     ImGuiIO& io = ImGui::GetIO();
     if (io.WantCaptureKeyboard) return;
@@ -1213,6 +1845,18 @@ void Renderer::processInput()
         rPressed = false;
     }
 
+    // P  CPU ʱ
+    static bool pPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        if (!pPressed) {
+            pPressed = true;
+            CpuProfiler::instance().exportTrace("cpu_trace.json");
+        }
+    }
+    else {
+        pPressed = false;
+    }
+
 
     // Ϸ߼صִ
     if (gameLogicCallback) {
@@ -1220,22 +1864,73 @@ void Renderer::processInput()
     }
 }
 
-void Renderer::updateShadowMaps()
+void Renderer::updateFrameUniforms(const glm::mat4& projection, const glm::mat4& view)
 {
-    // ̬Ӱͼ
-    std::vector<Light*> lights;
-    const auto& gameObjects = scene.getGameObjects(); // Scene ṩб
+    FrameUniforms::FrameData frame{};
+    frame.projection = projection;
+    frame.view = view;
+    frame.viewProjection = projection * view;
+    frame.invViewProjection = glm::inverse(frame.viewProjection);
+
+    // ӰλÿλĹռӰеλ
+    const std::vector<glm::mat4>& shadowMatrices = shadowManager.getShadowMatrices();
+    const std::vector<glm::vec4>& shadowRects = shadowManager.getShadowRects();
+    const std::vector<glm::ivec2>& lightSlots = shadowManager.getLightSlots();
+    size_t slotCount = std::min(shadowMatrices.size(), static_cast<size_t>(FrameUniforms::MAX_SHADOW_SLOTS));
+    for (size_t i = 0; i < slotCount; ++i) {
+        frame.shadowMatrices[i] = shadowMatrices[i];
+        frame.shadowRects[i] = i < shadowRects.size() ? shadowRects[i] : glm::vec4(0.0f);
+    }
+    size_t lightCount = std::min(lightSlots.size(), static_cast<size_t>(FrameUniforms::MAX_SHADOW_LIGHTS));
+    for (size_t i = 0; i < lightCount; ++i) {
+        frame.shadowSlots[i] = glm::ivec4(lightSlots[i], 0, 0);
+    }
+    frame.cascadeSplits = shadowManager.getCascadeSplits();
 
-    // ռԴָ
-    for (size_t i = 0; i < lightManager.getLightCount(); ++i) {
-        lights.push_back(lightManager.getLight(i).get());
+    // ִɫ
+    const std::vector<int>& directionalLights = lightManager.getDirectionalLights();
+    size_t directionalCount = std::min(directionalLights.size(), static_cast<size_t>(FrameUniforms::MAX_DIRECTIONAL_LIGHTS));
+    for (size_t i = 0; i < directionalCount; ++i) {
+        frame.directionalLights[i] = glm::ivec4(directionalLights[i], 0, 0, 0);
     }
+    frame.directionalLightCount = static_cast<int>(directionalCount);
+    frame.clusterGrid = lightManager.getClusterGrid();
+    frame.clusterDepthParams = lightManager.getBinning().getDepthSliceParams();
+    frame.screenSize = glm::vec2(renderWidth, renderHeight);   // ִذʵȾ
+
+    frame.viewPos = camera.Position;
+    frame.farPlane = far_plane;
+    frame.shadowMapResolution = Resolution;
+
+    // Ӱ˵λ
+    frame.shadowQuality = shadowQuality;
+    frame.pcssLightSize = pcssLightSize;
+
+    // ͼ
+    frame.debugLightView = debugLightView ? 1 : 0;
+    frame.debugLightIndex = debugLightIndex;
+    frame.debugMaterialView = debugMaterialView ? 1 : 0;
+    frame.debugMaterialIndex = debugMaterialIndex;
+
+    FrameUniforms::instance().updateFrame(frame);
+}
+
+void Renderer::updateShadowMaps()
+{
+    CPU_PROFILE_SCOPE("Renderer::updateShadowMaps");
+
+    // ̬Ӱͼ
 
     // Ӱͼֱ
     shadowManager.updateShadowResolution(Resolution);
 
+    // ⼶Ҫϵǰ׶
+    shadowManager.setCameraFrustum(camera.GetViewMatrix(), glm::radians(camera.Zoom),
+        static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT), 0.1f);
+
     // Ӱͼ
-    shadowManager.generateShadowMaps(lights, scene, shadowShader, pointshadowShader);
+    shadowManager.generateShadowMaps(lightManager.getStorage(), scene, shadowShader, pointshadowShader,
+        glm::ivec4(0, 0, SCR_WIDTH, SCR_HEIGHT), pointShadowLayeredShader.get(), pointShadowFaceShader.get());
 }
 
 void Renderer::drawBoundingSphere(const std::shared_ptr<GameObject>& obj) {
@@ -1246,10 +1941,6 @@ void Renderer::drawBoundingSphere(const std::shared_ptr<GameObject>& obj) {
     glm::vec3 objScale = obj->getScale();
     float radius = glm::length(objScale) * 0.5f;
 
-    // 浱ǰɫ
-    GLint currentProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
-
     // ʹü򵥵ɫ߿
     basicShader->use();
     basicShader->setMat4("projection", camera.GetProjectionMatrix(float(SCR_WIDTH) / float(SCR_HEIGHT)));
@@ -1265,23 +1956,20 @@ void Renderer::drawBoundingSphere(const std::shared_ptr<GameObject>& obj) {
     basicShader->setVec3("color", glm::vec3(0.0f, 1.0f, 0.0f));
 
     // ߿ģʽ
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    GL_STATE.polygonMode(GL_LINE);
 
     // Ȳģʽƿ
-    glDepthFunc(GL_LEQUAL);
-    glDisable(GL_DEPTH_TEST); 
+    GL_STATE.depthFunc(GL_LEQUAL);
+    GL_STATE.disable(GL_DEPTH_TEST); 
 
     // 
     sphereMesh->Draw(*basicShader);
 
     // ָд
-    glEnable(GL_DEPTH_TEST);
+    GL_STATE.enable(GL_DEPTH_TEST);
 
     // ָģʽ
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    // ָ֮ǰɫ
-    glUseProgram(currentProgram);
+    GL_STATE.polygonMode(GL_FILL);
 }
 
 void Renderer::saveScene(const std::string& filePath) {
@@ -1333,6 +2021,9 @@ std::vector<std::string> Renderer::getSceneFiles(const std::string& directory) {
 
 void Renderer::cleanup()
 {
+    if (headless) {
+        return;
+    }
     std::cout << "Cleaning up ImGui..." << std::endl;
     // ImGui
     ImGui_ImplOpenGL3_Shutdown();
@@ -1349,7 +2040,16 @@ void Renderer::framebuffer_size_callback(GLFWwindow* window, int width, int heig
     if (renderer) {
         renderer->SCR_WIDTH = width;
         renderer->SCR_HEIGHT = height;
-        glViewport(0, 0, width, height);
+        GL_STATE.viewport(0, 0, width, height);
+
+        // G-buffer 洰ڳߴ
+        if (renderer->gBuffer) {
+            renderer->gBuffer->resize(width, height);
+        }
+        if (renderer->hiZBuffer) {
+            renderer->hiZBuffer->resize(width, height);
+        }
+        renderer->postProcessing.resize(width, height);
 
         // Ӱͼֱ
         int newResolution = std::max(width, height);
@@ -1595,34 +2295,23 @@ std::vector<std::string> Renderer::getDefaultSkyboxPaths() const
 std::vector<std::string> Renderer::getSkyboxList(const std::string& directory) const
 {
     std::vector<std::string> skyboxes;
-    WIN32_FIND_DATAA findData;
-    HANDLE hFind = FindFirstFileA((directory + "/*").c_str(), &findData);
-
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                std::string dirName = findData.cFileName;
-                if (dirName != "." && dirName != "..") {
-                    // Ƿļ
-                    bool isValidSkybox = true;
-                    std::vector<std::string> requiredFiles = { "right.jpg", "left.jpg", "top.jpg", "bottom.jpg", "front.jpg", "back.jpg" };
-                    for (const auto& file : requiredFiles) {
-                        std::string fullPath = directory + "/" + dirName + "/" + file;
-                        WIN32_FIND_DATAA fileData;
-                        HANDLE hFileFind = FindFirstFileA(fullPath.c_str(), &fileData);
-                        if (hFileFind == INVALID_HANDLE_VALUE) {
-                            isValidSkybox = false;
-                            break;
-                        }
-                        FindClose(hFileFind);
-                    }
-                    if (isValidSkybox) {
-                        skyboxes.push_back(dirName);
-                    }
-                }
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_directory()) {
+            continue;
+        }
+        // Ƿļ
+        bool isValidSkybox = true;
+        std::vector<std::string> requiredFiles = { "right.jpg", "left.jpg", "top.jpg", "bottom.jpg", "front.jpg", "back.jpg" };
+        for (const auto& file : requiredFiles) {
+            if (!std::filesystem::exists(entry.path() / file)) {
+                isValidSkybox = false;
+                break;
             }
-        } while (FindNextFileA(hFind, &findData));
-        FindClose(hFind);
+        }
+        if (isValidSkybox) {
+            skyboxes.push_back(entry.path().filename().string());
+        }
     }
 
     return skyboxes;
@@ -1641,45 +2330,21 @@ void Renderer::loadSkyboxFromPanorama(const std::string& panoramaPath)
 std::vector<std::string> Renderer::getPanoramaList(const std::string& directory) const
 {
     std::vector<std::string> panoramas;
-    WIN32_FIND_DATAA findData;
-
-    //  HDR ļ
-    std::string searchPath = directory + "/*.hdr";
-    HANDLE hFind = FindFirstFileA(searchPath.c_str(), &findData);
 
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                panoramas.push_back(findData.cFileName);
+    //  HDRJPGPNG ļչִСд
+    for (const char* extension : { ".hdr", ".jpg", ".png" }) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (!entry.is_regular_file()) {
+                continue;
             }
-        } while (FindNextFileA(hFind, &findData));
-        FindClose(hFind);
-    }
-
-    //  JPG ļ
-    searchPath = directory + "/*.jpg";
-    hFind = FindFirstFileA(searchPath.c_str(), &findData);
-
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                panoramas.push_back(findData.cFileName);
-            }
-        } while (FindNextFileA(hFind, &findData));
-        FindClose(hFind);
-    }
-
-    //  PNG ļ
-    searchPath = directory + "/*.png";
-    hFind = FindFirstFileA(searchPath.c_str(), &findData);
-
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                panoramas.push_back(findData.cFileName);
+            std::string fileExtension = entry.path().extension().string();
+            std::transform(fileExtension.begin(), fileExtension.end(), fileExtension.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (fileExtension == extension) {
+                panoramas.push_back(entry.path().filename().string());
             }
-        } while (FindNextFileA(hFind, &findData));
-        FindClose(hFind);
+        }
     }
 
     return panoramas;
@@ -2,6 +2,7 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#ifdef _WIN32
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #define RPC_NO_WINDOWS_H
@@ -12,16 +13,27 @@
 #undef byte
 #undef FAR
 #undef near
+#endif
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include "Shader.h"
-#include "Camera.h"
+#include "shader.h"
+#include "camera.h"
 #include "LightManager.h"
 #include "ShadowManager.h"
 #include "Scene.h"
 #include "PostProcessing.h"
+#include "GBuffer.h"
+#include "HiZBuffer.h"
+#include "SoftwareOcclusion.h"
+#include "FrameUniforms.h"
+#include "ShaderVariants.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include "DynamicResolution.h"
 #include "CaptureManager.h"
 #include "skybox.h"
 
@@ -40,7 +52,7 @@
 
 class Renderer {
 public:
-    // 캯
+    // 캯window Ϊʱ޴ģʽɵ÷ṩǰ
     Renderer(GLFWwindow* window, unsigned int width, unsigned int height, Camera& camera,
         LightManager& lightManager, ShadowManager& shadowManager, Scene& scene);
 
@@ -50,6 +62,19 @@ public:
     // Ⱦѭ
     void run();
 
+    // ޴ģʽԹ̶ʱ䲽Ⱦָ֡롢ƽ
+    // validateCulling ʱһ֡ GPU ޳ CPU οʵֶԱȣһʱ false
+    bool runHeadless(int frameCount, float frameTime, bool validateCulling = false);
+    // ޴ģʽĵ֡ƽ̶ʱ䲽³ύȾȴ GPU
+    void renderHeadlessFrame(float frameTime);
+
+    // ͼĿ¼ļԶ
+    bool captureScreenshot(const std::string& directory);
+
+    // ͼس
+    void saveScene(const std::string& filePath);
+    void loadScene(const std::string& filePath);
+
     // Դ
     void cleanup();
 
@@ -70,6 +95,7 @@ private:
 
     // GLFW
     GLFWwindow* window;
+    bool headless;
 
     // ⲿϵͳ
     Camera& camera;
@@ -81,6 +107,8 @@ private:
     Shader lightingShader;
     Shader shadowShader;
     Shader pointshadowShader;
+    std::unique_ptr<Shader> pointShadowLayeredShader; // ɫѡĵԴӰҪչ֧֣
+    std::unique_ptr<Shader> pointShadowFaceShader;    // ƵĵԴӰ
 
     //  character ָ
     std::shared_ptr<GameObject> Character; 
@@ -113,6 +141,39 @@ private:
     bool debugMaterialView;
     int debugMaterialIndex;
 
+    // Ӱ˵λ0 ӲӰ, 1 4-tap, 2 16-tap Poisson, 3 PCSS
+    int shadowQuality = 1;
+    float pcssLightSize = 0.01f;
+
+    // ӳɫν׶д G-bufferս׶ÿɼֻһ
+    bool deferredShading = false;
+    std::unique_ptr<GBuffer> gBuffer;
+    std::unique_ptr<Shader> gBufferShader;
+    std::unique_ptr<Shader> deferredLightingShader;
+
+    // ɫ壺ǰ G-buffer ν׶ΰѡֻ蹦ܵĳ򣬹رʱʹõһɫ
+    bool shaderPermutations = true;
+    std::unique_ptr<ShaderVariants> forwardVariants;
+    std::unique_ptr<ShaderVariants> gBufferVariants;
+
+    // GPU ڵ޳ÿ֡ƺȽһ֡޳ʱʹ
+    bool occlusionCulling = true;
+    std::unique_ptr<HiZBuffer> hiZBuffer;
+    bool validateCullingRequested = false;
+    bool hasCullingValidation = false;
+    GpuCulling::ValidationResult lastCullingValidation = {};
+
+    // CPU ڵ޳256x128 Ȼ壬֡դ֡ʹãûӳ
+    bool softwareOcclusionEnabled = false;
+    SoftwareOcclusion softwareOcclusion;
+
+    // ֱ̬ʣ GpuProfiler õ֡ GPU ʱȾţŴ
+    DynamicResolution dynamicResolution;
+    unsigned int renderWidth = 0, renderHeight = 0;   // ֡Ⱦ
+
+    // GPU ֽ׶μʱ trace ʱ¼Ƶ֡
+    int traceFrameCount = 60;
+
     // Χʾ
     bool showBoundingSpheres = false;  // ưΧʾ
     void drawBoundingSphere(const std::shared_ptr<GameObject>& obj);  // ưΧ
@@ -132,6 +193,9 @@ private:
     // ûص
     void setCallbacks();
 
+    // 
+    void buildUI();
+
     // Ⱦһ֡
     void renderFrame();
 
@@ -141,9 +205,8 @@ private:
     // Ӱͼ
     void updateShadowMaps();
 
-    // ͼس
-    void saveScene(const std::string& filePath);
-    void loadScene(const std::string& filePath);
+    // дִ֡ءӰԿأд FrameData UBOɫ׶ι
+    void updateFrameUniforms(const glm::mat4& projection, const glm::mat4& view);
 
     // Ϊ OBJ ļ
     bool exportToObj(const std::shared_ptr<GameObject>& obj, const std::string& filePath);
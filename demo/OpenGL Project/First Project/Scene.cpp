@@ -1,41 +1,431 @@
 #include "Scene.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+#ifdef RENDER_STATS_ENABLED
+namespace {
+
+// һμ޳ǰ޳ʵֻ GPU 
+uint64_t commandTriangles(const std::vector<DrawElementsIndirectCommand>& commands, size_t first, size_t count) {
+    uint64_t triangles = 0;
+    for (size_t i = first; i < first + count && i < commands.size(); ++i) {
+        triangles += static_cast<uint64_t>(commands[i].count / 3) * commands[i].instanceCount;
+    }
+    return triangles;
+}
+
+} // namespace
+#endif
+
+PBRMaterial Scene::highlightMaterial(const PBRMaterial& original) {
+    PBRMaterial material = original;
+
+    // ǿЧ
+    material.albedo = material.albedo * 1.5f;  // 
+    material.metallic = std::min(material.metallic * 0.5f + 0.5f, 1.0f);  // ӽ
+    material.roughness = std::max(material.roughness * 0.5f, 0.1f);  // ʹֲڶȣʹ⻬
+    material.ao = 1.0f;  // 󻷾ڱ
+    return material;
+}
+
+void Scene::uploadStream(GLenum target, GLuint& buffer, size_t& capacity, const void* data, size_t size) {
+    if (!buffer) {
+        glGenBuffers(1, &buffer);
+    }
+    glBindBuffer(target, buffer);
+    if (size > capacity) {
+        capacity = std::max(size, capacity * 2);
+    }
+    glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(target, 0, size, data);
+    glBindBuffer(target, 0);
+    RENDER_STATS_UPLOAD(size);
+}
+
+void Scene::prepareInstances(const std::shared_ptr<GameObject>& selectedObject) {
+    cullingActive = false;
+    occlusionActive = false;
+    occludedObjects.clear();
+    if (!instancingEnabled) {
+        clearInstances();
+        return;
+    }
+
+    if (updateInstanceSources(selectedObject.get())) {
+        buildInstances(selectedObject.get());
+    }
+    if (instanceData.empty() || !gpuCullingEnabled || cullingInputsCurrent) {
+        return;
+    }
+
+    if (!gpuCulling) {
+        gpuCulling = std::make_unique<GpuCulling>();
+        if (!gpuCulling->initialize()) {
+            gpuCulling.reset();
+            gpuCullingEnabled = false;
+            return;
+        }
+    }
+    gpuCulling->setInputs(instanceBuffer, instanceCommands, indirectCommands, commandBounds);
+    cullingInputsCurrent = true;
+}
+
+bool Scene::updateInstanceSources(const GameObject* selected) {
+    size_t arenaLayout = GeometryArena::instance().getDefragmentCount();
+    bool changed = !instancesValid || selected != instanceSelected || arenaLayout != instanceArenaLayout;
+    size_t count = 0;
+    for (const auto& obj : gameObjects) {
+        if (!obj->isInstanceable()) {
+            continue;
+        }
+        std::pair<const GameObject*, uint64_t> source(obj.get(), obj->getVersion());
+        if (count == instanceSources.size()) {
+            instanceSources.push_back(source);
+            changed = true;
+        }
+        else if (instanceSources[count] != source) {
+            instanceSources[count] = source;
+            changed = true;
+        }
+        ++count;
+    }
+    if (count != instanceSources.size()) {
+        instanceSources.resize(count);
+        changed = true;
+    }
+    instanceSelected = selected;
+    instanceArenaLayout = arenaLayout;
+    instancesValid = true;
+    return changed;
+}
+
+void Scene::clearInstances() {
+    instanceRefs.clear();
+    instanceData.clear();
+    indirectCommands.clear();
+    materialBuckets.clear();
+    instanceCommands.clear();
+    commandBounds.clear();
+    instanceSources.clear();
+    instancesValid = false;
+    cullingInputsCurrent = false;
+}
+
+void Scene::buildInstances(const GameObject* selected) {
+    CPU_PROFILE_SCOPE("Scene::buildInstances");
+    instanceRefs.clear();
+    instanceData.clear();
+    indirectCommands.clear();
+    materialBuckets.clear();
+    instanceCommands.clear();
+    commandBounds.clear();
+    cullingInputsCurrent = false;
+
+    // ռпʵ
+    for (const auto& obj : gameObjects) {
+        if (!obj->isInstanceable()) {
+            continue;
+        }
+        const Model& model = obj->getModel();
+        const std::vector<PBRMaterial>& materials = obj->getMaterials();
+        for (size_t i = 0; i < model.meshes.size(); ++i) {
+            instanceRefs.push_back({ &model.meshes[i], &materials[i], obj.get(), obj.get() == selected });
+        }
+    }
+
+    // ͬһͬʵһ
+    std::sort(instanceRefs.begin(), instanceRefs.end(), [](const InstanceRef& a, const InstanceRef& b) {
+        auto keyA = textureKey(*a.material);
+        auto keyB = textureKey(*b.material);
+        if (keyA != keyB) {
+            return keyA < keyB;
+        }
+        return std::less<const Mesh*>()(a.mesh, b.mesh);
+    });
+
+    // дʵݣɼֲͰ
+    GeometryArena& arena = GeometryArena::instance();
+    instanceData.reserve(instanceRefs.size());
+    const InstanceRef* previous = nullptr;
+    for (const InstanceRef& ref : instanceRefs) {
+        PBRMaterial material = ref.highlighted ? highlightMaterial(*ref.material) : *ref.material;
+        GLuint index = static_cast<GLuint>(instanceData.size());
+        instanceData.push_back({
+            ref.object->getModelMatrix(),
+            glm::vec4(material.albedo, material.metallic),
+            glm::vec4(material.roughness, material.ao, 0.0f, 0.0f)
+            });
+
+        bool sameTextures = previous && textureKey(*previous->material) == textureKey(*ref.material);
+        if (!sameTextures) {
+            materialBuckets.push_back({ ref.material, indirectCommands.size(), 0 });
+        }
+        if (!sameTextures || previous->mesh != ref.mesh) {
+            indirectCommands.push_back(arena.makeCommand(ref.mesh->geometry, 0, index));
+            commandBounds.push_back({ glm::vec4(ref.mesh->bounds.min, 1.0f), glm::vec4(ref.mesh->bounds.max, 1.0f) });
+            ++materialBuckets.back().commandCount;
+        }
+        ++indirectCommands.back().instanceCount;
+        instanceCommands.push_back(static_cast<GLuint>(indirectCommands.size() - 1));
+        previous = &ref;
+    }
+
+    if (instanceData.empty()) {
+        return;
+    }
+
+    uploadStream(GL_ARRAY_BUFFER, instanceBuffer, instanceBufferSize,
+        instanceData.data(), instanceData.size() * sizeof(InstanceData));
+    uploadStream(GL_DRAW_INDIRECT_BUFFER, indirectBuffer, indirectBufferSize,
+        indirectCommands.data(), indirectCommands.size() * sizeof(DrawElementsIndirectCommand));
+}
+
+void Scene::applyOcclusion(SoftwareOcclusion& occlusion, const glm::mat4& viewProjection) {
+    occlusion.beginFrame(viewProjection);
+
+    // ڵ壺ǹ壬ԼĻռ㹻β壻Σ
+    for (const auto& obj : gameObjects) {
+        if (!obj->isInstanceable()) {
+            continue;
+        }
+        const Model& model = obj->getModel();
+        if (!obj->isOccluder()) {
+            size_t triangles = 0;
+            for (const Mesh& mesh : model.meshes) {
+                triangles += mesh.indices.size() / 3;
+            }
+            BoundingBox world = model.boundingBox.transformed(obj->getModelMatrix());
+            if (triangles > autoOccluderTriangles || occlusion.screenCoverage(world.min, world.max) < autoOccluderCoverage) {
+                continue;
+            }
+        }
+        for (const Mesh& mesh : model.meshes) {
+            occlusion.addOccluder(obj->getModelMatrix(), mesh.vertices.data(), sizeof(Vertex), mesh.vertices.size(),
+                mesh.indices.data(), mesh.indices.size());
+        }
+    }
+    occlusion.rasterize();
+
+    // Ƶľ̬壨رʵʱ
+    occludedObjects.clear();
+    if (!instancingEnabled) {
+        for (const auto& obj : gameObjects) {
+            if (!obj->isInstanceable()) {
+                continue;
+            }
+            BoundingBox world = obj->getModel().boundingBox.transformed(obj->getModelMatrix());
+            if (!occlusion.isVisible(world.min, world.max)) {
+                occludedObjects.insert(obj.get());
+            }
+        }
+    }
+
+    // ʵͬһʵ instanceData ˳ѹ¼ʼʵ
+    occlusionInstanceData.clear();
+    occlusionInstanceCommands.clear();
+    occlusionCommands = indirectCommands;
+    for (size_t c = 0; c < indirectCommands.size(); ++c) {
+        const DrawElementsIndirectCommand& command = indirectCommands[c];
+        occlusionCommands[c].baseInstance = static_cast<GLuint>(occlusionInstanceData.size());
+        occlusionCommands[c].instanceCount = 0;
+
+        BoundingBox local;
+        local.min = glm::vec3(commandBounds[c].boundsMin);
+        local.max = glm::vec3(commandBounds[c].boundsMax);
+        for (GLuint i = command.baseInstance; i < command.baseInstance + command.instanceCount; ++i) {
+            BoundingBox world = local.transformed(instanceData[i].model);
+            if (!occlusion.isVisible(world.min, world.max)) {
+                continue;
+            }
+            occlusionInstanceData.push_back(instanceData[i]);
+            occlusionInstanceCommands.push_back(static_cast<GLuint>(c));
+            ++occlusionCommands[c].instanceCount;
+        }
+    }
+    occlusionActive = true;
+
+    if (indirectCommands.empty()) {
+        return;
+    }
+    if (!occlusionInstanceData.empty()) {
+        uploadStream(GL_ARRAY_BUFFER, occlusionInstanceBuffer, occlusionInstanceBufferSize,
+            occlusionInstanceData.data(), occlusionInstanceData.size() * sizeof(InstanceData));
+    }
+    uploadStream(GL_DRAW_INDIRECT_BUFFER, occlusionIndirectBuffer, occlusionIndirectBufferSize,
+        occlusionCommands.data(), occlusionCommands.size() * sizeof(DrawElementsIndirectCommand));
+
+    // ͼ GPU ޳ڵϼУһ֡ prepareInstances ٻȫʵ
+    if (gpuCullingEnabled && gpuCulling) {
+        gpuCulling->setInputs(occlusionInstanceBuffer, occlusionInstanceCommands, occlusionCommands, commandBounds);
+        cullingInputsCurrent = false;
+    }
+}
+
+GLuint Scene::activeInstanceBuffer() const {
+    if (cullingActive) {
+        return gpuCulling->getInstanceBuffer();
+    }
+    return occlusionActive ? occlusionInstanceBuffer : instanceBuffer;
+}
+
+GLuint Scene::activeIndirectBuffer() const {
+    if (cullingActive) {
+        return gpuCulling->getCommandBuffer();
+    }
+    return occlusionActive ? occlusionIndirectBuffer : indirectBuffer;
+}
+
+void Scene::cullInstances(const GpuCulling::Planes& planes, const HiZBuffer* hiZ) {
+    // ʵȫڵʱҪ޳ֱʹʵΪ 0 
+    if (!gpuCullingEnabled || !gpuCulling || indirectCommands.empty() ||
+        (occlusionActive && occlusionInstanceData.empty())) {
+        cullingActive = false;
+        return;
+    }
+    gpuCulling->cull(planes, hiZ);
+    cullingActive = true;
+}
+
+GpuCulling::ValidationResult Scene::validateCulling() const {
+    if (!cullingActive) {
+        return { instanceData.size(), 0, 0, 0 };
+    }
+    if (occlusionActive) {
+        return gpuCulling->validate(occlusionInstanceData, occlusionInstanceCommands, commandBounds);
+    }
+    return gpuCulling->validate(instanceData, instanceCommands, commandBounds);
+}
 
 void Scene::draw(Shader& shader) const {
     draw(shader, nullptr);
 }
 
 void Scene::draw(Shader& shader, const std::shared_ptr<GameObject>& selectedObject) const {
+    drawColor(&shader, nullptr, 0, selectedObject);
+}
+
+void Scene::draw(ShaderVariants& variants, uint32_t baseKey, const std::shared_ptr<GameObject>& selectedObject) const {
+    drawColor(nullptr, &variants, baseKey, selectedObject);
+}
+
+void Scene::drawColor(Shader* shader, ShaderVariants* variants, uint32_t baseKey,
+    const std::shared_ptr<GameObject>& selectedObject) const {
+    lastDrawCalls = 0;
+    lastProgramSwitches = 0;
+
+    // ֵȡñλƵĳ뵱ǰͬʱл
+    GLuint currentProgram = shader ? shader->ID : 0;
+    auto select = [&](uint32_t key) -> Shader& {
+        if (!variants) {
+            return *shader;
+        }
+        Shader& variant = variants->get(baseKey | key);
+        if (variant.ID != currentProgram) {
+            variant.use();
+            currentProgram = variant.ID;
+            ++lastProgramSwitches;
+        }
+        return variant;
+    };
+
+    // ռλƵ峣Ͳʣһд뻺壬ʱֻлƫ
+    FrameUniforms& uniforms = FrameUniforms::instance();
+    drawObjects.clear();
+    drawMaterials.clear();
+
+    // ÿͰһݣģ;Ͳʳʵԣʱֻṩͼ־
+    for (const MaterialBucket& bucket : materialBuckets) {
+        drawMaterials.push_back(FrameUniforms::packMaterial(*bucket.material));
+        drawObjects.push_back({ glm::mat4(1.0f), static_cast<int>(drawMaterials.size() - 1), 0, 1, 0 });
+    }
+
+    // ÿһ
     for (const auto& obj : gameObjects) {
-        shader.setMat4("model", obj->getModelMatrix());
-
-        // ѡе壬ӸЧ
-        if (selectedObject && obj == selectedObject) {
-            // ԭʼ
-            std::vector<PBRMaterial> originalMaterials;
-            for (size_t i = 0; i < obj->getModel().meshes.size(); ++i) {
-                originalMaterials.push_back(obj->getPBRMaterial(i));
-                PBRMaterial& material = obj->getPBRMaterial(i);
-
-                // ǿЧ
-                material.albedo = material.albedo * 1.5f;  // 
-                material.metallic = std::min(material.metallic * 0.5f + 0.5f, 1.0f);  // ӽ
-                material.roughness = std::max(material.roughness * 0.5f, 0.1f);  // ʹֲڶȣʹ⻬
-                material.ao = 1.0f;  // 󻷾ڱ
-            }
+        if ((instancingEnabled && obj->isInstanceable()) || occludedObjects.count(obj.get())) {
+            continue;
+        }
+        const std::vector<Mesh>& meshes = obj->getModel().meshes;
+        const std::vector<PBRMaterial>& materials = obj->getMaterials();
+        bool highlighted = selectedObject && obj == selectedObject;
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const PBRMaterial& material = i < materials.size() ? materials[i] : meshes[i].material;
+            // ѡе壬ӸЧ
+            drawMaterials.push_back(FrameUniforms::packMaterial(highlighted ? highlightMaterial(material) : material));
+            drawObjects.push_back({ obj->getModelMatrix(), static_cast<int>(drawMaterials.size() - 1),
+                obj->hasBones() ? 1 : 0, 0, 0 });
+        }
+    }
 
-            // Ⱦ
-            obj->uploadBoneUniforms(shader);
-            obj->getModel().Draw(shader);
+    uniforms.writeMaterials(drawMaterials);
+    size_t offset = uniforms.writeObjects(drawObjects.data(), drawObjects.size());
+    size_t stride = uniforms.getObjectStride();
+    size_t slot = 0;   // Ļ˳ռʱһ£ slot λʹõ slot 峣Ͳ
 
-            // ָԭʼ
-            for (size_t i = 0; i < obj->getModel().meshes.size(); ++i) {
-                obj->getPBRMaterial(i) = originalMaterials[i];
-            }
+    // ʵ֣ÿͰһζؼӻ
+    if (!materialBuckets.empty()) {
+        // ޳ʱʹ޳ʵֲ
+        GeometryArena::instance().bindColorInstanced(activeInstanceBuffer());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, activeIndirectBuffer());
+        for (const MaterialBucket& bucket : materialBuckets) {
+            select(ShaderVariants::INSTANCED | ShaderVariants::materialBits(drawMaterials[slot].textureFlags.x));
+            uniforms.bindObject(offset + slot * stride);
+            ++slot;
+            Mesh::bindMaterialTextures(*bucket.material);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(bucket.firstCommand * sizeof(DrawElementsIndirectCommand)),
+                static_cast<GLsizei>(bucket.commandCount), 0);
+            RENDER_STATS_INDIRECT_DRAW(bucket.commandCount,
+                commandTriangles(indirectCommands, bucket.firstCommand, bucket.commandCount));
+            ++lastDrawCalls;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // 壨йرʵƣ˳ռʱһ
+    for (const auto& obj : gameObjects) {
+        if ((instancingEnabled && obj->isInstanceable()) || occludedObjects.count(obj.get())) {
+            continue;
         }
-        else {
-            // Ⱦδѡе
-            obj->uploadBoneUniforms(shader);
-            obj->getModel().Draw(shader);
+        const std::vector<Mesh>& meshes = obj->getModel().meshes;
+        const std::vector<PBRMaterial>& materials = obj->getMaterials();
+        uint32_t objectKey = obj->hasBones() ? ShaderVariants::SKINNED : 0u;
+        Shader* boneShader = nullptr;
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            Shader& meshShader = select(objectKey | ShaderVariants::materialBits(drawMaterials[slot].textureFlags.x));
+            // ǳԼ uniformÿõĳϴһ
+            if (&meshShader != boneShader) {
+                obj->uploadBoneUniforms(meshShader);
+                boneShader = &meshShader;
+            }
+            uniforms.bindObject(offset + slot * stride);
+            ++slot;
+            // ֻıʳԭͬ
+            meshes[i].Draw(meshShader, i < materials.size() ? materials[i] : meshes[i].material);
         }
+        lastDrawCalls += meshes.size();
+    }
+}
+
+void Scene::drawDepth(Shader& depthShader) const {
+    drawDepthInstances(depthShader);
+    forEachDepthObject([&depthShader](const GameObject& obj) {
+        obj.drawDepth(depthShader);
+    });
+}
+
+void Scene::drawDepthInstances(Shader& depthShader) const {
+    // ͨҪʣȫһύ
+    if (!indirectCommands.empty()) {
+        depthShader.setInt("useInstancing", 1);
+        depthShader.setInt("useBones", 0);
+        GeometryArena::instance().bindDepthInstanced(activeInstanceBuffer());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, activeIndirectBuffer());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+            static_cast<GLsizei>(indirectCommands.size()), 0);
+        RENDER_STATS_INDIRECT_DRAW(indirectCommands.size(),
+            commandTriangles(indirectCommands, 0, indirectCommands.size()));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        depthShader.setInt("useInstancing", 0);
     }
 }
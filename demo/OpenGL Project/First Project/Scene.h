@@ -2,23 +2,128 @@
 #define SCENE_H
 
 #include <vector>
+#include <array>
 #include <string>
 #include <memory> // ָ
+#include <unordered_set>
 #include <nlohmann/json.hpp>
+#include <glad/glad.h>
 #include "GameObject.h"
 #include "LightManager.h"
+#include "GpuCulling.h"
+#include "SoftwareOcclusion.h"
+#include "FrameUniforms.h"
+#include "ShaderVariants.h"
+#include "CpuProfiler.h"
 
 class Scene {
 private:
     std::vector<std::shared_ptr<GameObject>> gameObjects; // ʹ shared_ptr 洢 GameObject
     LightManager& lightManager;                          // ùԴ
 
+    // ʵƣûй尴 (, ) 飬ÿһӻ
+    // ͬΪһͰÿͰһ glMultiDrawElementsIndirect
+    // ģ;Ͳʳʵдʵ壬ͬͰʵ
+    struct InstanceRef {
+        const Mesh* mesh;
+        const PBRMaterial* material;
+        const GameObject* object;
+        bool highlighted;
+    };
+
+    struct MaterialBucket {
+        const PBRMaterial* material;   // ͰõȡԵһʵĲ
+        size_t firstCommand;
+        size_t commandCount;
+    };
+
+    bool instancingEnabled = true;
+    // Ļ棺ʵ (ָ, 汾) ѡ嶼ϴͬʱϴʵ
+    std::vector<std::pair<const GameObject*, uint64_t>> instanceSources;
+    const GameObject* instanceSelected = nullptr;
+    size_t instanceArenaLayout = 0;              // ʱλеƫҪ
+    bool instancesValid = false;
+    std::vector<InstanceRef> instanceRefs;
+    std::vector<InstanceData> instanceData;
+    std::vector<DrawElementsIndirectCommand> indirectCommands; // ÿ (, ) һ
+    std::vector<MaterialBucket> materialBuckets;               // ֵ
+    GLuint instanceBuffer = 0;
+    size_t instanceBufferSize = 0;
+    GLuint indirectBuffer = 0;
+    size_t indirectBufferSize = 0;
+    mutable size_t lastDrawCalls = 0;            // һ draw ύĻƵ
+    mutable size_t lastProgramSwitches = 0;      // һΰ draw ʱлĴ
+    mutable std::vector<FrameUniforms::ObjectData> drawObjects;     // draw ʱռ峣ڴ
+    mutable std::vector<FrameUniforms::MaterialData> drawMaterials; // draw ʱռĲʱ
+
+    // GPU ޳ʱÿͼɼɫɿɼʵͼ
+    bool gpuCullingEnabled = true;
+    bool cullingActive = false;                  // ֡ǷѾ޳draw ʹ޳
+    bool cullingInputsCurrent = false;           // GPU ޳ǷΪǰȫʵCPU ڵ޳ỻѹʵ
+    std::unique_ptr<GpuCulling> gpuCulling;
+    std::vector<GLuint> instanceCommands;        // ÿʵļ
+    std::vector<GpuCulling::CommandBounds> commandBounds; // ÿӦİΧ
+
+    // CPU ڵ޳ͼǰڵѹʵֲ䣬ֻʵʼʵ
+    bool occlusionActive = false;                // ֮֡ĻǷʹڵ޳
+    float autoOccluderCoverage = 0.05f;          // ĻռȳֵԶΪڵ
+    size_t autoOccluderTriangles = 2000;         // ԶڵޣӵҪֶ
+    std::vector<InstanceData> occlusionInstanceData;
+    std::vector<GLuint> occlusionInstanceCommands;
+    std::vector<DrawElementsIndirectCommand> occlusionCommands;
+    std::unordered_set<const GameObject*> occludedObjects; // Ƶбڵ
+    GLuint occlusionInstanceBuffer = 0;
+    size_t occlusionInstanceBufferSize = 0;
+    GLuint occlusionIndirectBuffer = 0;
+    size_t occlusionIndirectBufferSize = 0;
+
+    // ǰͼʹõʵͼ壺GPU ޳ > CPU ڵ޳ > ȫʵ
+    GLuint activeInstanceBuffer() const;
+    GLuint activeIndirectBuffer() const;
+
+    // ϴηʱȣʵļϡ汾šѡ򼸺λ岼Ƿ仯ͬʱ¼ǰ״̬
+    bool updateInstanceSources(const GameObject* selected);
+    // 飬дʵݺͼϴ
+    void buildInstances(const GameObject* selected);
+    void clearInstances();
+
+    // ϴʽ壺ʱݣָ洢ȴһ֡Ļ
+    static void uploadStream(GLenum target, GLuint& buffer, size_t& capacity, const void* data, size_t size);
+
+    // ʵЧЩʵԺϲͬһ
+    static std::array<unsigned int, 5> textureKey(const PBRMaterial& material) {
+        return {
+            material.useAlbedoMap ? material.albedoMap : 0u,
+            material.useMetallicMap ? material.metallicMap : 0u,
+            material.useRoughnessMap ? material.roughnessMap : 0u,
+            material.useNormalMap ? material.normalMap : 0u,
+            material.useAOMap ? material.aoMap : 0u
+        };
+    }
+
+    // ѡĸ
+    static PBRMaterial highlightMaterial(const PBRMaterial& material);
+
+    // draw ʵ֣variants Ϊʱȫʹ shader򰴼ֵѡ
+    void drawColor(Shader* shader, ShaderVariants* variants, uint32_t baseKey,
+        const std::shared_ptr<GameObject>& selectedObject) const;
+
 public:
     // 캯
     Scene(LightManager& lightManager)
         : lightManager(lightManager) {
     }
 
+    ~Scene() {
+        if (instanceBuffer) glDeleteBuffers(1, &instanceBuffer);
+        if (indirectBuffer) glDeleteBuffers(1, &indirectBuffer);
+        if (occlusionInstanceBuffer) glDeleteBuffers(1, &occlusionInstanceBuffer);
+        if (occlusionIndirectBuffer) glDeleteBuffers(1, &occlusionIndirectBuffer);
+    }
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
     //  GameObject
     void addGameObject(const std::shared_ptr<GameObject>& obj) {
         gameObjects.push_back(obj);
@@ -31,25 +136,64 @@ public:
 
     // ³
     void update(float deltaTime, Shader& shader) {
+        CPU_PROFILE_SCOPE("Scene::update");
         for (auto& obj : gameObjects) {
             obj->update(deltaTime, shader);
         }
     }
 
+    // 鲢ϴʵݣÿ֡Ӱͳ֮ǰɾ֮һ
+    // 弯ϡ任ʺѡ嶼ûб仯ʱϴ
+    void prepareInstances(const std::shared_ptr<GameObject>& selectedObject);
+
+    // GPU ޳ʵ֣֮ draw / drawDepth ֻƿɼʵÿͼǰ
+    // hiZ ǿʱͬʱڵ޳ֻͼ
+    void cullInstances(const GpuCulling::Planes& planes, const HiZBuffer* hiZ = nullptr);
+
+    // һ޳ CPU ޳Ա
+    GpuCulling::ValidationResult validateCulling() const;
+
+    void setGpuCullingEnabled(bool enabled) { gpuCullingEnabled = enabled; }
+    bool isGpuCullingEnabled() const { return gpuCullingEnabled; }
+
+    // CPU ڵ޳դڵ岢о̬壬֮ draw / drawDepth ٻƱڵĲ
+    // Ӱ֮ͼ޳ͻ֮ǰã岻
+    void applyOcclusion(SoftwareOcclusion& occlusion, const glm::mat4& viewProjection);
+
+    void setAutoOccluderCoverage(float coverage) { autoOccluderCoverage = coverage; }
+    float getAutoOccluderCoverage() const { return autoOccluderCoverage; }
+
     // Ⱦ
     void draw(Shader& shader) const;
     void draw(Shader& shader, const std::shared_ptr<GameObject>& selectedObject) const;
+    // ƣÿλ baseKey ϼϹʵͲͼأѡӦĳ
+    void draw(ShaderVariants& variants, uint32_t baseKey, const std::shared_ptr<GameObject>& selectedObject) const;
 
     // ȾӰͼ
-    void drawShadowMaps(Shader& shadowShader)
-    {
-        for (const auto& obj : gameObjects)
-        {
-            shadowShader.setMat4("model", obj->getModelMatrix());
-            obj->getModel().Draw(shadowShader);
+    // ֻͨύλãƤӰԤpass
+    void drawDepth(Shader& depthShader) const;
+    // drawDepth ֣ʵһμӻƣ visitɵ÷Ƿλ
+    void drawDepthInstances(Shader& depthShader) const;
+    template <typename Visit>
+    void forEachDepthObject(Visit&& visit) const {
+        for (const auto& obj : gameObjects) {
+            if ((instancingEnabled && obj->isInstanceable()) || occludedObjects.count(obj.get())) {
+                continue;
+            }
+            visit(*obj);
         }
     }
 
+    // ʵأرʱÿ嵥
+    void setInstancingEnabled(bool enabled) { instancingEnabled = enabled; }
+    bool isInstancingEnabled() const { return instancingEnabled; }
+
+    // һ draw ύĻƵԼͲͰ
+    size_t getLastDrawCallCount() const { return lastDrawCalls; }
+    size_t getLastProgramSwitchCount() const { return lastProgramSwitches; }
+    size_t getIndirectCommandCount() const { return indirectCommands.size(); }
+    size_t getMaterialBucketCount() const { return materialBuckets.size(); }
+
 
     // л JSON
     nlohmann::json serialize() {
@@ -62,7 +206,8 @@ public:
                 {"modelPath", obj->getModel().getPath()},
                 {"position", {obj->getPosition().x, obj->getPosition().y, obj->getPosition().z}},
                 {"scale", {obj->getScale().x, obj->getScale().y, obj->getScale().z}},
-                {"rotation", {obj->getRotation().x, obj->getRotation().y, obj->getRotation().z}}
+                {"rotation", {obj->getRotation().x, obj->getRotation().y, obj->getRotation().z}},
+                {"occluder", obj->isOccluder()}
                 });
         }
 
@@ -87,6 +232,7 @@ public:
                 glm::vec3(objJson["scale"][0], objJson["scale"][1], objJson["scale"][2]),
                 glm::vec3(objJson["rotation"][0], objJson["rotation"][1], objJson["rotation"][2])
             );
+            obj->setOccluder(objJson.value("occluder", false));
             addGameObject(obj);
         }
 
@@ -0,0 +1,274 @@
+#include "ShaderCache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// KHR_parallel_shader_compile 不在 glad 生成的头文件中，函数类型在这里声明
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// 缓存文件头：魔数、二进制格式、长度
+constexpr uint32_t CACHE_MAGIC = 0x43534A5A; // "ZJSC"
+
+const char* stageName(GLenum type) {
+    switch (type) {
+    case GL_VERTEX_SHADER: return "VERTEX";
+    case GL_FRAGMENT_SHADER: return "FRAGMENT";
+    case GL_GEOMETRY_SHADER: return "GEOMETRY";
+    case GL_COMPUTE_SHADER: return "COMPUTE";
+    default: return "UNKNOWN";
+    }
+}
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+} // namespace
+
+ShaderCache& ShaderCache::instance() {
+    static ShaderCache cache;
+    return cache;
+}
+
+void ShaderCache::initialize(GLADloadproc loader) {
+    ensureInitialized();
+
+    // 并行编译：让驱动自行决定线程数
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxCompilerThreads = nullptr;
+    if (loader) {
+        if (hasExtension("GL_KHR_parallel_shader_compile")) {
+            maxCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsKHR"));
+        }
+        else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+            maxCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsARB"));
+        }
+    }
+    if (maxCompilerThreads) {
+        maxCompilerThreads(0xFFFFFFFFu);
+        parallelCompile = true;
+        deferring = true;
+    }
+
+    std::cout << "Shader cache: " << (cacheEnabled ? "enabled" : "unavailable")
+        << ", parallel compile: " << (parallelCompile ? "enabled" : "unavailable") << std::endl;
+}
+
+void ShaderCache::ensureInitialized() {
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+
+    auto glString = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+    };
+    driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+    // 驱动不提供任何二进制格式时无法缓存
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    cacheEnabled = formats > 0;
+    if (cacheEnabled) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cerr << "Failed to create shader cache directory: " << error.message() << std::endl;
+            cacheEnabled = false;
+        }
+    }
+}
+
+GLuint ShaderCache::createProgram(const std::vector<Stage>& stages, const std::string& label) {
+    ensureInitialized();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t key = hashStages(stages);
+    GLuint program = cacheEnabled ? loadBinary(key) : 0;
+    if (program) {
+        ++stats.loaded;
+        stats.submitMs += elapsedMs(start);
+        return program;
+    }
+
+    PendingProgram entry;
+    entry.program = glCreateProgram();
+    entry.label = label;
+    entry.key = key;
+    for (const Stage& stage : stages) {
+        const char* code = stage.second.c_str();
+        GLuint shader = glCreateShader(stage.first);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        glAttachShader(entry.program, shader);
+        entry.shaders.push_back(shader);
+        entry.types.push_back(stage.first);
+    }
+    if (cacheEnabled) {
+        glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(entry.program);
+    ++stats.compiled;
+    program = entry.program;
+
+    // 启动阶段并行编译时不查询状态，否则这里就会等待编译完成
+    if (deferring) {
+        pending.push_back(std::move(entry));
+    }
+    else if (checkProgram(entry) && cacheEnabled) {
+        saveBinary(entry.program, key);
+    }
+    stats.submitMs += elapsedMs(start);
+    return program;
+}
+
+void ShaderCache::finishPending() {
+    // 之后创建的程序（运行中加载的全景图、着色器变体）马上就要使用，直接检查
+    deferring = false;
+    if (pending.empty()) {
+        return;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t count = pending.size();
+    for (PendingProgram& entry : pending) {
+        // 提交后已被删除的程序（临时着色器）不再检查
+        if (!glIsProgram(entry.program)) {
+            for (GLuint shader : entry.shaders) {
+                glDeleteShader(shader);
+            }
+            continue;
+        }
+        if (checkProgram(entry) && cacheEnabled) {
+            saveBinary(entry.program, entry.key);
+        }
+    }
+    pending.clear();
+    double waitMs = elapsedMs(start);
+    stats.finishMs += waitMs;
+    std::cout << "Finished " << count << " parallel shader compiles in " << waitMs << " ms." << std::endl;
+}
+
+bool ShaderCache::checkProgram(const PendingProgram& entry) {
+    int success;
+    char infoLog[1024];
+    bool ok = true;
+    for (size_t i = 0; i < entry.shaders.size(); ++i) {
+        glGetShaderiv(entry.shaders[i], GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(entry.shaders[i], 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER::" << stageName(entry.types[i]) << "::COMPILATION_FAILED (" << entry.label << ")\n"
+                << infoLog << std::endl;
+            ok = false;
+        }
+    }
+
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(entry.program, 1024, NULL, infoLog);
+        std::cout << "ERROR::PROGRAM::LINKING_FAILED (" << entry.label << ")\n" << infoLog << std::endl;
+        ok = false;
+    }
+
+    // 删除着色器对象（仍附着在程序上，随程序一起释放）
+    for (GLuint shader : entry.shaders) {
+        glDeleteShader(shader);
+    }
+    if (!ok) {
+        ++stats.failed;
+    }
+    return ok;
+}
+
+uint64_t ShaderCache::hashStages(const std::vector<Stage>& stages) const {
+    // FNV-1a 64 位，类型和源码之间用 0 分隔
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        const unsigned char separator = 0;
+        hash ^= separator;
+        hash *= 1099511628211ull;
+    };
+    mix(driver.data(), driver.size());
+    for (const Stage& stage : stages) {
+        mix(&stage.first, sizeof(stage.first));
+        mix(stage.second.data(), stage.second.size());
+    }
+    return hash;
+}
+
+std::string ShaderCache::pathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + name;
+}
+
+GLuint ShaderCache::loadBinary(uint64_t key) {
+    std::ifstream file(pathFor(key), std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+
+    uint32_t header[3] = {};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || header[0] != CACHE_MAGIC || header[2] == 0) {
+        return 0;
+    }
+    std::vector<char> binary(header[2]);
+    file.read(binary.data(), binary.size());
+    if (!file) {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header[1], binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // 驱动更新等原因导致二进制失效，重新编译后会覆盖
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::saveBinary(GLuint program, uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::ofstream file(pathFor(key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return;
+    }
+    uint32_t header[3] = { CACHE_MAGIC, format, static_cast<uint32_t>(length) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(binary.data(), binary.size());
+    ++stats.written;
+}
@@ -0,0 +1,78 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 着色器程序缓存
+// - 以展开后的源码和驱动字符串的哈希为键，把 glGetProgramBinary 的结果存到 ./shader_cache，
+//   下次启动直接 glProgramBinary，跳过编译和链接；驱动不接受旧的二进制时重新编译并覆盖
+// - 驱动支持 KHR_parallel_shader_compile 时，从 initialize() 到 finishPending() 之间（启动阶段）
+//   编译和链接只提交不等待，错误检查和写缓存推迟到 finishPending()，多个程序在驱动的线程里同时编译
+class ShaderCache {
+public:
+    using Stage = std::pair<GLenum, std::string>;   // (着色器类型, 源码)
+
+    struct Stats {
+        size_t compiled;       // 实际编译的程序
+        size_t loaded;         // 从缓存加载的程序
+        size_t written;        // 写入缓存的程序
+        size_t failed;         // 编译或链接失败的程序
+        double submitMs;       // createProgram 中花费的 CPU 时间
+        double finishMs;       // finishPending 中等待编译完成的时间
+    };
+
+    static ShaderCache& instance();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // 查询驱动能力；loader 用于取得 glad 中没有的并行编译函数，为空时不使用并行编译
+    void initialize(GLADloadproc loader);
+
+    // 创建程序：先查缓存，未命中时编译链接；失败时仍返回程序对象（与原来的行为一致，只打印错误）
+    GLuint createProgram(const std::vector<Stage>& stages, const std::string& label);
+
+    // 等待所有推迟的程序完成，检查错误并写入缓存；之后创建的程序不再推迟
+    void finishPending();
+
+    bool isCacheEnabled() const { return cacheEnabled; }
+    bool isParallelCompileEnabled() const { return parallelCompile; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    ShaderCache() = default;
+
+    // 已提交但还没检查结果的程序
+    struct PendingProgram {
+        GLuint program;
+        std::vector<GLuint> shaders;
+        std::vector<GLenum> types;
+        std::string label;
+        uint64_t key;
+    };
+
+    bool initialized = false;
+    bool cacheEnabled = false;
+    bool parallelCompile = false;
+    bool deferring = false;      // 是否推迟检查新提交的程序
+    std::string driver;          // 厂商、渲染器和版本，参与哈希
+    std::string directory = "./shader_cache/";
+    std::vector<PendingProgram> pending;
+    Stats stats = {};
+
+    void ensureInitialized();
+    uint64_t hashStages(const std::vector<Stage>& stages) const;
+    std::string pathFor(uint64_t key) const;
+
+    GLuint loadBinary(uint64_t key);
+    void saveBinary(GLuint program, uint64_t key);
+
+    // 检查编译和链接结果，打印错误日志；返回是否成功
+    bool checkProgram(const PendingProgram& entry);
+};
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,164 @@
+#include "ShaderVariants.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// 接口变量类型的分量数，用于统计插值量
+int typeComponents(GLenum type) {
+    switch (type) {
+    case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL: return 1;
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 2;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 3;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: return 4;
+    case GL_FLOAT_MAT2: return 4;
+    case GL_FLOAT_MAT3: return 9;
+    case GL_FLOAT_MAT4: return 16;
+    default: return 4;
+    }
+}
+
+} // namespace
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath, uint32_t featureMask,
+    std::function<void(Shader&)> setup)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), featureMask(featureMask), setup(std::move(setup)) {
+}
+
+ShaderVariants::~ShaderVariants() {
+    for (auto& entry : variants) {
+        GL_STATE.deleteProgram(entry.second.shader->ID);
+    }
+}
+
+Shader& ShaderVariants::get(uint32_t key) {
+    key &= featureMask;
+    auto it = variants.find(key);
+    if (it != variants.end()) {
+        return *it->second.shader;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Variant variant;
+    variant.shader = std::make_unique<Shader>(vertexPath.c_str(), fragmentPath.c_str(), definesFor(key, featureMask));
+    double compileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    GLint linked = 0;
+    glGetProgramiv(variant.shader->ID, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        std::cerr << "Failed to build shader variant " << describe(key) << " of " << fragmentPath << std::endl;
+    }
+
+    if (setup) {
+        GLuint currentProgram = GL_STATE.getProgram();
+        variant.shader->use();
+        setup(*variant.shader);
+        GL_STATE.useProgram(currentProgram);
+    }
+
+    variant.info = { key, describe(key), compileMs, 0, 0, 0, 0, 0, 0, false };
+    totalCompileMs += compileMs;
+    return *variants.emplace(key, std::move(variant)).first->second.shader;
+}
+
+void ShaderVariants::analyze() {
+    for (auto& entry : variants) {
+        VariantInfo& info = entry.second.info;
+        GLuint program = entry.second.shader->ID;
+        std::string defines = definesFor(entry.first, featureMask);
+
+        // 链接后的程序只暴露顶点输入和片段输出，插值变量要分别编译可分离的单阶段程序来统计
+        countInterface(GL_VERTEX_SHADER, Shader::loadSource(vertexPath.c_str(), defines), GL_PROGRAM_OUTPUT,
+            info.vertexOutputs, info.vertexOutputComponents);
+        countInterface(GL_FRAGMENT_SHADER, Shader::loadSource(fragmentPath.c_str(), defines), GL_PROGRAM_INPUT,
+            info.fragmentInputs, info.fragmentInputComponents);
+
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &info.activeUniforms);
+        info.binarySize = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &info.binarySize);
+        info.analyzed = true;
+    }
+}
+
+std::vector<ShaderVariants::VariantInfo> ShaderVariants::getVariantInfos() const {
+    std::vector<VariantInfo> infos;
+    infos.reserve(variants.size());
+    for (const auto& entry : variants) {
+        infos.push_back(entry.second.info);
+    }
+    return infos;
+}
+
+std::string ShaderVariants::definesFor(uint32_t key, uint32_t featureMask) {
+    std::ostringstream defines;
+    defines << "#define SHADER_VARIANT\n";
+    if (key & SKINNED) defines << "#define SKINNED\n";
+    if (key & INSTANCED) defines << "#define INSTANCED\n";
+    if (key & DEBUG_VIEW) defines << "#define DEBUG_VIEW\n";
+    // 只有该着色器关心的开关才定义，否则保留运行时读取
+    if (featureMask & MATERIAL_MAP_MASK) {
+        defines << "#define MATERIAL_MAPS " << ((key & MATERIAL_MAP_MASK) >> MATERIAL_MAP_SHIFT) << "\n";
+    }
+    if (featureMask & DIRECTIONAL_MASK) {
+        defines << "#define DIRECTIONAL_LIGHT_COUNT " << ((key & DIRECTIONAL_MASK) >> DIRECTIONAL_SHIFT) << "\n";
+    }
+    return defines.str();
+}
+
+std::string ShaderVariants::describe(uint32_t key) {
+    static const char* mapNames[] = { "Albedo", "Metallic", "Roughness", "Normal", "AO" };
+
+    std::string name;
+    auto append = [&name](const std::string& part) {
+        if (!name.empty()) name += '|';
+        name += part;
+    };
+    if (key & SKINNED) append("Skinned");
+    if (key & INSTANCED) append("Instanced");
+    for (uint32_t i = 0; i < 5; ++i) {
+        if (key & (1u << (MATERIAL_MAP_SHIFT + i))) append(mapNames[i]);
+    }
+    if (key & DEBUG_VIEW) append("Debug");
+    uint32_t directional = (key & DIRECTIONAL_MASK) >> DIRECTIONAL_SHIFT;
+    if (directional) append("Dir" + std::to_string(directional));
+    return name.empty() ? "Base" : name;
+}
+
+void ShaderVariants::countInterface(GLenum stage, const std::string& source, GLenum programInterface,
+    int& count, int& components) {
+    count = 0;
+    components = 0;
+    if (source.empty()) {
+        return;
+    }
+
+    const char* code = source.c_str();
+    GLuint program = glCreateShaderProgramv(stage, 1, &code);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        count = components = -1;
+        GL_STATE.deleteProgram(program);
+        return;
+    }
+
+    GLint resources = 0;
+    glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &resources);
+    for (GLint i = 0; i < resources; ++i) {
+        char name[128];
+        glGetProgramResourceName(program, programInterface, i, sizeof(name), nullptr, name);
+        // 内置变量（gl_Position、gl_FragCoord）不占插值器
+        if (std::string(name).compare(0, 3, "gl_") == 0) {
+            continue;
+        }
+        const GLenum props[] = { GL_TYPE, GL_ARRAY_SIZE };
+        GLint values[2] = { 0, 1 };
+        glGetProgramResourceiv(program, programInterface, i, 2, props, 2, nullptr, values);
+        ++count;
+        components += typeComponents(values[0]) * std::max(values[1], 1);
+    }
+    GL_STATE.deleteProgram(program);
+}
@@ -0,0 +1,94 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "shader.h"
+
+// 着色器变体：同一组源文件按功能开关注入 #define 编译出多个程序，按键值缓存
+// - 键值的各位对应一项功能，绘制时按物体选择开关最少的变体，减少插值量和运行时分支
+// - 首次用到某个键值时才编译；featureMask 之外的位被忽略，避免与该着色器无关的开关产生重复变体
+class ShaderVariants {
+public:
+    enum Feature : uint32_t {
+        SKINNED = 1u << 0,         // 骨骼动画
+        INSTANCED = 1u << 1,       // 实例化：模型矩阵和材质常量来自实例属性
+        // 2~6 位：使用的材质贴图，与 FrameUniforms::TextureFlag 左移 MATERIAL_MAP_SHIFT 后对应
+        DEBUG_VIEW = 1u << 7,      // 深度 / 材质调试视图
+        // 8~10 位：方向光数量分档（0 ~ MAX_DIRECTIONAL_LIGHTS）
+    };
+
+    static constexpr uint32_t MATERIAL_MAP_SHIFT = 2;
+    static constexpr uint32_t MATERIAL_MAP_MASK = 0x1Fu << MATERIAL_MAP_SHIFT;
+    static constexpr uint32_t DIRECTIONAL_SHIFT = 8;
+    static constexpr uint32_t DIRECTIONAL_MASK = 0x7u << DIRECTIONAL_SHIFT;
+    static constexpr uint32_t ALL_FEATURES = SKINNED | INSTANCED | MATERIAL_MAP_MASK | DEBUG_VIEW | DIRECTIONAL_MASK;
+
+    static uint32_t materialBits(unsigned int textureFlags) {
+        return (textureFlags << MATERIAL_MAP_SHIFT) & MATERIAL_MAP_MASK;
+    }
+    static uint32_t directionalBits(int count) {
+        return (static_cast<uint32_t>(count < 0 ? 0 : (count > 4 ? 4 : count)) << DIRECTIONAL_SHIFT) & DIRECTIONAL_MASK;
+    }
+
+    // 单个变体的统计，analyze() 之后才有编译结果以外的数据
+    struct VariantInfo {
+        uint32_t key;
+        std::string name;          // 由开关拼成的可读名字
+        double compileMs;          // 编译 + 链接耗时（CPU 侧，不含驱动的延迟编译）
+        int vertexOutputs;         // 顶点着色器的输出变量数
+        int vertexOutputComponents;
+        int fragmentInputs;        // 片段着色器实际读取的插值变量数
+        int fragmentInputComponents;
+        int activeUniforms;
+        GLint binarySize;          // 程序二进制大小，作为指令数的近似（驱动不支持时为 0）
+        bool analyzed;
+    };
+
+    // setup 在每个变体编译后调用一次，用于设置纹理单元等不随绘制变化的 uniform
+    ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath, uint32_t featureMask,
+        std::function<void(Shader&)> setup = nullptr);
+    ~ShaderVariants();
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // 取得键值对应的变体，不存在时编译
+    Shader& get(uint32_t key);
+
+    // 为已编译的变体统计输入输出和程序大小（需要额外编译可分离程序，只在界面请求时调用）
+    void analyze();
+
+    uint32_t getFeatureMask() const { return featureMask; }
+    size_t getVariantCount() const { return variants.size(); }
+    double getTotalCompileMs() const { return totalCompileMs; }
+    std::vector<VariantInfo> getVariantInfos() const;
+
+    // 键值对应的 #define 行和可读名字
+    static std::string definesFor(uint32_t key, uint32_t featureMask);
+    static std::string describe(uint32_t key);
+
+private:
+    struct Variant {
+        std::unique_ptr<Shader> shader;
+        VariantInfo info;
+    };
+
+    std::string vertexPath;
+    std::string fragmentPath;
+    uint32_t featureMask;
+    std::function<void(Shader&)> setup;
+    std::map<uint32_t, Variant> variants;
+    double totalCompileMs = 0.0;
+
+    // 编译单个阶段的可分离程序，统计其输入或输出接口
+    static void countInterface(GLenum stage, const std::string& source, GLenum programInterface,
+        int& count, int& components);
+};
+
+#endif // SHADER_VARIANTS_H
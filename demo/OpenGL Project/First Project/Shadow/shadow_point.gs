@@ -1,8 +1,9 @@
-#version 330 core
+#version 400 core
 layout (triangles) in;
 layout (triangle_strip, max_vertices=18) out;
 
 uniform mat4 shadowMatrices[6];
+uniform int cubeLayer;    // 当前点光源在立方体贴图数组中的下标
 
 out vec4 FragPos; // FragPos from GS (output per emitvertex)
 
@@ -10,7 +11,7 @@ void main()
 {
     for(int face = 0; face < 6; ++face)
     {
-        gl_Layer = face; // 指定渲染到立方体贴图的哪一面
+        gl_Layer = cubeLayer * 6 + face; // 指定渲染到立方体贴图数组的哪一层
         for(int i = 0; i < 3; ++i) // 对每个三角形的顶点
         {
             FragPos = gl_in[i].gl_Position;
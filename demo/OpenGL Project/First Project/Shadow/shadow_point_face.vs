@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 5) in ivec4 aBoneIDs; // 骨骼ID（蒙皮流）
+layout (location = 6) in vec4 aWeights;  // 骨骼权重（蒙皮流）
+layout (location = 7) in mat4 aInstanceModel; // 实例化：模型矩阵（占用 7~10）
+
+uniform mat4 model;
+uniform mat4 shadowMatrix; // 当前立方体面的投影 * 视图矩阵
+
+const int MAX_BONES = 100;
+uniform mat4 bones[MAX_BONES];
+uniform bool useBones;  // 是否使用骨骼动画
+uniform bool useInstancing; // 是否从实例属性读取模型矩阵
+
+// 计算蒙皮后的模型矩阵；权重全为 0（没有蒙皮流）时按单位骨骼处理
+mat4 skinnedModel()
+{
+    mat4 baseModel = useInstancing ? aInstanceModel : model;
+    float totalWeight = aWeights.x + aWeights.y + aWeights.z + aWeights.w;
+    if (!useBones || totalWeight <= 0.0)
+        return baseModel;
+    mat4 boneTransform = aWeights[0] * bones[aBoneIDs[0]] +
+                         aWeights[1] * bones[aBoneIDs[1]] +
+                         aWeights[2] * bones[aBoneIDs[2]] +
+                         aWeights[3] * bones[aBoneIDs[3]];
+    return baseModel * boneTransform;
+}
+
+out vec4 FragPos;
+
+void main()
+{
+    FragPos = skinnedModel() * vec4(position, 1.0);
+    gl_Position = shadowMatrix * FragPos;
+}
@@ -0,0 +1,42 @@
+#version 430 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 position;
+layout (location = 5) in ivec4 aBoneIDs; // 骨骼ID（蒙皮流）
+layout (location = 6) in vec4 aWeights;  // 骨骼权重（蒙皮流）
+layout (location = 7) in mat4 aInstanceModel; // 实例化：模型矩阵（占用 7~10）
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform int faceList[6];  // 需要渲染的立方体面，按实例号依次取用；实例化绘制时只用 faceList[0]
+uniform int cubeLayer;    // 当前点光源在立方体贴图数组中的下标
+
+const int MAX_BONES = 100;
+uniform mat4 bones[MAX_BONES];
+uniform bool useBones;  // 是否使用骨骼动画
+uniform bool useInstancing; // 是否从实例属性读取模型矩阵
+
+// 计算蒙皮后的模型矩阵；权重全为 0（没有蒙皮流）时按单位骨骼处理
+mat4 skinnedModel()
+{
+    mat4 baseModel = useInstancing ? aInstanceModel : model;
+    float totalWeight = aWeights.x + aWeights.y + aWeights.z + aWeights.w;
+    if (!useBones || totalWeight <= 0.0)
+        return baseModel;
+    mat4 boneTransform = aWeights[0] * bones[aBoneIDs[0]] +
+                         aWeights[1] * bones[aBoneIDs[1]] +
+                         aWeights[2] * bones[aBoneIDs[2]] +
+                         aWeights[3] * bones[aBoneIDs[3]];
+    return baseModel * boneTransform;
+}
+
+out vec4 FragPos;
+
+void main()
+{
+    // 每个实例对应一个可见面，在顶点着色器中直接选择目标层
+    int face = useInstancing ? faceList[0] : faceList[gl_InstanceID];
+    FragPos = skinnedModel() * vec4(position, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+    gl_Layer = cubeLayer * 6 + face;
+}
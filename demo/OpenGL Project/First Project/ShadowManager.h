@@ -3,6 +3,9 @@
 #define SHADOW_MANAGER_H
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -10,293 +13,729 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glad/glad.h>
 #include "Light.h"
+#include "LightStorage.h"
 #include "Scene.h"
-#include "Shader.h"
+#include "shader.h"
+#include "GpuProfiler.h"
+#include "GLStateCache.h"
 
+// ԴӰȾ·
+enum class PointShadowPath
+{
+    GeometryShader, // ɫÿηŴ 6 
+    VertexLayer,    // ʵƣÿʵӦһɼ棬ɫд gl_LayerҪչ֧֣
+    PerFace         // 渽Ųƣ޳壬κչ
+};
+
+// Ӱһ FBO
+//  -  / ۹дͬһ 2D 飬ÿԴռһеһӿھ
+//  - Դдͬһͼ飬ÿԴռ 6 Ĳ
+//  - ʹüӰ׶Ƭϣռͬһеĸ
 class ShadowManager
 {
 private:
-    class ShadowResource
+    struct ShadowData
     {
-    public:
-        GLuint framebuffer = 0;
-        GLuint texture = 0;
-        bool isCubeMap = false;
-
-        ShadowResource() = default;
-
-        ShadowResource(GLuint fb, GLuint tex, bool cubeMap = false)
-            : framebuffer(fb), texture(tex), isCubeMap(cubeMap) {
-        }
-
-        ~ShadowResource()
-        {
-            if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
-            if (texture)
-            {
-                glDeleteTextures(1, &texture);
-            }
-        }
-
-        GLuint getFramebuffer() const { return framebuffer; }
-        GLuint getTexture() const { return texture; }
-
+        LightType type;
+        int layer;        // 2D ţԴΪͼе±
+        int slotBase;     // Ӱλеʼ±
+        int slotCount;    // ռõĲλΪΪ 10 ʾӰ
+        uint64_t version; // λӦĹԴ汾0 ʾδ
     };
 
-    struct ShadowData
+    // һλӦӰеһ򣬹ռ slotMatrices ͬһ±
+    struct ShadowSlot
     {
-        std::unique_ptr<ShadowResource> resource;
-        LightType type;
-        int resolution;
+        int layer;
+        glm::ivec4 rect;  // ڵӿھ (x, y, width, height)λΪ
     };
 
     std::vector<ShadowData> shadowDatas;
-
-    // Helper function to create shadow resources
-    void setupShadowResources(ShadowData& data, int resolution, LightType type)
+    std::vector<ShadowSlot> shadowSlots;
+
+    // ϴɫĲλ飬ֻڲֱ֡ʻԴԱ仯ʱ
+    std::vector<glm::mat4> slotMatrices;  // ԴͶӰ * ͼ󣨵Դʹã
+    std::vector<glm::vec4> slotRects;
+    std::vector<glm::ivec2> lightSlots;
+
+    // ǰֶӦĹԴṹ汾ͼãһʱ·λ
+    bool layoutValid = false;
+    uint64_t layoutStructureVersion = 0;
+    bool layoutHasCamera = false;
+    int layoutCascadeCount = 0;
+
+    GLuint framebuffer = 0;
+    GLuint shadowArray = 0;      // GL_TEXTURE_2D_ARRAY
+    GLuint shadowCubeArray = 0;  // GL_TEXTURE_CUBE_MAP_ARRAY
+    GLuint rawDepthSampler = 0;  // ȱȽϵĲ
+
+    int resolution = 2048;       // ǰֱ
+    int arrayLayers = 0;         // 2D ѷĲ
+    int cubeCount = 0;           // ͼѷ
+
+    // Ӱ
+    int cascadeCount = 4;              // 2~4ÿռòڵķ֮һ
+    float cascadeSplitLambda = 0.75f;  // ȻֵĻȨ
+    float shadowDistance = 60.0f;      // ǵԶӾ
+    float casterDistance = 100.0f;     // Դ϶Ͷ
+    glm::vec4 cascadeSplits = glm::vec4(0.0f); // ÿһԶӾ
+
+    // ԴӰ·ʱ¼ GpuProfiler  "Point Lights" 
+    PointShadowPath pointShadowPath = PointShadowPath::GeometryShader;
+
+    // ׶Ϣ Renderer ÿ֡
+    bool hasCamera = false;
+    glm::mat4 cameraView = glm::mat4(1.0f);
+    float cameraFovY = glm::radians(45.0f);
+    float cameraAspect = 1.0f;
+    float cameraNear = 0.1f;
+
+    // 裨£飬ֻڹԴѷʱؽ
+    void ensureCapacity(int needLayers, int needCubes)
     {
-        GLuint fb, tex;
-        glGenFramebuffers(1, &fb);
-        glGenTextures(1, &tex);
-
-        if (type == LightType::Point)
+        if (framebuffer == 0)
         {
-            // ͼڵԴӰ
-            glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
-            for (unsigned int i = 0; i < 6; ++i)
-            {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-                    resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-            }
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LESS);
-
-            // 󶨵֡
-            glBindFramebuffer(GL_FRAMEBUFFER, fb);
-            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tex, 0);
-            glDrawBuffer(GL_NONE);
-            glReadBuffer(GL_NONE);
-            checkFramebufferStatus(fb);
+            glGenFramebuffers(1, &framebuffer);
+        }
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // ߷ֱÿۺܸߣʵҪ䣨 1 㣬֤Ч
+        auto roundUp = [](int n) { return std::max(1, n); };
 
-            data.resource = std::make_unique<ShadowResource>(fb, tex, true);
-            data.resolution = resolution;
-            data.type = LightType::Point;
+        // ԭʼͼ󸲸ıȽģʽ PCSS ڵͼʹ
+        if (rawDepthSampler == 0)
+        {
+            glGenSamplers(1, &rawDepthSampler);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(rawDepthSampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
         }
-        else // DirectionalLight  SpotLight
+
+        if (shadowArray == 0 || needLayers > arrayLayers)
         {
-            glBindTexture(GL_TEXTURE_2D, tex);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            arrayLayers = roundUp(needLayers);
+            if (shadowArray) GL_STATE.deleteTextures(1, &shadowArray);
+            glGenTextures(1, &shadowArray);
+            GL_STATE.bindTexture(0, GL_TEXTURE_2D_ARRAY, shadowArray);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, resolution, resolution, arrayLayers,
+                0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            // ȱȽϣ LINEAR ˵õӲ˫ PCF
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
             float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LESS);
+            glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+            GL_STATE.bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+        }
 
-            // 󶨵֡
-            glBindFramebuffer(GL_FRAMEBUFFER, fb);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, tex, 0);
+        if (shadowCubeArray == 0 || needCubes > cubeCount)
+        {
+            cubeCount = roundUp(needCubes);
+            if (shadowCubeArray) GL_STATE.deleteTextures(1, &shadowCubeArray);
+            glGenTextures(1, &shadowCubeArray);
+            GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP_ARRAY, shadowCubeArray);
+            glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT, resolution, resolution, cubeCount * 6,
+                0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+            // ֲ㸽ͼ飬һ
+            GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowCubeArray, 0);
             glDrawBuffer(GL_NONE);
             glReadBuffer(GL_NONE);
-            checkFramebufferStatus(fb);
+            checkFramebufferStatus(framebuffer);
+            GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+    }
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    void releaseResources()
+    {
+        if (framebuffer) GL_STATE.deleteFramebuffers(1, &framebuffer);
+        if (shadowArray) GL_STATE.deleteTextures(1, &shadowArray);
+        if (shadowCubeArray) GL_STATE.deleteTextures(1, &shadowCubeArray);
+        if (rawDepthSampler) glDeleteSamplers(1, &rawDepthSampler);
+        framebuffer = shadowArray = shadowCubeArray = rawDepthSampler = 0;
+        arrayLayers = cubeCount = 0;
+    }
 
-            data.resource = std::make_unique<ShadowResource>(fb, tex, false);
-            data.resolution = resolution;
-            data.type = type;
-        }
+    //  c ڲڵӿھΣĸ
+    glm::ivec4 cascadeRect(int c) const
+    {
+        int half = resolution / 2;
+        return glm::ivec4((c % 2) * half, (c / 2) * half, half, half);
     }
 
-    void checkFramebufferStatus(GLuint framebuffer)
+    //  practical split scheme ÿһԶӾ
+    void computeCascadeSplits()
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE)
+        float nearP = cameraNear;
+        float farP = std::max(shadowDistance, nearP + 1.0f);
+        cascadeSplits = glm::vec4(farP);
+        for (int c = 0; c < cascadeCount; ++c)
         {
-            throw std::runtime_error("Framebuffer incomplete: " + std::to_string(status));
+            float p = static_cast<float>(c + 1) / static_cast<float>(cascadeCount);
+            float logSplit = nearP * std::pow(farP / nearP, p);
+            float uniformSplit = nearP + (farP - nearP) * p;
+            cascadeSplits[c] = cascadeSplitLambda * logSplit + (1.0f - cascadeSplitLambda) * uniformSplit;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
-public:
-    ShadowManager() = default;
+    // ðΧ׶Ƭ [splitNear, splitFar]ԭ뵽رƶʱ˸
+    glm::mat4 computeCascadeMatrix(const glm::vec3& lightDir, float splitNear, float splitFar, int texels) const
+    {
+        glm::mat4 invView = glm::inverse(cameraView);
+        float tanHalfFov = std::tan(cameraFovY * 0.5f);
 
-    ~ShadowManager() = default;
+        // ׶Ƭ 8 ǵ㣨ռ䣩
+        glm::vec3 corners[8];
+        int n = 0;
+        for (float d : { splitNear, splitFar })
+        {
+            float h = d * tanHalfFov;
+            float w = h * cameraAspect;
+            for (int y = -1; y <= 1; y += 2)
+            {
+                for (int x = -1; x <= 1; x += 2)
+                {
+                    corners[n++] = glm::vec3(invView * glm::vec4(x * w, y * h, -d, 1.0f));
+                }
+            }
+        }
+
+        glm::vec3 center(0.0f);
+        for (const auto& corner : corners)
+            center += corner;
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for (const auto& corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f; // 뾶ͶӰСȶ
+
+        glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+        if (std::abs(lightDir.y) > 0.99f)
+            up = glm::vec3(1.0f, 0.0f, 0.0f); // Դƽ
+
+        glm::mat4 lightView = glm::lookAt(center - lightDir * radius, center, up);
+        glm::mat4 lightProj = glm::ortho(-radius, radius, -radius, radius, -casterDistance, 2.0f * radius);
+
+        // ض룺ԭͶӰλȡ
+        glm::vec4 origin = lightProj * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        origin *= static_cast<float>(texels) * 0.5f;
+        glm::vec4 offset = (glm::round(origin) - origin) * (2.0f / static_cast<float>(texels));
+        lightProj[3][0] += offset.x;
+        lightProj[3][1] += offset.y;
 
-    void syncShadowDataWithLights(const std::vector<Light*>& lights)
+        return lightProj * lightView;
+    }
+
+    // вλĹռ
+    void updateSlotMatrices(const LightStorage& lights)
     {
-        // ȷ shadowDatas ĴС lights һ
-        while (shadowDatas.size() < lights.size())
+        if (hasCamera)
+            computeCascadeSplits();
+
+        // ǰ±꼴ڷеλãÿ֡
+        const auto& dirs = lights.directionals();
+        for (size_t i = 0; i < dirs.size() && i < shadowDatas.size(); ++i)
         {
-            ShadowData newData;
-            LightType type = lights[shadowDatas.size()]->getType();
-            setupShadowResources(newData, 2048, type); // ʼֱΪ2048
-            shadowDatas.emplace_back(std::move(newData));
+            ShadowData& data = shadowDatas[i];
+            if (data.slotCount == 0 || (!hasCamera && data.version == dirs.version[i]))
+                continue;
+            for (int c = 0; c < data.slotCount; ++c)
+            {
+                int slot = data.slotBase + c;
+                if (hasCamera)
+                {
+                    float splitNear = (c == 0) ? cameraNear : cascadeSplits[c - 1];
+                    slotMatrices[slot] = computeCascadeMatrix(dirs.direction[i], splitNear, cascadeSplits[c], shadowSlots[slot].rect.z);
+                }
+                else
+                {
+                    DirectionalLight light = dirs.get(i);
+                    slotMatrices[slot] = light.getProjectionMatrix() * light.getViewMatrix();
+                }
+            }
+            data.version = dirs.version[i];
         }
-        while (shadowDatas.size() > lights.size())
+
+        // ۹ֻԱ仯¼
+        const auto& spots = lights.spots();
+        size_t spotBase = lights.spotBase();
+        for (size_t i = 0; i < spots.size() && spotBase + i < shadowDatas.size(); ++i)
         {
-            // ɾӰԴ
-            shadowDatas.back().resource.reset();
-            shadowDatas.pop_back();
+            ShadowData& data = shadowDatas[spotBase + i];
+            if (data.slotCount == 0 || data.version == spots.version[i])
+                continue;
+            SpotLight light = spots.get(i);
+            slotMatrices[data.slotBase] = light.getProjectionMatrix() * light.getViewMatrix();
+            data.version = spots.version[i];
         }
     }
 
-    // ޸Ϊͬɫ
-    void generateShadowMaps(const std::vector<Light*>& lights, Scene& scene, Shader& shadowShader, Shader& pointShadowShader)
+    // λӰе uv λã沼ֺͷֱʱ仯
+    void updateSlotRects()
     {
-        syncShadowDataWithLights(lights);
+        slotRects.resize(shadowSlots.size());
+        float inv = 1.0f / static_cast<float>(resolution);
+        for (size_t i = 0; i < shadowSlots.size(); ++i)
+        {
+            const ShadowSlot& slot = shadowSlots[i];
+            slotRects[i] = glm::vec4(slot.rect.x * inv, slot.rect.y * inv, slot.rect.z * inv, static_cast<float>(slot.layer));
+        }
+    }
 
-        GLint viewport[4];
-        glGetIntegerv(GL_VIEWPORT, viewport);
+    // İΧλΪģ뾶ȡΧнǵԶ룬ת޹
+    static void getBoundingSphere(const GameObject& obj, glm::vec3& center, float& radius)
+    {
+        center = obj.getPosition();
+        const BoundingBox& box = obj.getBoundingBox();
+        glm::vec3 extent = glm::max(glm::abs(box.min - center), glm::abs(box.max - center));
+        radius = glm::length(extent);
+    }
 
-        glCullFace(GL_FRONT); // ӰϵPeter PanningЧӦ
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_POLYGON_OFFSET_FILL);
-        glPolygonOffset(1.0f, 1.0f);
+    // жϰΧԹԴλ d뾶 rǷĳཻ
+    // ˳ PointLight::getViewMatrices һ£+X, -X, +Y, -Y, +Z, -Z
+    static bool sphereInCubeFace(const glm::vec3& d, float r, int face)
+    {
+        int axis = face / 2;
+        float a = (face % 2 == 0) ? d[axis] : -d[axis];
+        if (a < -r)
+            return false;
+
+        // ĸƽ淨Ϊ (axis  other) / sqrt(2)
+        float rs = r * 1.41421356f;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (k == axis)
+                continue;
+            if (a - d[k] < -rs || a + d[k] < -rs)
+                return false;
+        }
+        return true;
+    }
 
-        for (size_t i = 0; i < lights.size(); ++i)
+    // ɫ·ÿ GS иƵ 6 
+    void renderPointShadowsGeometry(const LightStorage& lights, Scene& scene, Shader& pointShadowShader)
+    {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowCubeArray, 0);
+        GL_STATE.viewport(0, 0, resolution, resolution);
+        glClear(GL_DEPTH_BUFFER_BIT); // һ
+
+        pointShadowShader.use();
+        const auto& points = lights.points();
+        size_t pointBase = lights.pointBase();
+        for (size_t i = 0; i < points.size() && pointBase + i < shadowDatas.size(); ++i)
         {
-            Light* light = lights[i];
-            ShadowData& shadowData = shadowDatas[i];
+            const ShadowData& shadowData = shadowDatas[pointBase + i];
+            if (shadowData.slotCount == 0)
+                continue;
+
+            GpuProfileScope lightScope("Point Light", static_cast<int>(pointBase + i));
+            PointLight pointLight = points.get(i);
+            std::array<glm::mat4, 6> matrices = getCubeFaceMatrices(pointLight);
+            pointShadowShader.setMat4Array("shadowMatrices", matrices.data(), 6);
+            pointShadowShader.setInt("cubeLayer", shadowData.layer);
+            pointShadowShader.setFloat("far_plane", pointLight.farPlane);
+            pointShadowShader.setVec3("lightPos", pointLight.position);
+
+            // ֻԴԶƽ淶Χڵʵ
+            scene.cullInstances(GpuCulling::boxPlanes(pointLight.position, pointLight.farPlane));
+            scene.drawDepth(pointShadowShader);
+        }
+    }
 
-            Shader& currentShadowShader = (light->getType() == LightType::Point) ? pointShadowShader : shadowShader;
-            currentShadowShader.use();
+    // ɫѡ·ʵְ޳ƵӦ㣻ֻʵΧ򸲸ǵ
+    void renderPointShadowsVertexLayer(const LightStorage& lights, Scene& scene, Shader& layeredShader)
+    {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowCubeArray, 0);
+        GL_STATE.viewport(0, 0, resolution, resolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        layeredShader.use();
+        const auto& points = lights.points();
+        size_t pointBase = lights.pointBase();
+        for (size_t i = 0; i < points.size() && pointBase + i < shadowDatas.size(); ++i)
+        {
+            const ShadowData& shadowData = shadowDatas[pointBase + i];
+            if (shadowData.slotCount == 0)
+                continue;
+
+            GpuProfileScope lightScope("Point Light", static_cast<int>(pointBase + i));
+            PointLight pointLight = points.get(i);
+            glm::vec3 lightPos = pointLight.position;
+            float farPlane = pointLight.farPlane;
+            std::array<glm::mat4, 6> matrices = getCubeFaceMatrices(pointLight);
+            layeredShader.setMat4Array("shadowMatrices", matrices.data(), 6);
+            layeredShader.setInt("cubeLayer", shadowData.layer);
+            layeredShader.setFloat("far_plane", farPlane);
+            layeredShader.setVec3("lightPos", lightPos);
+
+            // ʵʱɫ̶ʹ faceList[0]
+            for (int face = 0; face < 6; ++face)
+            {
+                scene.cullInstances(GpuCulling::frustumPlanes(matrices[face]));
+                layeredShader.setIntArray("faceList", &face, 1);
+                scene.drawDepthInstances(layeredShader);
+            }
 
-            if (light->getType() == LightType::Point)
+            scene.forEachDepthObject([&](const GameObject& obj)
             {
-                // ԴҪȾ
-                PointLight* pointLight = dynamic_cast<PointLight*>(light);
-                if (!pointLight)
-                    continue;
-
-                glm::vec3 pos = pointLight->getPosition();
-                float near = pointLight->getNearPlane();
-                float far_plane = pointLight->getFarPlane();
-                GLfloat aspect = 1.0f;
-
-                /*
-                std::cout << "==== PointLight Params ====" << std::endl;
-                std::cout << "pos       = (" << pos.x << ", " << pos.y << ", " << pos.z << ")" << std::endl;
-                std::cout << "near      = " << near << std::endl;
-                std::cout << "far_plane = " << far_plane << std::endl;
-                std::cout << "aspect    = " << aspect << std::endl;
-                std::cout << "===========================" << std::endl;
-                */
-
-                // ͶӰ
-                glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), aspect, near, far_plane);
-
-                // ÿͼ
-                std::vector<glm::mat4> shadowTransforms;
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
-                shadowTransforms.push_back(shadowProj * glm::lookAt(pos, pos + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
-
-                // ݾ󵽼ɫ
-                for (unsigned int j = 0; j < 6; ++j)
+                glm::vec3 center;
+                float radius;
+                getBoundingSphere(obj, center, radius);
+                glm::vec3 d = center - lightPos;
+                if (glm::length(d) - radius > farPlane)
+                    return;
+
+                int faceList[6];
+                int faceCount = 0;
+                for (int face = 0; face < 6; ++face)
                 {
-                    currentShadowShader.setMat4("shadowMatrices[" + std::to_string(j) + "]", shadowTransforms[j]);
+                    if (sphereInCubeFace(d, radius, face))
+                        faceList[faceCount++] = face;
                 }
-                currentShadowShader.setFloat("far_plane", far_plane);
-                currentShadowShader.setVec3("lightPos", pos);
+                if (faceCount == 0)
+                    return;
 
-                // ֡ͼ
-                glBindFramebuffer(GL_FRAMEBUFFER, shadowData.resource->getFramebuffer());
-                glViewport(0, 0, shadowData.resolution, shadowData.resolution);
-                glClear(GL_DEPTH_BUFFER_BIT);
+                layeredShader.setIntArray("faceList", faceList, faceCount);
+                obj.drawDepth(layeredShader, faceCount);
+            });
+        }
+    }
 
-                // Ⱦ
-                scene.drawShadowMaps(currentShadowShader);
+    // ·ÿ浥Ϊһ㣬ʵְ׶޳ֻཻ
+    void renderPointShadowsPerFace(const LightStorage& lights, Scene& scene, Shader& faceShader)
+    {
+        GL_STATE.viewport(0, 0, resolution, resolution);
 
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            }
-            else // DirectionalLight  SpotLight
+        faceShader.use();
+        const auto& points = lights.points();
+        size_t pointBase = lights.pointBase();
+        for (size_t i = 0; i < points.size() && pointBase + i < shadowDatas.size(); ++i)
+        {
+            const ShadowData& shadowData = shadowDatas[pointBase + i];
+            if (shadowData.slotCount == 0)
+                continue;
+
+            GpuProfileScope lightScope("Point Light", static_cast<int>(pointBase + i));
+            PointLight pointLight = points.get(i);
+            glm::vec3 lightPos = pointLight.position;
+            float farPlane = pointLight.farPlane;
+            std::array<glm::mat4, 6> matrices = getCubeFaceMatrices(pointLight);
+            faceShader.setFloat("far_plane", farPlane);
+            faceShader.setVec3("lightPos", lightPos);
+
+            for (int face = 0; face < 6; ++face)
             {
-                // ʹ÷۹Ƶͼ
-                glm::mat4 lightSpaceMatrix = light->getProjectionMatrix() * light->getViewMatrix();
-                currentShadowShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-
-                // 2DӰͼ֡
-                glBindFramebuffer(GL_FRAMEBUFFER, shadowData.resource->getFramebuffer());
-
-                // ȾӰͼ
-                glViewport(0, 0, shadowData.resolution, shadowData.resolution);
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowCubeArray, 0, shadowData.layer * 6 + face);
                 glClear(GL_DEPTH_BUFFER_BIT);
-                scene.drawShadowMaps(currentShadowShader);
+                faceShader.setMat4("shadowMatrix", matrices[face]);
+
+                scene.cullInstances(GpuCulling::frustumPlanes(matrices[face]));
+                scene.drawDepthInstances(faceShader);
 
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                scene.forEachDepthObject([&](const GameObject& obj)
+                {
+                    glm::vec3 center;
+                    float radius;
+                    getBoundingSphere(obj, center, radius);
+                    glm::vec3 d = center - lightPos;
+                    if (glm::length(d) - radius > farPlane || !sphereInCubeFace(d, radius, face))
+                        return;
+
+                    obj.drawDepth(faceShader);
+                });
             }
         }
+    }
 
-        // ָOpenGL״̬
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glCullFace(GL_BACK);
-        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    // Դ 6 ͶӰ * ͼ
+    static std::array<glm::mat4, 6> getCubeFaceMatrices(const PointLight& pointLight)
+    {
+        glm::mat4 shadowProj = pointLight.getProjectionMatrix();
+        std::array<glm::mat4, 6> views = pointLight.getViewMatrices();
+        for (auto& view : views)
+        {
+            view = shadowProj * view;
+        }
+        return views;
+    }
 
-        // 鵱ǰ󶨵֡Ƿ
+    void checkFramebufferStatus(GLuint framebuffer)
+    {
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
         GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
         if (status != GL_FRAMEBUFFER_COMPLETE)
         {
-            std::cerr << "Framebuffer not complete! Status: " << status << std::endl;
+            throw std::runtime_error("Framebuffer incomplete: " + std::to_string(status));
         }
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
-    void updateShadowResolution(int newResolution)
+public:
+    ShadowManager() = default;
+
+    ~ShadowManager()
     {
-        for (auto& shadowData : shadowDatas)
+        releaseResources();
+    }
+
+    ShadowManager(const ShadowManager&) = delete;
+    ShadowManager& operator=(const ShadowManager&) = delete;
+
+    // ɫӰλĳ
+    static constexpr int MAX_SHADOW_SLOTS = 32;
+    // ͶӰĹԴޣֻǰ MAX_SHADOW_LIGHTS ԴӰͼ
+    static constexpr int MAX_SHADOW_LIGHTS = 16;
+
+    // ݹԴб·šλӿھ
+    // Դ±갴 ⡢Դ۹ Уֻǰ MAX_SHADOW_LIGHTS ¼Ӱ
+    // generateShadowMaps ڹԴɾñ仯ʱԶ
+    void syncShadowDataWithLights(const LightStorage& lights)
+    {
+        shadowDatas.resize(std::min(lights.size(), static_cast<size_t>(MAX_SHADOW_LIGHTS)));
+        shadowSlots.clear();
+
+        int nextLayer = 0;
+        int nextCube = 0;
+        for (size_t i = 0; i < shadowDatas.size(); ++i)
         {
-            if (shadowData.resolution != newResolution)
+            ShadowData& data = shadowDatas[i];
+            size_t dense = 0;
+            data.type = lights.locate(i, dense);
+            data.slotBase = static_cast<int>(shadowSlots.size());
+            data.version = 0;
+
+            int remaining = MAX_SHADOW_SLOTS - data.slotBase;
+            if (remaining <= 0)
+            {
+                // ޵ĹԴͶӰ
+                data.layer = -1;
+                data.slotCount = 0;
+                continue;
+            }
+
+            if (data.type == LightType::Point)
+            {
+                data.layer = nextCube++;
+                data.slotCount = std::min(1, remaining);
+            }
+            else if (data.type == LightType::Directional && hasCamera)
+            {
+                // ⣺ÿһռͬһеһ
+                data.layer = nextLayer++;
+                data.slotCount = std::min(cascadeCount, remaining);
+            }
+            else // SpotLightδʱķ
             {
-                // ɾԴ
-                shadowData.resource.reset();
-                // ´Դ
-                setupShadowResources(shadowData, newResolution, shadowData.type);
+                data.layer = nextLayer++;
+                data.slotCount = std::min(1, remaining);
+            }
+
+            for (int c = 0; c < data.slotCount; ++c)
+            {
+                ShadowSlot slot;
+                slot.layer = data.layer;
+                slot.rect = (data.type == LightType::Directional && hasCamera)
+                    ? cascadeRect(c)
+                    : glm::ivec4(0, 0, resolution, resolution);
+                shadowSlots.push_back(slot);
             }
         }
+
+        slotMatrices.assign(shadowSlots.size(), glm::mat4(1.0f));
+        updateSlotRects();
+        lightSlots.resize(shadowDatas.size());
+        for (size_t i = 0; i < shadowDatas.size(); ++i)
+            lightSlots[i] = glm::ivec2(shadowDatas[i].slotBase, shadowDatas[i].slotCount);
+
+        layoutValid = true;
+        layoutStructureVersion = lights.getStructureVersion();
+        layoutHasCamera = hasCamera;
+        layoutCascadeCount = cascadeCount;
+
+        ensureCapacity(nextLayer, nextCube);
+    }
+
+    // õǰ׶Ϸ⼶
+    void setCameraFrustum(const glm::mat4& view, float fovY, float aspect, float nearPlane)
+    {
+        cameraView = view;
+        cameraFovY = fovY;
+        cameraAspect = aspect;
+        cameraNear = nearPlane;
+        hasCamera = true;
     }
 
-    // ȡָԴӰͼ
-    GLuint getShadowTexture(int index) const
+    // Ƿ֧ڶɫд gl_Layer
+    static bool supportsVertexLayer()
     {
-        if (index < 0 || index >= static_cast<int>(shadowDatas.size()))
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
         {
-            throw std::out_of_range("Invalid shadow texture index");
+            const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (ext == nullptr)
+                continue;
+            std::string name(ext);
+            if (name == "GL_ARB_shader_viewport_layer_array" || name == "GL_AMD_vertex_shader_layer")
+                return true;
         }
-        return shadowDatas[index].resource->getTexture();
+        return false;
     }
 
-    // ȡָԴĹռ󣨽ڷ;۹ƣ
-    glm::mat4 getLightSpaceMatrix(const std::vector<Light*>& lights, int index) const
+    void setPointShadowPath(PointShadowPath path) { pointShadowPath = path; }
+    PointShadowPath getPointShadowPath() const { return pointShadowPath; }
+
+    void setCascadeCount(int count) { cascadeCount = glm::clamp(count, 2, 4); }
+    int getCascadeCount() const { return cascadeCount; }
+
+    void setCascadeSplitLambda(float lambda) { cascadeSplitLambda = glm::clamp(lambda, 0.0f, 1.0f); }
+    float getCascadeSplitLambda() const { return cascadeSplitLambda; }
+
+    void setShadowDistance(float distance) { shadowDistance = std::max(distance, 1.0f); }
+    float getShadowDistance() const { return shadowDistance; }
+
+    // /۹ʹ shadowShaderԴ·ѡɫȱٶӦɫʱ˵ɫ·
+    // ָΪ÷ӿڣɵ÷ṩѯǰӿڣ
+    void generateShadowMaps(const LightStorage& lights, Scene& scene, Shader& shadowShader, Shader& pointShadowShader,
+        const glm::ivec4& viewport, Shader* layeredShader = nullptr, Shader* faceShader = nullptr)
     {
-        if (index < 0 || index >= static_cast<int>(shadowDatas.size()))
+        // Դɾ״û仯ʱ·λ
+        if (!layoutValid || layoutStructureVersion != lights.getStructureVersion() || layoutHasCamera != hasCamera
+            || (hasCamera && layoutCascadeCount != cascadeCount))
         {
-            throw std::out_of_range("Invalid light space matrix index");
+            syncShadowDataWithLights(lights);
         }
 
-        const auto& light = lights[index];
-        if (light->getType() == LightType::Point)
+        GL_STATE.cullFace(GL_FRONT); // ӰϵPeter PanningЧӦ
+        GL_STATE.enable(GL_DEPTH_TEST);
+        GL_STATE.enable(GL_POLYGON_OFFSET_FILL);
+        GL_STATE.polygonOffset(1.0f, 1.0f);
+
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        //  / ۹ƣ㸽ţÿλӿھȾ
+        updateSlotMatrices(lights);
+        shadowShader.use();
+        for (size_t i = 0; i < shadowDatas.size(); ++i)
         {
-            // ԴûеһĹռ
-            return glm::mat4(1.0f);
+            const ShadowData& shadowData = shadowDatas[i];
+            if (shadowData.type == LightType::Point || shadowData.slotCount == 0)
+                continue;
+
+            GpuProfileScope lightScope(shadowData.type == LightType::Directional ? "Directional Light" : "Spot Light",
+                static_cast<int>(i));
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowArray, 0, shadowData.layer);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            for (int c = 0; c < shadowData.slotCount; ++c)
+            {
+                const ShadowSlot& slot = shadowSlots[shadowData.slotBase + c];
+                const glm::mat4& matrix = slotMatrices[shadowData.slotBase + c];
+                shadowShader.setMat4("lightSpaceMatrix", matrix);
+                GL_STATE.viewport(slot.rect.x, slot.rect.y, slot.rect.z, slot.rect.w);
+
+                // òλĹԴ׶޳ʵ
+                scene.cullInstances(GpuCulling::frustumPlanes(matrix));
+                scene.drawDepth(shadowShader);
+            }
         }
-        else
+
+        // Դǰ·Ⱦͼ飬¼ GPU ʱ
+        bool hasPointLight = false;
+        for (const auto& data : shadowDatas)
         {
-            return light->getProjectionMatrix() * light->getViewMatrix();
+            hasPointLight |= (data.type == LightType::Point);
         }
+
+        if (hasPointLight)
+        {
+            GpuProfileScope pointScope("Point Lights");
+            if (pointShadowPath == PointShadowPath::VertexLayer && layeredShader != nullptr)
+            {
+                renderPointShadowsVertexLayer(lights, scene, *layeredShader);
+            }
+            else if (pointShadowPath == PointShadowPath::PerFace && faceShader != nullptr)
+            {
+                renderPointShadowsPerFace(lights, scene, *faceShader);
+            }
+            else
+            {
+                renderPointShadowsGeometry(lights, scene, pointShadowShader);
+            }
+        }
+
+        GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // ָOpenGL״̬
+        GL_STATE.disable(GL_POLYGON_OFFSET_FILL);
+        GL_STATE.cullFace(GL_BACK);
+        GL_STATE.viewport(viewport.x, viewport.y, viewport.z, viewport.w);
+    }
+
+    void updateShadowResolution(int newResolution)
+    {
+        if (newResolution == resolution)
+            return;
+
+        // ֱʱ仯ʱؽȫ
+        resolution = newResolution;
+        releaseResources();
+
+        int layers = 0, cubes = 0;
+        for (const auto& data : shadowDatas)
+        {
+            if (data.layer < 0)
+                continue;
+            (data.type == LightType::Point ? cubes : layers)++;
+            for (int c = 0; c < data.slotCount; ++c)
+            {
+                shadowSlots[data.slotBase + c].rect = (data.type == LightType::Directional && hasCamera)
+                    ? cascadeRect(c)
+                    : glm::ivec4(0, 0, resolution, resolution);
+            }
+        }
+        updateSlotRects();
+        ensureCapacity(layers, cubes);
     }
+
+    // з / ۹ƹõ 2D Ӱ
+    GLuint getShadowArrayTexture() const { return shadowArray; }
+
+    // еԴõӰͼ
+    GLuint getShadowCubeArrayTexture() const { return shadowCubeArray; }
+
+    // ȡԭʼȣȽϣʱʹõĲ
+    GLuint getRawDepthSampler() const { return rawDepthSampler; }
+
+    // λ
+    int getShadowSlotCount() const { return static_cast<int>(shadowSlots.size()); }
+
+    // вλĹռ
+    const std::vector<glm::mat4>& getShadowMatrices() const { return slotMatrices; }
+
+    // вλӰеλãxy Ϊ uv ƫƣz Ϊ uv ţw ΪţԴΪ±꣩
+    const std::vector<glm::vec4>& getShadowRects() const { return slotRects; }
+
+    // ÿԴռõĲλ (x: ʼ±, y: )ֻǰ MAX_SHADOW_LIGHTS ԴͶӰ
+    const std::vector<glm::ivec2>& getLightSlots() const { return lightSlots; }
+
+    // ÿһԶӾ
+    glm::vec4 getCascadeSplits() const { return cascadeSplits; }
 };
 
 #endif // SHADOW_MANAGER_H
@@ -0,0 +1,313 @@
+#include "SoftwareOcclusion.h"
+#include "CpuProfiler.h"
+#include "CpuWorkers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef ENGINE_SSE
+namespace
+{
+    // 像素中心在边的内侧，或正好在边上且这条边归本三角形
+    inline __m128 insideEdge(__m128 edge, __m128 ownsEdge)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        return _mm_or_ps(_mm_cmpgt_ps(edge, zero), _mm_and_ps(ownsEdge, _mm_cmpeq_ps(edge, zero)));
+    }
+}
+#endif
+
+SoftwareOcclusion::SoftwareOcclusion(int width, int height)
+    : width(0), height(0), tilesX(0), tilesY(0), workerCount(defaultCpuWorkerCount()), viewProjection(1.0f)
+{
+    resize(width, height);
+}
+
+void SoftwareOcclusion::resize(int newWidth, int newHeight)
+{
+    width = (std::max(newWidth, 4) + 3) / 4 * 4;
+    height = std::max(newHeight, 1);
+    tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    depth.assign(static_cast<size_t>(width) * height, 1.0f);
+    tileTriangles.assign(static_cast<size_t>(tilesX) * tilesY, {});
+    triangles.clear();
+}
+
+void SoftwareOcclusion::beginFrame(const glm::mat4& newViewProjection)
+{
+    viewProjection = newViewProjection;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    triangles.clear();
+    for (auto& list : tileTriangles)
+        list.clear();
+    stats = Stats();
+}
+
+void SoftwareOcclusion::addOccluder(const glm::mat4& model, const void* positions, size_t stride, size_t vertexCount,
+    const unsigned int* indices, size_t indexCount)
+{
+    ++stats.occluders;
+
+    glm::mat4 mvp = viewProjection * model;
+    clipScratch.resize(vertexCount);
+    const char* bytes = static_cast<const char*>(positions);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const glm::vec3& p = *reinterpret_cast<const glm::vec3*>(bytes + i * stride);
+        clipScratch[i] = mvp * glm::vec4(p, 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount)
+            continue;
+        addTriangle(clipScratch[a], clipScratch[b], clipScratch[c]);
+    }
+}
+
+void SoftwareOcclusion::addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+    // 跨过近平面的三角形直接丢弃，只会少遮挡，结果仍然保守
+    const glm::vec4* clip[3] = { &a, &b, &c };
+    for (const glm::vec4* v : clip)
+    {
+        if (v->w <= 1e-5f || v->z < -v->w)
+            return;
+    }
+
+    // 三个顶点都在同一裁剪面外侧
+    if ((a.x < -a.w && b.x < -b.w && c.x < -c.w) || (a.x > a.w && b.x > b.w && c.x > c.w) ||
+        (a.y < -a.w && b.y < -b.w && c.y < -c.w) || (a.y > a.w && b.y > b.w && c.y > c.w) ||
+        (a.z > a.w && b.z > b.w && c.z > c.w))
+        return;
+
+    ScreenTriangle tri;
+    float z[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec4& v = *clip[i];
+        tri.x[i] = (v.x / v.w * 0.5f + 0.5f) * width;
+        tri.y[i] = (v.y / v.w * 0.5f + 0.5f) * height;
+        z[i] = v.z / v.w * 0.5f + 0.5f;
+    }
+
+    // 统一为逆时针，边函数在内部为正；遮挡体不做背面剔除
+    float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+    if (std::fabs(area) < 1e-6f)
+        return;
+    if (area < 0.0f)
+    {
+        std::swap(tri.x[1], tri.x[2]);
+        std::swap(tri.y[1], tri.y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    // 屏幕空间中 z/w 是线性的，求深度平面；常数项加上半个像素内的最大变化，取像素内的最远深度
+    float dzdx = ((z[1] - z[0]) * (tri.y[2] - tri.y[0]) - (z[2] - z[0]) * (tri.y[1] - tri.y[0])) / area;
+    float dzdy = ((z[2] - z[0]) * (tri.x[1] - tri.x[0]) - (z[1] - z[0]) * (tri.x[2] - tri.x[0])) / area;
+    tri.depthDx = dzdx;
+    tri.depthDy = dzdy;
+    tri.depth0 = z[0] - dzdx * tri.x[0] - dzdy * tri.y[0] + 0.5f * (std::fabs(dzdx) + std::fabs(dzdy));
+    tri.depthMax = std::min(std::max(z[0], std::max(z[1], z[2])), 1.0f);
+
+    // 像素中心落在三角形包围矩形内的像素
+    float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+    float maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+    float minY = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+    float maxY = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+    tri.minX = std::max(static_cast<int>(std::ceil(minX - 0.5f)), 0);
+    tri.maxX = std::min(static_cast<int>(std::floor(maxX - 0.5f)), width - 1);
+    tri.minY = std::max(static_cast<int>(std::ceil(minY - 0.5f)), 0);
+    tri.maxY = std::min(static_cast<int>(std::floor(maxY - 0.5f)), height - 1);
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+        return;
+
+    unsigned int index = static_cast<unsigned int>(triangles.size());
+    triangles.push_back(tri);
+    ++stats.triangles;
+
+    for (int ty = tri.minY / TILE_HEIGHT; ty <= tri.maxY / TILE_HEIGHT; ++ty)
+    {
+        for (int tx = tri.minX / TILE_WIDTH; tx <= tri.maxX / TILE_WIDTH; ++tx)
+            tileTriangles[static_cast<size_t>(ty) * tilesX + tx].push_back(index);
+    }
+}
+
+void SoftwareOcclusion::rasterize()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // 每个线程负责一段连续的 tile，tile 之间没有重叠，不需要同步
+    int tileCount = tilesX * tilesY;
+    int workers = triangles.size() < 64 ? 1 : std::min(workerCount, tileCount);
+    runOnWorkers(workers, tileCount, [this](int, int begin, int end) {
+        rasterizeTiles(begin, end);
+    });
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.rasterMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void SoftwareOcclusion::rasterizeTiles(int tileBegin, int tileEnd)
+{
+    CPU_PROFILE_SCOPE("SoftwareOcclusion::rasterizeTiles");
+    for (int t = tileBegin; t < tileEnd; ++t)
+    {
+        int tileMinX = (t % tilesX) * TILE_WIDTH;
+        int tileMinY = (t / tilesX) * TILE_HEIGHT;
+        int tileMaxX = std::min(tileMinX + TILE_WIDTH, width) - 1;
+        int tileMaxY = std::min(tileMinY + TILE_HEIGHT, height) - 1;
+        for (unsigned int index : tileTriangles[t])
+            rasterizeTriangle(triangles[index], tileMinX, tileMaxX, tileMinY, tileMaxY);
+    }
+}
+
+void SoftwareOcclusion::rasterizeTriangle(const ScreenTriangle& tri, int tileMinX, int tileMaxX, int tileMinY, int tileMaxY)
+{
+    // 起点按 4 对齐；tile 宽度是 4 的倍数，一组像素不会跨出 tile
+    int x0 = std::max(tri.minX, tileMinX) & ~3;
+    int x1 = std::min(tri.maxX, tileMaxX);
+    int y0 = std::max(tri.minY, tileMinY);
+    int y1 = std::min(tri.maxY, tileMaxY);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    // 边 i -> j 的边函数 E = A * x + B * y + C，三角形内部三条边均为正
+    // 像素中心正好在边上（E == 0）时按边的方向决定归属：公共边在相邻两个三角形中方向相反、E 互为相反数，
+    // 只归其中一个，四边形的对角线上不会留缝
+    float edgeA[3], edgeB[3], edgeC[3];
+    bool ownsEdge[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        int j = (i + 1) % 3;
+        edgeA[i] = tri.y[i] - tri.y[j];
+        edgeB[i] = tri.x[j] - tri.x[i];
+        edgeC[i] = tri.x[i] * tri.y[j] - tri.x[j] * tri.y[i];
+        ownsEdge[i] = edgeA[i] > 0.0f || (edgeA[i] == 0.0f && edgeB[i] > 0.0f);
+    }
+
+#ifdef ENGINE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+    const __m128 allOnes = _mm_cmpeq_ps(zero, zero);
+    const __m128 own0 = ownsEdge[0] ? allOnes : zero;
+    const __m128 own1 = ownsEdge[1] ? allOnes : zero;
+    const __m128 own2 = ownsEdge[2] ? allOnes : zero;
+    const __m128 dzdx = _mm_set1_ps(tri.depthDx);
+    const __m128 depthMax = _mm_set1_ps(tri.depthMax);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = y + 0.5f;
+        const __m128 row0 = _mm_set1_ps(edgeB[0] * py + edgeC[0]);
+        const __m128 row1 = _mm_set1_ps(edgeB[1] * py + edgeC[1]);
+        const __m128 row2 = _mm_set1_ps(edgeB[2] * py + edgeC[2]);
+        const __m128 rowDepth = _mm_set1_ps(tri.depth0 + tri.depthDy * py);
+        float* dst = &depth[static_cast<size_t>(y) * width];
+
+        for (int x = x0; x <= x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffset);
+            __m128 inside = _mm_and_ps(
+                _mm_and_ps(insideEdge(_mm_add_ps(_mm_mul_ps(a0, px), row0), own0),
+                           insideEdge(_mm_add_ps(_mm_mul_ps(a1, px), row1), own1)),
+                insideEdge(_mm_add_ps(_mm_mul_ps(a2, px), row2), own2));
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+
+            __m128 z = _mm_min_ps(_mm_add_ps(rowDepth, _mm_mul_ps(dzdx, px)), depthMax);
+            __m128 old = _mm_loadu_ps(dst + x);
+            __m128 result = _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(old, z)), _mm_andnot_ps(inside, old));
+            _mm_storeu_ps(dst + x, result);
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = y + 0.5f;
+        float* dst = &depth[static_cast<size_t>(y) * width];
+        for (int x = x0; x <= x1; ++x)
+        {
+            float px = x + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 3 && inside; ++i)
+            {
+                // 与 SIMD 路径相同的求值顺序，公共边两侧的 E 严格互为相反数
+                float edge = edgeA[i] * px + (edgeB[i] * py + edgeC[i]);
+                inside = edge > 0.0f || (edge == 0.0f && ownsEdge[i]);
+            }
+            if (inside)
+                dst[x] = std::min(dst[x], std::min(tri.depth0 + tri.depthDx * px + tri.depthDy * py, tri.depthMax));
+        }
+    }
+#endif
+}
+
+bool SoftwareOcclusion::projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, ScreenRect& rect) const
+{
+    glm::vec3 ndcMin(1e30f), ndcMax(-1e30f);
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w <= 1e-5f || clip.z < -clip.w)
+            return false;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+        return false;
+
+    // 覆盖到的所有像素，不只是像素中心落在内部的
+    rect.minX = std::max(static_cast<int>(std::floor((ndcMin.x * 0.5f + 0.5f) * width)), 0);
+    rect.maxX = std::min(static_cast<int>(std::floor((ndcMax.x * 0.5f + 0.5f) * width)), width - 1);
+    rect.minY = std::max(static_cast<int>(std::floor((ndcMin.y * 0.5f + 0.5f) * height)), 0);
+    rect.maxY = std::min(static_cast<int>(std::floor((ndcMax.y * 0.5f + 0.5f) * height)), height - 1);
+    rect.nearestDepth = std::min(ndcMin.z * 0.5f + 0.5f, 1.0f);
+    return true;
+}
+
+bool SoftwareOcclusion::isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    ++stats.tested;
+    ScreenRect rect;
+    if (!projectBox(boxMin, boxMax, rect))
+        return true;
+
+    // 只要有一个像素的遮挡深度不比包围盒最近点更近，就可能可见
+    for (int y = rect.minY; y <= rect.maxY; ++y)
+    {
+        const float* row = &depth[static_cast<size_t>(y) * width];
+        int x = rect.minX;
+#ifdef ENGINE_SSE
+        const __m128 nearest = _mm_set1_ps(rect.nearestDepth);
+        for (; x + 3 <= rect.maxX; x += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), nearest)) != 0)
+                return true;
+        }
+#endif
+        for (; x <= rect.maxX; ++x)
+        {
+            if (row[x] >= rect.nearestDepth)
+                return true;
+        }
+    }
+
+    ++stats.culled;
+    return false;
+}
+
+float SoftwareOcclusion::screenCoverage(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+    ScreenRect rect;
+    if (!projectBox(boxMin, boxMax, rect))
+        return 0.0f;
+    return static_cast<float>((rect.maxX - rect.minX + 1) * (rect.maxY - rect.minY + 1)) / (width * height);
+}
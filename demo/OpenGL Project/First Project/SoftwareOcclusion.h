@@ -0,0 +1,95 @@
+// SoftwareOcclusion.h
+#ifndef SOFTWARE_OCCLUSION_H
+#define SOFTWARE_OCCLUSION_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// CPU 软件遮挡剔除：把遮挡体的三角形光栅化到低分辨率深度缓冲，再用物体包围盒查询
+// 纯 CPU 实现，不依赖 OpenGL，可以单独测试
+// 深度与 OpenGL 一致映射到 [0, 1]，越大越远；缓冲中保存每个像素最近遮挡体的最远深度
+class SoftwareOcclusion
+{
+public:
+    struct Stats
+    {
+        size_t occluders = 0;   // 本帧提交的遮挡体
+        size_t triangles = 0;   // 裁剪后实际光栅化的三角形
+        size_t tested = 0;      // 查询的包围盒
+        size_t culled = 0;      // 被遮挡的包围盒
+        double rasterMs = 0.0;  // 光栅化耗时
+    };
+
+    // 宽度补齐到 4 的倍数，便于按 4 个像素一组处理
+    SoftwareOcclusion(int width = 256, int height = 128);
+
+    void resize(int width, int height);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // 设置工作线程数（<= 1 时在调用线程中完成）
+    void setWorkerCount(int count) { workerCount = count < 1 ? 1 : count; }
+    int getWorkerCount() const { return workerCount; }
+
+    // 开始新的一帧：清空深度和遮挡体
+    void beginFrame(const glm::mat4& viewProjection);
+
+    // 提交遮挡体的三角形；positions 按 stride 字节跨度读取，便于直接使用 Vertex 数组
+    void addOccluder(const glm::mat4& model, const void* positions, size_t stride, size_t vertexCount,
+        const unsigned int* indices, size_t indexCount);
+
+    // 光栅化本帧提交的全部遮挡体
+    void rasterize();
+
+    // 世界空间包围盒是否可能可见；跨过近平面或在屏幕外时视为可见
+    bool isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+    // 世界空间包围盒投影后覆盖屏幕的比例，用于自动挑选遮挡体
+    float screenCoverage(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    const std::vector<float>& getDepth() const { return depth; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    static constexpr int TILE_WIDTH = 64;
+    static constexpr int TILE_HEIGHT = 32;
+
+    // 屏幕空间三角形：顶点坐标、深度平面和像素包围矩形
+    struct ScreenTriangle
+    {
+        float x[3];
+        float y[3];
+        float depth0, depthDx, depthDy;   // 深度 = depth0 + depthDx * x + depthDy * y
+        float depthMax;                   // 三个顶点中的最远深度，限制插值结果
+        int minX, maxX, minY, maxY;
+    };
+
+    // 包围盒投影后的像素矩形和最近深度
+    struct ScreenRect
+    {
+        int minX, maxX, minY, maxY;
+        float nearestDepth;
+    };
+
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    int workerCount = 1;
+
+    glm::mat4 viewProjection;
+    std::vector<float> depth;
+    std::vector<ScreenTriangle> triangles;
+    std::vector<std::vector<unsigned int>> tileTriangles; // 每个 tile 覆盖到的三角形
+    std::vector<glm::vec4> clipScratch;
+    Stats stats;
+
+    void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void rasterizeTiles(int tileBegin, int tileEnd);
+    void rasterizeTriangle(const ScreenTriangle& tri, int tileMinX, int tileMaxX, int tileMinY, int tileMaxY);
+    // 投影失败（跨过近平面或完全在屏幕外）时返回 false
+    bool projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, ScreenRect& rect) const;
+};
+
+#endif // SOFTWARE_OCCLUSION_H
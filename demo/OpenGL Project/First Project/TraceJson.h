@@ -0,0 +1,32 @@
+// TraceJson.h
+#ifndef TRACE_JSON_H
+#define TRACE_JSON_H
+
+#include <cstdio>
+#include <string>
+
+// CPU / GPU 分析器导出 Chrome trace 时共用的字符串转义
+// 名字来自作用域名、线程名和光源序号，可能含有引号、反斜杠或控制字符；
+// 控制字符（0x00 ~ 0x1F）按 JSON 规范写成 \u00XX，其余字节原样输出
+inline std::string escapeJson(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        }
+        else if (byte < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", byte);
+            result += code;
+        }
+        else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+#endif // TRACE_JSON_H
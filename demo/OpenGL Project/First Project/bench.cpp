@@ -0,0 +1,281 @@
+// bench.cpp
+// 基准测试入口：在离屏上下文中加载场景，沿关键帧相机路径以固定时间步长渲染固定帧数，
+// 把帧时间统计、CPU / GPU 分阶段耗时和峰值内存写成 JSON，便于在提交之间比较渲染循环的性能
+#include "OffscreenContext.h"
+#include "CameraPath.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+void printUsage()
+{
+    std::cout << "Usage: bench [--scene scenes/default.json] [--path benchmarks/flythrough.json]\n"
+        << "             [--frames 600] [--warmup 30] [--width 1600] [--height 1200]\n"
+        << "             [--frame-time 0.016667] [--output bench_result.json]" << std::endl;
+}
+
+// 最小、平均、p95、p99 和最大值；百分位取最近的样本，与 CpuProfiler 相同
+nlohmann::ordered_json summarize(std::vector<double> samples)
+{
+    nlohmann::ordered_json result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5)];
+    };
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result["min"] = samples.front();
+    result["avg"] = sum / samples.size();
+    result["p95"] = percentile(0.95);
+    result["p99"] = percentile(0.99);
+    result["max"] = samples.back();
+    return result;
+}
+
+// 进程的峰值常驻内存（MB）
+double peakMemoryMb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);    // 字节
+#else
+    return usage.ru_maxrss / 1024.0;               // KB
+#endif
+#endif
+}
+
+// 按名字累计的耗时，保持首次出现的顺序
+struct PassTotals {
+    std::vector<std::string> order;
+    std::map<std::string, double> totalMs;
+    std::map<std::string, double> maxMs;
+    std::map<std::string, size_t> calls;
+
+    void add(const std::string& name, double ms, size_t count)
+    {
+        if (totalMs.find(name) == totalMs.end()) {
+            order.push_back(name);
+        }
+        totalMs[name] += ms;
+        maxMs[name] = std::max(maxMs[name], ms);
+        calls[name] += count;
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string scenePath = "./scenes/default.json";
+    std::string cameraPathFile;
+    std::string outputPath = "bench_result.json";
+    unsigned int width = 1600;
+    unsigned int height = 1200;
+    int frameCount = 600;
+    int warmupFrames = 30;
+    float frameTime = 1.0f / 60.0f;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) scenePath = argv[++i];
+        else if (arg == "--path" && hasValue) cameraPathFile = argv[++i];
+        else if (arg == "--output" && hasValue) outputPath = argv[++i];
+        else if (arg == "--width" && hasValue) width = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--height" && hasValue) height = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--frames" && hasValue) frameCount = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue) warmupFrames = std::atoi(argv[++i]);
+        else if (arg == "--frame-time" && hasValue) frameTime = static_cast<float>(std::atof(argv[++i]));
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (width == 0 || height == 0 || frameCount <= 0 || warmupFrames < 0 || frameTime <= 0.0f) {
+        printUsage();
+        return -1;
+    }
+    if (!std::ifstream(scenePath).is_open()) {
+        std::cerr << "Scene file not found: " << scenePath << std::endl;
+        return -1;
+    }
+
+    // 没有路径文件时相机停在默认位置
+    CameraPath cameraPath;
+    if (!cameraPathFile.empty() && !cameraPath.loadFromFile(cameraPathFile)) {
+        return -1;
+    }
+    if (!cameraPath.empty() && cameraPath.getDuration() > frameCount * frameTime + 1e-3f) {
+        std::cout << "Camera path lasts " << cameraPath.getDuration() << " s but only "
+            << frameCount * frameTime << " s are rendered; the rest of the path is skipped." << std::endl;
+    }
+
+    OffscreenContext offscreen;
+    if (!offscreen.create(static_cast<int>(width), static_cast<int>(height))) {
+        std::cerr << "Failed to create offscreen OpenGL context." << std::endl;
+        return -1;
+    }
+    ShaderCache::instance().initialize(OffscreenContext::loader());
+
+    GL_STATE.enable(GL_DEPTH_TEST);
+
+    ShadowManager shadowManager;
+    LightManager lightManager;
+    Scene scene(lightManager);
+    Camera camera(scene, glm::vec3(0.0f, 0.0f, 3.0f));
+
+    Renderer renderer(nullptr, width, height, camera, lightManager, shadowManager, scene);
+    if (!renderer.initialize()) {
+        std::cerr << "Failed to initialize Renderer." << std::endl;
+        return -1;
+    }
+    renderer.loadScene(scenePath);
+
+    // 预热帧停在路径起点，用于完成着色器编译和资源上传；之后的帧沿路径前进
+    CpuProfiler& cpuProfiler = CpuProfiler::instance();
+    GpuProfiler& gpuProfiler = GpuProfiler::instance();
+    while (gpuProfiler.collectPending()) {
+    }
+    size_t gpuFramesBefore = gpuProfiler.getCollectedFrames() + gpuProfiler.getDroppedFrames();
+    size_t gpuFramesSeen = 0;
+    size_t gpuCollectedSeen = gpuProfiler.getCollectedFrames();
+
+    std::vector<double> frameMs, cpuMs, gpuMs;
+    PassTotals cpuPasses, gpuPasses;
+    size_t gpuMeasured = 0;
+
+    // GPU 结果晚几帧读取；每次最多读取或丢弃一帧，且按提交顺序进行，第 n 次对应第 n 帧
+    auto consumeGpuResult = [&]() {
+        size_t processed = gpuProfiler.getCollectedFrames() + gpuProfiler.getDroppedFrames() - gpuFramesBefore;
+        if (processed == gpuFramesSeen) {
+            return;
+        }
+        gpuFramesSeen = processed;
+        bool collected = gpuProfiler.getCollectedFrames() != gpuCollectedSeen;
+        gpuCollectedSeen = gpuProfiler.getCollectedFrames();
+        if (!collected || processed - 1 < static_cast<size_t>(warmupFrames)) {
+            return;
+        }
+        for (const GpuProfiler::ScopeHistory& entry : gpuProfiler.getHistory()) {
+            if (entry.depth == 0) {
+                gpuMs.push_back(entry.lastMs);
+            }
+            else {
+                gpuPasses.add(entry.path, entry.lastMs, 1);
+            }
+        }
+        ++gpuMeasured;
+    };
+
+    int totalFrames = warmupFrames + frameCount;
+    std::cout << "Benchmarking " << frameCount << " frames (" << warmupFrames << " warm-up) at "
+        << width << "x" << height << "..." << std::endl;
+    for (int frame = 0; frame < totalFrames; ++frame) {
+        bool measured = frame >= warmupFrames;
+        if (!cameraPath.empty()) {
+            float pathTime = measured ? (frame - warmupFrames) * frameTime : 0.0f;
+            CameraPath::Pose pose = cameraPath.evaluate(pathTime);
+            camera.SetPose(pose.position, pose.yaw, pose.pitch);
+        }
+
+        int64_t zoneStart = cpuProfiler.now();
+        auto start = std::chrono::high_resolution_clock::now();
+        renderer.renderHeadlessFrame(frameTime);
+        auto submitted = std::chrono::high_resolution_clock::now();
+        glFinish();
+        auto finished = std::chrono::high_resolution_clock::now();
+
+        consumeGpuResult();
+        if (!measured) {
+            continue;
+        }
+        frameMs.push_back(std::chrono::duration<double, std::milli>(finished - start).count());
+        cpuMs.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+        for (const CpuProfiler::ZoneSummary& zone : cpuProfiler.summarizeZones(zoneStart)) {
+            cpuPasses.add(zone.name, zone.totalMs, zone.count);
+        }
+    }
+    // 读取最后几帧的 GPU 结果
+    while (gpuProfiler.collectPending()) {
+        consumeGpuResult();
+    }
+
+    nlohmann::ordered_json report;
+    report["scene"] = scenePath;
+    report["cameraPath"] = cameraPathFile;
+    report["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    report["glVersion"] = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    report["platform"] = offscreen.getPlatformName();
+    report["width"] = width;
+    report["height"] = height;
+    report["frames"] = frameCount;
+    report["warmupFrames"] = warmupFrames;
+    report["frameTime"] = frameTime;
+    report["frameMs"] = summarize(frameMs);
+    report["cpuSubmitMs"] = summarize(cpuMs);
+    report["gpuFrameMs"] = summarize(gpuMs);
+    report["gpuFramesMeasured"] = gpuMeasured;
+
+    // 每帧平均耗时；同名区间在一帧中出现多次（例如每个光源一次）时累加
+    nlohmann::ordered_json cpuBreakdown = nlohmann::ordered_json::array();
+    for (const std::string& name : cpuPasses.order) {
+        cpuBreakdown.push_back({
+            { "name", name },
+            { "avgMs", cpuPasses.totalMs[name] / frameCount },
+            { "maxMs", cpuPasses.maxMs[name] },
+            { "callsPerFrame", static_cast<double>(cpuPasses.calls[name]) / frameCount }
+        });
+    }
+    report["cpuPasses"] = cpuBreakdown;
+
+    nlohmann::ordered_json gpuBreakdown = nlohmann::ordered_json::array();
+    for (const std::string& path : gpuPasses.order) {
+        gpuBreakdown.push_back({
+            { "name", path },
+            { "avgMs", gpuMeasured ? gpuPasses.totalMs[path] / gpuMeasured : 0.0 },
+            { "maxMs", gpuPasses.maxMs[path] }
+        });
+    }
+    report["gpuPasses"] = gpuBreakdown;
+    report["peakMemoryMb"] = peakMemoryMb();
+
+    std::ofstream output(outputPath);
+    if (!output.is_open()) {
+        std::cerr << "Failed to open benchmark output: " << outputPath << std::endl;
+        return -1;
+    }
+    output << report.dump(4) << std::endl;
+    std::cout << "Frame time avg " << report["frameMs"].value("avg", 0.0) << " ms, p95 "
+        << report["frameMs"].value("p95", 0.0) << " ms, p99 " << report["frameMs"].value("p99", 0.0)
+        << " ms; report saved to " << outputPath << std::endl;
+    return 0;
+}
@@ -42,7 +42,7 @@ public:
     float MouseSensitivity;
     float Zoom;
 
-    Camera(Scene& sc, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : scene(sc), Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(Scene& sc, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), scene(sc), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
         Position = position;
         WorldUp = up;
@@ -51,7 +51,7 @@ public:
         updateCameraVectors();
         updateBoundingBox();
     }
-    Camera(Scene& sc, float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : scene(sc), Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(Scene& sc, float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), scene(sc), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
         Position = glm::vec3(posX, posY, posZ);
         WorldUp = glm::vec3(upX, upY, upZ);
@@ -112,6 +112,16 @@ public:
             Zoom = 45.0f;
     }
 
+    // 直接设置位置和朝向（脚本化的相机路径），不做碰撞检测
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+        updateBoundingBox();
+    }
+
     void updateBoundingBox()
     {
         boundingBox.min = Position - glm::vec3(0.5f);
@@ -1,8 +1,8 @@
 ﻿// main.cpp
 #include "Renderer.h"
 
-#include "Shader.h"
-#include "Camera.h"
+#include "shader.h"
+#include "camera.h"
 #include "ShadowManager.h"
 #include "LightManager.h"
 #include "Light.h"
@@ -27,7 +27,7 @@ int main()
     }
 
     // 设置 GLFW 配置
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -54,6 +54,9 @@ int main()
         return -1;
     }
 
+    // 着色器程序缓存与并行编译，需在创建任何着色器之前初始化
+    ShaderCache::instance().initialize((GLADloadproc)glfwGetProcAddress);
+
     // 配置全局 OpenGL 状态
     glEnable(GL_DEPTH_TEST);
 
@@ -61,7 +64,7 @@ int main()
     ShadowManager shadowManager;
 
     // 创建 LightManager
-    LightManager lightManager(16);
+    LightManager lightManager;
 
     // 创建场景
     Scene scene(lightManager);
@@ -114,8 +117,7 @@ int main()
     for (size_t i = 0; i < objectPaths.size(); ++i) {
         glm::vec3 position = glm::vec3(-7.5f + i * 5.0f, 5.0f, 0.0f); // 点光源位置：几何体上方
         glm::vec3 color = glm::vec3((i % 3) == 0 ? 1.0f : 0.0f, (i % 3) == 1 ? 1.0f : 0.0f, (i % 3) == 2 ? 1.0f : 0.0f); // RGB 循环颜色
-        auto pointLight = std::make_shared<PointLight>(position, color);
-        lightManager.addLight(pointLight);
+        lightManager.addLight(PointLight(position, color));
     }
 
     /*
@@ -146,11 +148,10 @@ int main()
     */
 
     // 添加定向光
-    auto dirLight = std::make_shared<DirectionalLight>(
+    lightManager.addLight(DirectionalLight(
         glm::vec3(-2.0f, -4.0f, -2.0f), // 定向光方向
         glm::vec3(1.0f, 1.0f, 1.0f)    // 白色光
-    );
-    lightManager.addLight(dirLight);
+    ));
 
 
     /*
@@ -158,9 +159,9 @@ int main()
     scene.addGameObject(GameObject("./resources/objects/nanosuit/nanosuit.obj", glm::vec3(-15.0f, -5.0f, 0.0f), glm::vec3(0.4f), glm::vec3(0.0f,90.0f, 0)));
     */
 
-    // 初始化光源
-    auto spotLight = std::make_shared<SpotLight>(camera.Position, camera.Front, glm::vec3(1.0f), 0.0f, 0.0f);
-    lightManager.addLight(spotLight);
+    // 初始化跟随相机的聚光灯
+    LightHandle cameraSpotLight = lightManager.addLight(SpotLight(camera.Position, camera.Front, glm::vec3(1.0f), 0.0f, 0.0f));
+    lightManager.setCameraLight(cameraSpotLight);
 
     /*
     auto dirLight = std::make_shared<DirectionalLight>(glm::vec3(10.0f, -4.0f, 1.0f), glm::vec3(1.0f));
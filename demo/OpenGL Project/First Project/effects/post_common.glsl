@@ -0,0 +1,19 @@
+// post_common.glsl
+// 后处理效果共用的输入输出；多个效果拼接成一个着色器时只声明一次
+#ifndef POST_COMMON_GLSL
+#define POST_COMMON_GLSL
+
+uniform sampler2D screenTexture; // 本 pass 的输入（场景或上一 pass 的输出）
+
+#ifndef POST_COMPUTE
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// 在 uv 处读取输入；需要采样邻域的效果都通过它读取，计算着色器后端会先查共享内存中的分块
+vec3 samplePost(vec2 uv)
+{
+    return texture(screenTexture, uv).rgb;
+}
+#endif
+
+#endif
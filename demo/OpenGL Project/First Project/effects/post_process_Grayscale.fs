@@ -1,12 +1,17 @@
 #version 330 core
-out vec4 FragColor;
-in vec2 TexCoords;
+#include "post_common.glsl"
 
-uniform sampler2D screenTexture; // 场景渲染输出
+// 逐像素效果：color 为上一个效果的输出
+vec3 applyEffect(vec3 color, vec2 uv)
+{
+    float gray = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return vec3(gray);
+}
 
+// 单独使用时的入口；拼接到效果链中时由 PostProcessing 生成 main
+#ifndef POST_CHAIN
 void main()
 {
-    vec3 color = texture(screenTexture, TexCoords).rgb;
-    float gray = dot(color, vec3(0.2126, 0.7152, 0.0722));
-    FragColor = vec4(vec3(gray), 1.0);
+    FragColor = vec4(applyEffect(texture(screenTexture, TexCoords).rgb, TexCoords), 1.0);
 }
+#endif
@@ -1,12 +1,15 @@
 #version 330 core
-out vec4 FragColor;
-in vec2 TexCoords;
+#include "post_common.glsl"
 
-uniform sampler2D screenTexture;
+vec3 applyEffect(vec3 color, vec2 uv)
+{
+    vec3 inverted = vec3(1.0) - color; 
+    return inverted;
+}
 
+#ifndef POST_CHAIN
 void main()
 {
-    vec3 color = texture(screenTexture, TexCoords).rgb;
-    vec3 inverted = vec3(1.0) - color; 
-    FragColor = vec4(inverted, 1.0);
+    FragColor = vec4(applyEffect(texture(screenTexture, TexCoords).rgb, TexCoords), 1.0);
 }
+#endif
@@ -1,17 +1,19 @@
 #version 330 core
-out vec4 FragColor;
-in vec2 TexCoords;
+#include "post_common.glsl"
 
-uniform sampler2D screenTexture;
-
-void main()
+vec3 applyEffect(vec3 color, vec2 uv)
 {
-    vec3 color = texture(screenTexture, TexCoords).rgb;
-
     // 常见的 Sepia 矩阵处理
     float r = dot(color, vec3(0.393, 0.769, 0.189));
     float g = dot(color, vec3(0.349, 0.686, 0.168));
     float b = dot(color, vec3(0.272, 0.534, 0.131));
 
-    FragColor = vec4(r, g, b, 1.0);
+    return vec3(r, g, b);
+}
+
+#ifndef POST_CHAIN
+void main()
+{
+    FragColor = vec4(applyEffect(texture(screenTexture, TexCoords).rgb, TexCoords), 1.0);
 }
+#endif
@@ -1,20 +1,25 @@
 #version 330 core
+#include "post_common.glsl"
 
-out vec4 FragColor;
-in vec2 TexCoords;
-
-uniform sampler2D screenTexture;
 uniform float strength;  // 分离强度
 
-void main()
+// 邻域效果：需要在其他位置采样输入，不使用 color，只能作为一个 pass 的第一个效果
+vec3 applyEffect(vec3 color, vec2 uv)
 {
     // 假设只在水平方向上分离
     // 你也可以改成 vec2( strength, strength ) 做更复杂的效果
     vec2 offset = vec2(strength, 0.0);
 
-    float r = texture(screenTexture, TexCoords + offset).r;
-    float g = texture(screenTexture, TexCoords).g;
-    float b = texture(screenTexture, TexCoords - offset).b;
+    float r = samplePost(uv + offset).r;
+    float g = samplePost(uv).g;
+    float b = samplePost(uv - offset).b;
+
+    return vec3(r, g, b);
+}
 
-    FragColor = vec4(r, g, b, 1.0);
+#ifndef POST_CHAIN
+void main()
+{
+    FragColor = vec4(applyEffect(texture(screenTexture, TexCoords).rgb, TexCoords), 1.0);
 }
+#endif
@@ -0,0 +1,56 @@
+// post_tiled.glsl
+// 计算着色器后端的公共部分：每个工作组处理 16x16 的分块，
+// 先把分块和四周 APRON 像素读入共享内存，邻域采样落在其中时不再访问纹理
+#ifndef POST_TILED_GLSL
+#define POST_TILED_GLSL
+
+#include "post_common.glsl"
+
+#define TILE_SIZE 16
+#define APRON 4          // 每边多读 4 像素，分块读入量为输出的 2.25 倍；更远的采样退回纹理
+#define SHARED_SIZE (TILE_SIZE + 2 * APRON)
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout(rgba8, binding = 0) writeonly uniform image2D outputImage;
+
+uniform ivec2 outputSize;   // 本 pass 的分辨率，低分辨率档位时小于窗口；输入与输出同尺寸
+
+shared vec3 tileColors[SHARED_SIZE * SHARED_SIZE];
+ivec2 tileOrigin;           // 共享内存中第一个像素的坐标
+
+// 整个工作组协作读入分块，超出图像的部分按边缘像素填充
+void loadTile()
+{
+    tileOrigin = ivec2(gl_WorkGroupID.xy) * TILE_SIZE - APRON;
+    for (uint i = gl_LocalInvocationIndex; i < uint(SHARED_SIZE * SHARED_SIZE); i += uint(TILE_SIZE * TILE_SIZE))
+    {
+        ivec2 local = ivec2(int(i) % SHARED_SIZE, int(i) / SHARED_SIZE);
+        ivec2 pixel = clamp(tileOrigin + local, ivec2(0), outputSize - 1);
+        tileColors[i] = texelFetch(screenTexture, pixel, 0).rgb;
+    }
+    barrier();
+}
+
+vec3 tileColor(ivec2 pixel)
+{
+    ivec2 local = pixel - tileOrigin;
+    return tileColors[local.y * SHARED_SIZE + local.x];
+}
+
+// 与片段着色器版本接口相同：在共享内存中做双线性插值，结果与线性过滤的纹理采样一致；超出分块时退回纹理采样
+vec3 samplePost(vec2 uv)
+{
+    vec2 position = uv * vec2(outputSize) - 0.5;
+    ivec2 local = ivec2(floor(position)) - tileOrigin;
+    if (any(lessThan(local, ivec2(0))) || any(greaterThanEqual(local + 1, ivec2(SHARED_SIZE))))
+        return textureLod(screenTexture, uv, 0.0).rgb;
+
+    vec2 f = fract(position);
+    int index = local.y * SHARED_SIZE + local.x;
+    vec3 top = mix(tileColors[index], tileColors[index + 1], f.x);
+    vec3 bottom = mix(tileColors[index + SHARED_SIZE], tileColors[index + SHARED_SIZE + 1], f.x);
+    return mix(top, bottom, f.y);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#version 330 core
+
+// 动态分辨率的合成：场景只渲染在纹理左下角 renderScale 的区域，
+// 用 9 次双线性采样近似 16 点 Catmull-Rom 双三次插值放大到全屏，比双线性更锐利
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+uniform vec2 renderScale;   // 渲染区域 / 纹理尺寸
+
+void main()
+{
+    vec2 textureSize = vec2(textureSize(screenTexture, 0));
+    vec2 samplePosition = TexCoords * renderScale * textureSize;
+    vec2 texel1 = floor(samplePosition - 0.5) + 0.5;
+    vec2 f = samplePosition - texel1;
+
+    // Catmull-Rom 权重
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // 中间两个纹素合并为一次双线性采样
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    // 采样点限制在渲染区域内，不读到区域外的旧内容
+    vec2 minUV = vec2(0.5) / textureSize;
+    vec2 maxUV = (renderScale * textureSize - 0.5) / textureSize;
+    vec2 uv0 = clamp((texel1 - 1.0) / textureSize, minUV, maxUV);
+    vec2 uv12 = clamp((texel1 + offset12) / textureSize, minUV, maxUV);
+    vec2 uv3 = clamp((texel1 + 2.0) / textureSize, minUV, maxUV);
+
+    vec3 color = vec3(0.0);
+    color += texture(screenTexture, vec2(uv0.x, uv0.y)).rgb * w0.x * w0.y;
+    color += texture(screenTexture, vec2(uv12.x, uv0.y)).rgb * w12.x * w0.y;
+    color += texture(screenTexture, vec2(uv3.x, uv0.y)).rgb * w3.x * w0.y;
+
+    color += texture(screenTexture, vec2(uv0.x, uv12.y)).rgb * w0.x * w12.y;
+    color += texture(screenTexture, vec2(uv12.x, uv12.y)).rgb * w12.x * w12.y;
+    color += texture(screenTexture, vec2(uv3.x, uv12.y)).rgb * w3.x * w12.y;
+
+    color += texture(screenTexture, vec2(uv0.x, uv3.y)).rgb * w0.x * w3.y;
+    color += texture(screenTexture, vec2(uv12.x, uv3.y)).rgb * w12.x * w3.y;
+    color += texture(screenTexture, vec2(uv3.x, uv3.y)).rgb * w3.x * w3.y;
+
+    // 双三次插值会过冲
+    FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
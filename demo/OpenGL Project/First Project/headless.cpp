@@ -0,0 +1,82 @@
+// headless.cpp
+// 无窗口入口：在离屏上下文中加载场景、渲染固定帧数并可选截图，用于没有显示器的 CI 和服务器
+#include "OffscreenContext.h"
+#include "Renderer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void printUsage()
+{
+    std::cout << "Usage: headless [--scene scenes/default.json] [--width 1600] [--height 1200]\n"
+        << "                [--frames 120] [--frame-time 0.016667] [--screenshot ./capture] [--no-validate]\n"
+        << "Exits with a non-zero code when the last frame's GPU culling does not match the CPU reference." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string scenePath = "./scenes/default.json";
+    std::string screenshotDirectory;
+    unsigned int width = 1600;
+    unsigned int height = 1200;
+    int frameCount = 120;
+    float frameTime = 1.0f / 60.0f;
+    bool validateCulling = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) scenePath = argv[++i];
+        else if (arg == "--width" && hasValue) width = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--height" && hasValue) height = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--frames" && hasValue) frameCount = std::atoi(argv[++i]);
+        else if (arg == "--frame-time" && hasValue) frameTime = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--screenshot" && hasValue) screenshotDirectory = argv[++i];
+        else if (arg == "--no-validate") validateCulling = false;
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (width == 0 || height == 0 || frameCount < 0) {
+        printUsage();
+        return -1;
+    }
+
+    // 创建离屏上下文，默认帧缓冲为同尺寸的 pbuffer
+    OffscreenContext offscreen;
+    if (!offscreen.create(static_cast<int>(width), static_cast<int>(height))) {
+        std::cerr << "Failed to create offscreen OpenGL context." << std::endl;
+        return -1;
+    }
+
+    // 着色器程序缓存与并行编译，需在创建任何着色器之前初始化
+    ShaderCache::instance().initialize(OffscreenContext::loader());
+
+    GL_STATE.enable(GL_DEPTH_TEST);
+
+    ShadowManager shadowManager;
+    LightManager lightManager;
+    Scene scene(lightManager);
+    Camera camera(scene, glm::vec3(0.0f, 0.0f, 3.0f));
+
+    Renderer renderer(nullptr, width, height, camera, lightManager, shadowManager, scene);
+    if (!renderer.initialize()) {
+        std::cerr << "Failed to initialize Renderer." << std::endl;
+        return -1;
+    }
+    renderer.loadScene(scenePath);
+
+    bool cullingMatches = renderer.runHeadless(frameCount, frameTime, validateCulling);
+
+    if (!screenshotDirectory.empty() && !renderer.captureScreenshot(screenshotDirectory)) {
+        return -1;
+    }
+    return cullingMatches ? 0 : 1;
+}
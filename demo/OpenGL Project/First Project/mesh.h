@@ -6,8 +6,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <shader.h>
+#include "shader.h"
 #include "PBRMaterial.h"
+#include "GeometryArena.h"
+#include "BoundingBox.h"
 
 #include <string>
 #include <vector>
@@ -16,6 +18,13 @@ using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
 
+// ʵƵÿʵݣ붥ɫ location 7~12 Ӧ
+struct InstanceData {
+    glm::mat4 model;           // ģ;location 7~10
+    glm::vec4 albedoMetallic;  // ʸǣalbedo + metalliclocation 11
+    glm::vec4 roughnessAO;     // ʸǣroughness + aolocation 12
+};
+
 struct Vertex {
     glm::vec3 Position;  // λ
     glm::vec3 Normal;    // 㷨
@@ -47,7 +56,10 @@ public:
     vector<unsigned int> indices;        // 
     std::vector<Texture> textures;       // 
 
-    unsigned int VAO;
+    // ȫּλеķ䣻 Model ͷ
+    GeometryArena::Handle geometry = GeometryArena::INVALID_HANDLE;
+
+    BoundingBox bounds;   // ֲռΧУ GPU ޳
 
     PBRMaterial material; //  PBR 
 
@@ -61,125 +73,75 @@ public:
         //  PBR ʲ
         setupPBRMaterial();
 
-        // ö㻺ָ
+        // ϴȫּλ
         setupMesh();
     }
 
 	void Draw(Shader& shader) const
     {
-        // û
-        shader.setVec3("material.albedo", material.albedo);
-        shader.setFloat("material.metallic", material.metallic);
-        shader.setFloat("material.roughness", material.roughness);
-        shader.setFloat("material.ao", material.ao);
-
-        //  PBR 
-        unsigned int textureUnit = 1;
-
-        if (material.useAlbedoMap != 0 && material.albedoMap != 0) {
-            glActiveTexture(GL_TEXTURE0 + textureUnit);
-            glBindTexture(GL_TEXTURE_2D, material.albedoMap);
-            shader.setInt("material.albedoMap", textureUnit++);
-            shader.setInt("material.useAlbedoMap", 1);
-        }
-        else {
-            shader.setInt("material.useAlbedoMap", 0);
-        }
-
-        if (material.useMetallicMap && material.metallicMap != 0) {
-            glActiveTexture(GL_TEXTURE0 + textureUnit);
-            glBindTexture(GL_TEXTURE_2D, material.metallicMap);
-            shader.setInt("material.metallicMap", textureUnit++);
-            shader.setInt("material.useMetallicMap", 1);
-        }
-        else {
-            shader.setInt("material.useMetallicMap", 0);
-        }
+        Draw(shader, material);
+    }
 
-        if (material.useRoughnessMap && material.roughnessMap != 0) {
-            glActiveTexture(GL_TEXTURE0 + textureUnit);
-            glBindTexture(GL_TEXTURE_2D, material.roughnessMap);
-            shader.setInt("material.roughnessMap", textureUnit++);
-            shader.setInt("material.useRoughnessMap", 1);
-        }
-        else {
-            shader.setInt("material.useRoughnessMap", 0);
-        }
+    // ʹⲿʻƣ干ͬһʱԱ
+    // ʳ峣ɵ÷д FrameUniformsֻɫɵ÷󶨣ֻΪֽӿڲ
+    void Draw(Shader& /*shader*/, const PBRMaterial& material) const
+    {
+        bindMaterialTextures(material);
 
-        if (material.useNormalMap && material.normalMap != 0) {
-            glActiveTexture(GL_TEXTURE0 + textureUnit);
-            glBindTexture(GL_TEXTURE_2D, material.normalMap);
-            shader.setInt("material.normalMap", textureUnit++);
-            shader.setInt("material.useNormalMap", 1);
-        }
-        else {
-            shader.setInt("material.useNormalMap", 0);
-        }
+        // 
+        GeometryArena& arena = GeometryArena::instance();
+        arena.bindColor();
+        arena.drawElements(geometry);
+    }
 
-        if (material.useAOMap && material.aoMap != 0) {
-            glActiveTexture(GL_TEXTURE0 + textureUnit);
-            glBindTexture(GL_TEXTURE_2D, material.aoMap);
-            shader.setInt("material.aoMap", textureUnit++);
-            shader.setInt("material.useAOMap", 1);
-        }
-        else {
-            shader.setInt("material.useAOMap", 0);
+    // Ѳͼ󶨵̶Ԫ 1~5 material_common.glsl е binding Ӧ
+    // Ƿʹͼɲʱеı־ж FrameUniforms::packMaterial һ
+    static void bindMaterialTextures(const PBRMaterial& material)
+    {
+        const bool used[5] = {
+            material.useAlbedoMap && material.albedoMap != 0,
+            material.useMetallicMap && material.metallicMap != 0,
+            material.useRoughnessMap && material.roughnessMap != 0,
+            material.useNormalMap && material.normalMap != 0,
+            material.useAOMap && material.aoMap != 0
+        };
+        const unsigned int maps[5] = {
+            material.albedoMap, material.metallicMap, material.roughnessMap, material.normalMap, material.aoMap
+        };
+
+        for (unsigned int i = 0; i < 5; ++i) {
+            if (used[i]) {
+                GL_STATE.bindTexture((GL_TEXTURE1 + i) - GL_TEXTURE0, GL_TEXTURE_2D, maps[i]);
+                RENDER_STATS_TEXTURE();
+            }
         }
+    }
 
-        // 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // üԪ
-        glActiveTexture(GL_TEXTURE0);
+    // ֻͨʹλƤƤò
+    // ӰԤpass
+    void DrawDepth(GLsizei instanceCount = 1) const
+    {
+        GeometryArena& arena = GeometryArena::instance();
+        arena.bindDepth(hasSkin);
+        arena.drawElements(geometry, instanceCount);
     }
 
+    // ǷйȨأƤĹڵ壬ʵ
+    bool isSkinned() const { return hasSkin; }
+
 private:
-    // Ⱦ
-    unsigned int VBO, EBO;
+    bool hasSkin = false;
 
-    // ʼл/
+    // ϴȫּλ
     void setupMesh()
     {
-        // /
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        // ݵ㻺
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // öָ
-        // λ
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // 㷨
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // 
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // 㸱
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-        // ID
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs));
-        // Ȩ
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights));
-
-        glBindVertexArray(0); // VAO
+        for (const auto& v : vertices) {
+            bounds.update(v.Position);
+            for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+                hasSkin |= (v.weights[i] > 0.0f);
+            }
+        }
+        geometry = GeometryArena::instance().allocate(vertices, indices);
     }
 
     //  PBR ʲ
@@ -1,13 +1,36 @@
 // Model.cpp
-#include "Model.h"
+#include "model.h"
+#include "CpuProfiler.h"
+#include "GLStateCache.h"
 
 // 캯
 Model::Model(const std::string& path, bool gamma)
-    : path(path),gammaCorrection(gamma)
+    : gammaCorrection(gamma), path(path)
 {
     loadModel(path); // ģ
 }
 
+// ͷȫּλеĿռ
+Model::~Model()
+{
+    for (const Mesh& mesh : meshes)
+        GeometryArena::instance().free(mesh.geometry);
+}
+
+// عģֻͣãûʹʱģ֮ͷ
+std::shared_ptr<Model> Model::load(const std::string& path, bool gamma)
+{
+    static std::map<std::string, std::weak_ptr<Model>> cache;
+
+    std::string key = path + (gamma ? "|gamma" : "");
+    std::shared_ptr<Model> model = cache[key].lock();
+    if (!model) {
+        model = std::make_shared<Model>(path, gamma);
+        cache[key] = model;
+    }
+    return model;
+}
+
 // ȡģ·
 const std::string& Model::getPath() const {
     return path;
@@ -45,7 +68,7 @@ unsigned int TextureFromFile(const char* path, const std::string& directory, boo
                 internalFormat = GL_SRGB_ALPHA;
         }
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GL_STATE.bindTexture(0, GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -73,9 +96,23 @@ void Model::Draw(Shader& shader) const
         meshes[i].Draw(shader);
 }
 
+void Model::Draw(Shader& shader, const std::vector<PBRMaterial>& materials) const
+{
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].Draw(shader, i < materials.size() ? materials[i] : meshes[i].material);
+}
+
+// ͨƣֻʹλ/Ƥ󶨲ʣָʵ
+void Model::DrawDepth(GLsizei instanceCount) const
+{
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].DrawDepth(instanceCount);
+}
+
 // ģ
 void Model::loadModel(const std::string& path)
 {
+    CPU_PROFILE_SCOPE("Model::loadModel");
     std::cout << "Loading model: " << path << std::endl;
     // ʹASSIMPȡļ
     Assimp::Importer importer;
@@ -10,8 +10,8 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include "Mesh.h"
-#include "Shader.h"
+#include "mesh.h"
+#include "shader.h"
 #include "BoundingBox.h"
 #include "Animation.h"
 #include "BoneInfo.h"
@@ -23,6 +23,7 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
 // ļĺ
@@ -47,6 +48,15 @@ public:
     std::vector<Animation> animations;  // 洢Ķб
 
     Model(const std::string& path, bool gamma = false);
+    ~Model();
+
+    // ȫּλУģ͸ͷţ
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // ģͲڶ乲ͬһ·ֻӴ̼һ
+    // ԱϲΪʵ
+    static std::shared_ptr<Model> load(const std::string& path, bool gamma = false);
 
     // ȡģ·
     const std::string& getPath() const;
@@ -54,6 +64,12 @@ public:
     // ģԼ
     void Draw(Shader& shader) const;
 
+    // ʹԼĲʻƣÿһݣ
+    void Draw(Shader& shader, const std::vector<PBRMaterial>& materials) const;
+
+    // ͨƣֻʹλ/Ƥ󶨲ʣָʵ
+    void DrawDepth(GLsizei instanceCount = 1) const;
+
 private:
     // ʹASSIMPֵ֧ļʽģͣɵ洢meshes
     void loadModel(const std::string& path);
@@ -8,6 +8,12 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "ShaderCache.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
 
 class Shader
 {
@@ -21,186 +27,242 @@ public:
     // ֶ֧㡢κƬɫĹ캯
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
     {
-        // 1. ļжȡɫ
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-
-        // ȷ ifstream ׳쳣
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // ļ
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
+        build(vertexPath, fragmentPath, geometryPath, std::string());
+    }
 
-            // ȡļݵַ
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
+    // ڿصĹ캯defines Ϊ #define뵽 #version ֮ɫ
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines)
+    {
+        build(vertexPath, fragmentPath, nullptr, defines);
+    }
 
-            // رļ
-            vShaderFile.close();
-            fShaderFile.close();
+    // ɫĹ캯
+    explicit Shader(const char* computePath)
+    {
+        ID = ShaderCache::instance().createProgram({ { GL_COMPUTE_SHADER, loadSource(computePath) } }, computePath);
+    }
 
-            // תΪַ
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+    // չԴ봴ʱɵɫlabel ڴϢ
+    static Shader fromSource(const std::string& vertexSource, const std::string& fragmentSource, const std::string& label)
+    {
+        Shader shader;
+        shader.ID = ShaderCache::instance().createProgram(
+            { { GL_VERTEX_SHADER, vertexSource }, { GL_FRAGMENT_SHADER, fragmentSource } }, label);
+        return shader;
+    }
 
-            // ṩ˼ɫ·
-            if (geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (const std::exception&)
+    // ȡɫԴ벢չ #includedefines 뵽 #version ֮֮кűֲ
+    static std::string loadSource(const char* path, const std::string& defines = std::string())
+    {
+        std::ifstream shaderFile;
+        // ȷ ifstream ׳쳣
+        shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            shaderFile.open(path);
+            std::stringstream shaderStream;
+            shaderStream << shaderFile.rdbuf();
+            shaderFile.close();
+            return injectDefines(resolveIncludes(shaderStream.str(), directoryOf(path)), defines);
         }
-
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        const char* gShaderCode = geometryPath != nullptr ? geometryCode.c_str() : nullptr;
-
-        // 2. ɫ
-        unsigned int vertex, fragment, geometry;
-        int success;
-        char infoLog[512];
-
-        // ɫ
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-
-        // Ƭɫ
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-
-        // ɫڣ
-        if (geometryPath != nullptr)
+        catch (const std::exception&)
         {
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
         }
-
-        // ɫ
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if (geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-
-        // ɾɫ
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if (geometryPath != nullptr)
-            glDeleteShader(geometry);
+        return std::string();
     }
 
     // ɫ
     void use()
     {
-        glUseProgram(ID);
+        GL_STATE.useProgram(ID);
+        RENDER_STATS_PROGRAM();
     }
 
     //  uniform ʵú
     void setBool(const std::string& name, bool value) const
     {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        RENDER_STATS_UNIFORM();
     }
 
     void setInt(const std::string& name, int value) const
     {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        RENDER_STATS_UNIFORM();
     }
 
     void setFloat(const std::string& name, float value) const
     {
         glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        RENDER_STATS_UNIFORM();
     }
 
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
         glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RENDER_STATS_UNIFORM();
     }
     void setVec2(const std::string& name, float x, float y) const
     {
         glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        RENDER_STATS_UNIFORM();
+    }
+
+    void setIVec2(const std::string& name, int x, int y) const
+    {
+        glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y);
+        RENDER_STATS_UNIFORM();
     }
 
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
         glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RENDER_STATS_UNIFORM();
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
         glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        RENDER_STATS_UNIFORM();
     }
 
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
         glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RENDER_STATS_UNIFORM();
     }
     void setVec4(const std::string& name, float x, float y, float z, float w) const
     {
         glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        RENDER_STATS_UNIFORM();
     }
 
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
         glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RENDER_STATS_UNIFORM();
     }
 
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
         glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RENDER_STATS_UNIFORM();
     }
 
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RENDER_STATS_UNIFORM();
+    }
+
+    // һϴ uniform 飬Ԫƴ
+    void setVec4Array(const std::string& name, const glm::vec4* values, int count) const
+    {
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+        RENDER_STATS_UNIFORM();
+    }
+
+    void setMat4Array(const std::string& name, const glm::mat4* mats, int count) const
+    {
+        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE, &mats[0][0][0]);
+        RENDER_STATS_UNIFORM();
+    }
+
+    void setIntArray(const std::string& name, const int* values, int count) const
+    {
+        glUniform1iv(glGetUniformLocation(ID, name.c_str()), count, values);
+        RENDER_STATS_UNIFORM();
+    }
+
+    void setIVec2Array(const std::string& name, const glm::ivec2* values, int count) const
+    {
+        glUniform2iv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+        RENDER_STATS_UNIFORM();
     }
 
 private:
-    // ʱĴ
-    void checkCompileErrors(unsigned int shader, std::string type)
+    // 벢Ӷ㡢ƬΣԼѡļΣɫ ShaderCache 𻺴ʹ
+    void build(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const std::string& defines)
+    {
+        std::vector<ShaderCache::Stage> stages;
+        stages.emplace_back(GL_VERTEX_SHADER, loadSource(vertexPath, defines));
+        stages.emplace_back(GL_FRAGMENT_SHADER, loadSource(fragmentPath, defines));
+        if (geometryPath != nullptr)
+            stages.emplace_back(GL_GEOMETRY_SHADER, loadSource(geometryPath, defines));
+
+        ID = ShaderCache::instance().createProgram(stages, fragmentPath);
+    }
+
+    //  #version ֮ defines #line ָк
+    static std::string injectDefines(const std::string& source, const std::string& defines)
+    {
+        if (defines.empty())
+            return source;
+
+        size_t version = source.find("#version");
+        size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return defines + source;
+
+        int versionLine = 1 + static_cast<int>(std::count(source.begin(), source.begin() + lineEnd, '\n'));
+        return source.substr(0, lineEnd + 1) + defines + "\n#line " + std::to_string(versionLine + 1) + "\n" +
+            source.substr(lineEnd + 1);
+    }
+
+    // չ #include "file"·ڰļGLSL ֧ include
+    static std::string resolveIncludes(const std::string& source, const std::string& directory, int depth = 0)
     {
-        int success;
-        char infoLog[1024];
-        if (type != "PROGRAM")
+        if (depth > 8)
         {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if (!success)
-            {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER::" << type << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-            }
+            std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP: " << directory << std::endl;
+            return source;
         }
-        else
+
+        std::stringstream input(source);
+        std::stringstream output;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(input, line))
         {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success)
+            ++lineNumber;
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
             {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+                output << line << '\n';
+                continue;
             }
+
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                std::cout << "ERROR::SHADER::INVALID_INCLUDE: " << line << std::endl;
+                continue;
+            }
+
+            std::string path = directory + line.substr(open + 1, close - open - 1);
+            std::ifstream includeFile(path);
+            if (!includeFile.is_open())
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << path << std::endl;
+                continue;
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+
+            // ļӵ 1 мչָԭļкţָ֤ȷ
+            output << "#line 1\n";
+            output << resolveIncludes(includeStream.str(), directoryOf(path.c_str()), depth + 1);
+            output << "#line " << lineNumber + 1 << '\n';
         }
+        return output.str();
+    }
+
+    static std::string directoryOf(const char* path)
+    {
+        std::string p(path);
+        size_t slash = p.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : p.substr(0, slash + 1);
     }
 };
 
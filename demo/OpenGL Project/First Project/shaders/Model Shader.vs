@@ -5,42 +5,66 @@ layout (location = 1) in vec3 aNormal;   // 法线
 layout (location = 2) in vec2 aTexCoords;// 纹理坐标
 layout (location = 3) in vec3 aTangent;  // 切线
 layout (location = 4) in vec3 aBitangent;// 副切线
+
+// 相机矩阵来自每帧常量，模型矩阵和开关来自物体常量（同时定义变体开关）
+#include "frame_common.glsl"
+#include "object_common.glsl"
+
+#ifdef HAS_SKINNING
 layout (location = 5) in ivec4 aBoneIDs;
 layout (location = 6) in vec4 aWeights;
+#endif
+#ifdef HAS_INSTANCING
+layout (location = 7) in mat4 aInstanceModel;           // 实例化：模型矩阵（占用 7~10）
+layout (location = 11) in vec4 aInstanceAlbedoMetallic; // 实例化：albedo + metallic
+layout (location = 12) in vec4 aInstanceRoughnessAO;    // 实例化：roughness + ao
+#endif
 
 out VS_OUT {
     vec3 FragPos;                          // 世界空间中的片段位置
     vec3 Normal;                           // 世界空间中的法线
     vec2 TexCoords;                        // 纹理坐标
-    vec4 FragPosLightSpace[16];            // 每个光源的光空间坐标
 } fs_out;
 
+#ifdef HAS_NORMAL_MAPPING
 out vec3 Tangent;
 out vec3 Bitangent;
+#endif
 
-uniform mat4 model;                        // 模型矩阵
-uniform mat4 view;                         // 视图矩阵
-uniform mat4 projection;                   // 投影矩阵
-uniform mat4 lightSpaceMatrices[16];       // 每个光源的光空间矩阵
-uniform int lightCount;                    // 当前光源数量
+#ifdef HAS_INSTANCING
+// 每个实例的材质常量，片段着色器中代替材质表的对应项
+flat out vec4 InstanceAlbedoMetallic;
+flat out vec2 InstanceRoughnessAO;
+#endif
 
+#ifdef HAS_SKINNING
+// 骨骼矩阵只有带动画的物体需要，仍按 uniform 上传
 const int MAX_BONES = 100;
 uniform mat4 bones[MAX_BONES];
-uniform bool useBones;  // 是否使用骨骼动画的开关
+#endif
 
 void main()
 {
     // 条件应用骨骼变换
     mat4 boneTransform = mat4(1.0);
-    if (useBones) {
+#ifdef HAS_SKINNING
+    if (USE_BONES) {
         boneTransform = aWeights[0] * bones[aBoneIDs[0]] +
                         aWeights[1] * bones[aBoneIDs[1]] +
                         aWeights[2] * bones[aBoneIDs[2]] +
                         aWeights[3] * bones[aBoneIDs[3]];
     }
+#endif
 
     // 组合模型变换与骨骼变换
+#ifdef HAS_INSTANCING
+    mat4 finalModel = (USE_INSTANCING ? aInstanceModel : model) * boneTransform;
+
+    InstanceAlbedoMetallic = aInstanceAlbedoMetallic;
+    InstanceRoughnessAO = aInstanceRoughnessAO.xy;
+#else
     mat4 finalModel = model * boneTransform;
+#endif
 
     // 计算初始位置
     vec4 pos = finalModel * vec4(aPos, 1.0);
@@ -54,14 +78,11 @@ void main()
     // 传递纹理坐标
     fs_out.TexCoords = aTexCoords;
 
+#ifdef HAS_NORMAL_MAPPING
     // 传递切线和副切线
     Tangent = mat3(finalModel) * aTangent;
     Bitangent = mat3(finalModel) * aBitangent;
-
-    // 计算每个光源的光空间坐标，基于位移后的 FragPos
-    for (int i = 0; i < lightCount; i++) {
-        fs_out.FragPosLightSpace[i] = lightSpaceMatrices[i] * pos;
-    }
+#endif
 
     // 最终裁剪空间位置计算
     gl_Position = projection * view * pos;
@@ -0,0 +1,52 @@
+#version 430 core
+
+// 延迟着色光照阶段：每个可见像素只计算一次光照
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include "lighting_common.glsl"
+#include "gbuffer_common.glsl"
+
+uniform sampler2D gAlbedoAO;
+uniform sampler2D gNormalMR;
+uniform sampler2D gDepth;
+
+void main()
+{
+    // 动态分辨率下只渲染 G-buffer 左下角的区域，按像素坐标读取即可；TexCoords 相对于视口，用于重建坐标
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    if (depth >= 1.0)
+        discard; // 没有几何体，保留背景
+
+    // 重建世界坐标
+    vec4 clip = vec4(TexCoords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = invViewProjection * clip;
+    vec3 P = world.xyz / world.w;
+
+    vec4 albedoAO = texelFetch(gAlbedoAO, texel, 0);
+    vec4 normalMR = texelFetch(gNormalMR, texel, 0);
+    vec3 albedo = albedoAO.rgb;
+    float ao = albedoAO.a;
+    vec3 N = decodeNormal(normalMR.xy);
+    float metallic = normalMR.z;
+    float roughness = normalMR.w;
+    vec3 V = normalize(viewPos - P);
+
+    // 直接光照
+    vec3 Lo = shadeClustered(P, N, V, albedo, metallic, roughness, gl_FragCoord.xy);
+
+    // 环境光
+    vec3 ambient = vec3(0.03) * albedo * ao;
+
+    // 最终颜色
+    vec3 colorResult = ambient + Lo;
+
+    // HDR tonemapping
+    colorResult = colorResult / (colorResult + vec3(1.0));
+    // Gamma correction
+    colorResult = pow(colorResult, vec3(1.0/2.2));
+
+    FragColor = vec4(colorResult, 1.0);
+}
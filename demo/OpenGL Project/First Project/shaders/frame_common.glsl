@@ -0,0 +1,31 @@
+// frame_common.glsl
+// 每帧常量：相机、分簇、阴影和调试开关，与 FrameUniforms::FrameData 对应（std140），每帧只写入一次
+
+const int MAX_SHADOW_SLOTS = 32;
+const int MAX_SHADOW_LIGHTS = 16;
+const int MAX_DIRECTIONAL_LIGHTS = 4;
+
+layout(std140, binding = 0) uniform FrameData {
+    mat4 projection;                           // 投影矩阵
+    mat4 view;                                 // 视图矩阵
+    mat4 viewProjection;
+    mat4 invViewProjection;                    // 由深度重建世界坐标
+    mat4 shadowMatrices[MAX_SHADOW_SLOTS];     // 每个槽位的光空间矩阵
+    vec4 shadowRects[MAX_SHADOW_SLOTS];        // 每个槽位的阴影位置 (xy: uv 偏移, z: uv 缩放, w: 层号)
+    ivec4 shadowSlots[MAX_SHADOW_LIGHTS];      // 前 16 个光源的槽位 (x: 起始下标, y: 数量)，其余光源不投射阴影
+    int directionalLights[MAX_DIRECTIONAL_LIGHTS]; // 方向光不参与分簇，对每个片段都计算
+    vec4 cascadeSplits;                        // 每一级级联的远端视距
+    vec3 viewPos;                              // 观察者位置
+    float far_plane;                           // 点光源的远裁剪面
+    uvec3 clusterGrid;                         // 簇网格尺寸 (x, y, z)
+    float shadowMapResolution;                 // 阴影贴图分辨率
+    vec2 screenSize;                           // 屏幕尺寸（像素）
+    vec2 clusterDepthParams;                   // 由视距求切片：slice = log(视距) * x + y
+    int directionalLightCount;
+    int shadowQuality;                         // 阴影过滤档位：0 硬阴影, 1 4-tap, 2 16-tap Poisson, 3 PCSS
+    float pcssLightSize;                       // PCSS 光源尺寸（阴影贴图 uv 单位）
+    int debugLightView;                        // 调试光源模式开关
+    int debugLightIndex;                       // 调试的光源索引
+    int debugMaterialView;                     // 调试材质开关
+    int debugMaterialIndex;                    // 调试的材质索引
+};
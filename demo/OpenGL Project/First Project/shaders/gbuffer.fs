@@ -0,0 +1,19 @@
+#version 430 core
+
+// 延迟着色几何阶段：只写材质属性，不做光照
+layout (location = 0) out vec4 gAlbedoAO;   // albedo.rgb + ao
+layout (location = 1) out vec4 gNormalMR;   // 编码法线 (xy) + metallic + roughness
+
+#include "material_common.glsl"
+#include "gbuffer_common.glsl"
+
+void main()
+{
+    vec3 N = normalize(fs_in.Normal);
+    if (hasMap(NORMAL_MAP)) {
+        N = getNormalFromMap();
+    }
+
+    gAlbedoAO = vec4(getAlbedo(fs_in.TexCoords), getAO(fs_in.TexCoords));
+    gNormalMR = vec4(encodeNormal(N), getMetallic(fs_in.TexCoords), getRoughness(fs_in.TexCoords));
+}
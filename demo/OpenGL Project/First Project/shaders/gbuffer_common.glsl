@@ -0,0 +1,23 @@
+// gbuffer_common.glsl
+// G-buffer 法线编码：八面体映射，两个分量即可存储单位向量
+
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// 单位法线 -> [-1, 1]^2
+vec2 encodeNormal(vec3 n)
+{
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+// [-1, 1]^2 -> 单位法线
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = octWrap(n.xy);
+    return normalize(n);
+}
@@ -0,0 +1,384 @@
+// lighting_common.glsl
+// 分簇光照与阴影：前向着色与延迟光照阶段共用，由 Shader 的 #include 展开
+
+// 光源数据，与 LightManager::LightData 对应
+struct LightData {
+    vec4 position;   // 光源位置
+    vec4 direction;  // 光源方向
+    vec4 color;      // 光源颜色和强度 (xyz: 颜色, w: 强度)
+    vec4 params;     // 额外参数 (cutoffAngle, type, 保留, range)
+};
+
+layout(std430, binding = 0) readonly buffer LightBuffer {
+    LightData lights[];
+};
+
+// 分簇数据：每个簇的 (偏移, 数量) 以及所有簇的光源下标
+layout(std430, binding = 1) readonly buffer ClusterBuffer {
+    uvec2 clusters[];
+};
+
+layout(std430, binding = 2) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+
+// 相机、分簇参数、阴影槽位等每帧常量见 frame_common.glsl
+#include "frame_common.glsl"
+
+uniform sampler2DArrayShadow shadowMapArray;      // 方向光/聚光灯共用的阴影纹理数组（硬件比较）
+uniform samplerCubeArrayShadow shadowCubeArray;   // 点光源共用的立方体阴影贴图数组（硬件比较）
+uniform sampler2DArray shadowDepthArray;          // 同一纹理的原始深度视图（PCSS 遮挡物搜索/调试）
+uniform samplerCubeArray shadowDepthCubeArray;    // 同一立方体数组的原始深度视图
+
+// 常量
+const float PI = 3.14159265359;
+const float SHADOW_SKIP_THRESHOLD = 1e-4;         // 光照贡献低于该值时跳过阴影查询
+
+// 16 点 Poisson 分布，用于 PCF 与 PCSS 遮挡物搜索
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760),
+    vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.97484398,  0.75648379),
+    vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2( 0.79197514,  0.19090188),
+    vec2(-0.24188840,  0.99706507), vec2(-0.81409955,  0.91437590),
+    vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100790)
+);
+
+// 函数原型
+float DistributionGGX(vec3 N, vec3 H, float roughness);
+float GeometrySchlickGGX(float NdotV, float roughness);
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
+vec3 fresnelSchlick(float cosTheta, vec3 F0);
+float CalculateShadow(float type, vec3 FragPos, vec3 normal, vec3 lightDir, int index);
+float filterShadow2D(vec2 uv, float layer, float ref, vec2 uvMin, vec2 uvMax, float texelSize);
+float filterShadowCube(vec3 fragToLight, float layer, float ref, float texelSize);
+int getShadowSlot(int index, vec3 FragPos);
+vec3 shadeLight(int i, vec3 P, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0);
+vec3 shadeClustered(vec3 P, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec2 fragCoord);
+float rangeWindow(float dist, float range);
+
+// 计算所有影响该片段的光源：方向光逐个计算，点光源与聚光灯只遍历片段所在簇
+vec3 shadeClustered(vec3 P, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec2 fragCoord)
+{
+    // 计算基础反射率
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    // 变体按方向光数量编译，循环次数是常量，可以完全展开
+#ifdef DIRECTIONAL_LIGHT_COUNT
+    const int lightCount = min(DIRECTIONAL_LIGHT_COUNT, MAX_DIRECTIONAL_LIGHTS);
+#else
+    int lightCount = directionalLightCount;
+#endif
+
+    vec3 Lo = vec3(0.0);
+    for(int d = 0; d < lightCount; ++d) {
+        Lo += shadeLight(directionalLights[d], P, N, V, albedo, metallic, roughness, F0);
+    }
+
+    float viewDepth = -(view * vec4(P, 1.0)).z;
+    uvec2 tile = min(uvec2(fragCoord / screenSize * vec2(clusterGrid.xy)), clusterGrid.xy - 1u);
+    uint slice = uint(clamp(log(max(viewDepth, 1e-4)) * clusterDepthParams.x + clusterDepthParams.y, 0.0, float(clusterGrid.z - 1u)));
+    uvec2 cluster = clusters[tile.x + tile.y * clusterGrid.x + slice * clusterGrid.x * clusterGrid.y];
+    for(uint k = 0u; k < cluster.y; ++k) {
+        Lo += shadeLight(int(lightIndices[cluster.x + k]), P, N, V, albedo, metallic, roughness, F0);
+    }
+    return Lo;
+}
+
+// 计算单个光源的贡献（含阴影）
+vec3 shadeLight(int i, vec3 P, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    vec3 L;
+    float cutoff = lights[i].params.x; // 切光角度，单位为度
+    float intensity = 1.0;
+
+    if(lights[i].params.y == 1.0) { // 点光源
+        L = normalize(lights[i].position.xyz - P);
+    } 
+    else if(lights[i].params.y == 2.0) { // SpotLight
+        L = normalize(lights[i].position.xyz - P); // 从片段指向光源的位置
+        //L = normalize(-lights[i].direction.xyz);
+
+        float theta = dot(normalize(lights[i].direction.xyz), normalize(-L)); // 计算光线与聚光灯方向的夹角余弦
+        float cutoffCos = cos(radians(cutoff)); // 切光角度的余弦值
+        float epsilon = 0.05; // 渐变范围
+        intensity = clamp((theta - cutoffCos) / epsilon, 0.0, 1.0);
+    } 
+    else { // DirectionalLight
+        L = normalize(-lights[i].direction.xyz);
+    }
+    
+    vec3 H = normalize(V + L);
+    float distance;
+    float attenuation;
+    vec3 radiance;
+    
+    if(lights[i].params.y == 1.0) { // 点光源
+        float dist = length(lights[i].position.xyz - P);
+        distance = dist / 5;
+        attenuation = rangeWindow(dist, lights[i].params.w) / (distance * distance);
+        radiance = lights[i].color.rgb * attenuation;
+    } else if(lights[i].params.y == 2.0) { // 聚光灯：仅在影响半径处截断
+        attenuation = rangeWindow(length(lights[i].position.xyz - P), lights[i].params.w);
+        radiance = lights[i].color.rgb * attenuation;
+    } else { // 方向光
+        attenuation = 1.0; // 方向光没有衰减
+        radiance = lights[i].color.rgb * attenuation;
+    }
+    
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.001;
+    vec3 specular = numerator / denominator;
+
+    // kS 是镜面反射分量
+    vec3 kS = F;
+    // kD 是漫反射分量
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    // NdotL
+    float NdotL = max(dot(N, L), 0.0);
+
+    // 贡献可以忽略时（背光、锥外、衰减殆尽）不做阴影查询
+    vec3 contribution = (kD * albedo / PI + specular) * radiance * NdotL * intensity * lights[i].color.w;
+    if (max(contribution.r, max(contribution.g, contribution.b)) < SHADOW_SKIP_THRESHOLD)
+        return vec3(0.0);
+
+    // 计算阴影
+    float shadow = CalculateShadow(lights[i].params.y, P, N, L, i);
+
+    return contribution * (1.0 - shadow);
+}
+
+
+// 在影响半径处平滑衰减到 0，保证分簇截断时没有硬边
+float rangeWindow(float dist, float range)
+{
+    float r = dist / max(range, 1e-4);
+    float w = clamp(1.0 - r * r * r * r, 0.0, 1.0);
+    return w * w;
+}
+
+// 选择光源对应的阴影槽位；方向光按视距选择级联，超出阴影距离时返回 -1
+int getShadowSlot(int index, vec3 FragPos)
+{
+    if (index >= MAX_SHADOW_LIGHTS)
+        return -1;
+    ivec2 slots = shadowSlots[index].xy;
+    if (slots.y <= 0)
+        return -1;
+    if (slots.y == 1)
+        return slots.x;
+
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    for (int c = 0; c < slots.y; ++c)
+    {
+        if (viewDepth < cascadeSplits[c])
+            return slots.x + c;
+    }
+    return -1;
+}
+
+// 计算阴影（方向光、聚光灯和点光源），返回 0（无阴影）到 1（完全遮挡）
+float CalculateShadow(float type, vec3 FragPos, vec3 normal, vec3 lightDir, int index)
+{
+    int slot = getShadowSlot(index, FragPos);
+    if (slot < 0)
+        return 0.0;
+
+    // 深度偏移
+    float bias = 0.05 * (1.0 - dot(normal, lightDir)); // 动态偏移
+    float texelSize = 1.0 / shadowMapResolution;
+
+    if (type == 0.0 || type == 2.0) // 方向光或聚光灯
+    {
+        vec4 fragPosLightSpace = shadowMatrices[slot] * vec4(FragPos, 1.0);
+        // 透视除法
+        vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+        // 转换到 [0,1] 范围
+        projCoords = projCoords * 0.5 + 0.5;
+        // 检查是否在阴影贴图范围内
+        if(projCoords.z > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+            return 0.0;
+        // 映射到阴影纹理数组中该槽位的区域，采样点限制在区域内，避免读到相邻级联
+        vec4 rect = shadowRects[slot];
+        vec2 uv = rect.xy + projCoords.xy * rect.z;
+        vec2 uvMin = rect.xy + vec2(0.5 * texelSize);
+        vec2 uvMax = rect.xy + vec2(rect.z - 0.5 * texelSize);
+        return 1.0 - filterShadow2D(uv, rect.w, projCoords.z - bias, uvMin, uvMax, texelSize);
+    }
+    else if (type == 1.0) // 点光源
+    {
+        vec3 fragToLight = FragPos - lights[index].position.xyz;
+        float ref = (length(fragToLight) - bias) / far_plane; // 阴影贴图中存的是归一化的距离
+        return 1.0 - filterShadowCube(fragToLight, shadowRects[slot].w, ref, texelSize);
+    }
+    return 0.0;
+}
+
+// 2D 阴影过滤，返回受光比例；每次 texture 调用都是硬件双线性 PCF
+float filterShadow2D(vec2 uv, float layer, float ref, vec2 uvMin, vec2 uvMax, float texelSize)
+{
+    if (shadowQuality == 0) // 硬阴影（单次硬件 PCF）
+    {
+        return texture(shadowMapArray, vec4(clamp(uv, uvMin, uvMax), layer, ref));
+    }
+
+    if (shadowQuality == 1) // 4-tap：覆盖 3x3 纹素
+    {
+        float lit = 0.0;
+        for (int x = 0; x < 2; ++x)
+            for (int y = 0; y < 2; ++y)
+            {
+                vec2 offset = (vec2(x, y) - 0.5) * texelSize;
+                lit += texture(shadowMapArray, vec4(clamp(uv + offset, uvMin, uvMax), layer, ref));
+            }
+        return lit * 0.25;
+    }
+
+    float radius = 2.5 * texelSize; // 16-tap Poisson 的固定半径
+    if (shadowQuality == 3) // PCSS：先搜索遮挡物平均深度，再估计半影宽度
+    {
+        float searchRadius = pcssLightSize;
+        float blockerSum = 0.0;
+        int blockerCount = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            vec2 sampleUV = clamp(uv + poissonDisk[i] * searchRadius, uvMin, uvMax);
+            float depth = texture(shadowDepthArray, vec3(sampleUV, layer)).r;
+            if (depth < ref)
+            {
+                blockerSum += depth;
+                blockerCount++;
+            }
+        }
+        if (blockerCount == 0)
+            return 1.0;
+
+        float blockerDepth = blockerSum / float(blockerCount);
+        float penumbra = (ref - blockerDepth) / max(blockerDepth, 1e-4) * pcssLightSize;
+        radius = clamp(penumbra, texelSize, 16.0 * texelSize);
+    }
+
+    float lit = 0.0;
+    for (int i = 0; i < 16; ++i)
+    {
+        vec2 sampleUV = clamp(uv + poissonDisk[i] * radius, uvMin, uvMax);
+        lit += texture(shadowMapArray, vec4(sampleUV, layer, ref));
+    }
+    return lit / 16.0;
+}
+
+// 立方体阴影过滤，返回受光比例；偏移在与采样方向垂直的平面内进行
+float filterShadowCube(vec3 fragToLight, float layer, float ref, float texelSize)
+{
+    if (shadowQuality == 0)
+    {
+        return texture(shadowCubeArray, vec4(fragToLight, layer), ref);
+    }
+
+    // 与采样方向垂直的基，偏移以方向长度为尺度（立方体一个纹素约为 2 / 分辨率）
+    vec3 dir = normalize(fragToLight);
+    vec3 up = abs(dir.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent = normalize(cross(up, dir));
+    vec3 bitangent = cross(dir, tangent);
+    float texel = 2.0 * texelSize;
+
+    if (shadowQuality == 1)
+    {
+        float lit = 0.0;
+        for (int x = 0; x < 2; ++x)
+            for (int y = 0; y < 2; ++y)
+            {
+                vec2 offset = (vec2(x, y) - 0.5) * texel;
+                vec3 sampleDir = dir + tangent * offset.x + bitangent * offset.y;
+                lit += texture(shadowCubeArray, vec4(sampleDir, layer), ref);
+            }
+        return lit * 0.25;
+    }
+
+    float radius = 2.5 * texel;
+    if (shadowQuality == 3)
+    {
+        float searchRadius = pcssLightSize;
+        float blockerSum = 0.0;
+        int blockerCount = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            vec3 sampleDir = dir + (tangent * poissonDisk[i].x + bitangent * poissonDisk[i].y) * searchRadius;
+            float depth = texture(shadowDepthCubeArray, vec4(sampleDir, layer)).r;
+            if (depth < ref)
+            {
+                blockerSum += depth;
+                blockerCount++;
+            }
+        }
+        if (blockerCount == 0)
+            return 1.0;
+
+        float blockerDepth = blockerSum / float(blockerCount);
+        float penumbra = (ref - blockerDepth) / max(blockerDepth, 1e-4) * pcssLightSize;
+        radius = clamp(penumbra, texel, 16.0 * texel);
+    }
+
+    float lit = 0.0;
+    for (int i = 0; i < 16; ++i)
+    {
+        vec3 sampleDir = dir + (tangent * poissonDisk[i].x + bitangent * poissonDisk[i].y) * radius;
+        lit += texture(shadowCubeArray, vec4(sampleDir, layer), ref);
+    }
+    return lit / 16.0;
+}
+
+
+// GGX分布函数
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+
+    float nom   = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+
+// Schlick-GGX几何遮蔽函数
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+
+    float nom   = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+
+// Smith几何遮蔽函数
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+
+// Schlick Fresnel
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+}
@@ -0,0 +1,144 @@
+// material_common.glsl
+// 材质采样：前向着色与 G-buffer 几何阶段共用，由 Shader 的 #include 展开
+
+#include "object_common.glsl"
+
+// 材质常量表，与 FrameUniforms::MaterialData 对应，按物体常量中的 materialIndex 读取
+struct MaterialData {
+    vec4 albedoMetallic;    // albedo + metallic
+    vec4 roughnessAO;       // x: roughness, y: ao
+    uvec4 textureFlags;     // x: 使用了哪些贴图
+};
+
+// 3 号与剔除的计算着色器共用，见 FrameUniforms::MATERIAL_BINDING
+layout(std430, binding = 3) readonly buffer MaterialBuffer {
+    MaterialData materials[];
+};
+
+// textureFlags 的各位，与 FrameUniforms::TextureFlag 对应
+const uint ALBEDO_MAP = 1u;
+const uint METALLIC_MAP = 2u;
+const uint ROUGHNESS_MAP = 4u;
+const uint NORMAL_MAP = 8u;
+const uint AO_MAP = 16u;
+
+// 贴图固定占用 1~5 号纹理单元，与 Mesh::bindMaterialTextures 对应
+layout(binding = 1) uniform sampler2D albedoMap;
+layout(binding = 2) uniform sampler2D metallicMap;
+layout(binding = 3) uniform sampler2D roughnessMap;
+layout(binding = 4) uniform sampler2D normalMap;
+layout(binding = 5) uniform sampler2D aoMap;
+
+// 变体中 MATERIAL_MAPS 是编译期常量，未使用贴图的分支和采样直接被删除
+bool hasMap(uint map)
+{
+#ifdef MATERIAL_MAPS
+    return (uint(MATERIAL_MAPS) & map) != 0u;
+#else
+    return (materials[materialIndex].textureFlags.x & map) != 0u;
+#endif
+}
+
+#ifdef HAS_INSTANCING
+// 实例化绘制时材质常量来自每个实例，贴图仍由材质表决定
+flat in vec4 InstanceAlbedoMetallic;
+flat in vec2 InstanceRoughnessAO;
+#endif
+
+vec4 getAlbedoMetallic()
+{
+#ifdef HAS_INSTANCING
+    if (USE_INSTANCING) {
+        return InstanceAlbedoMetallic;
+    }
+#endif
+    return materials[materialIndex].albedoMetallic;
+}
+
+vec2 getRoughnessAO()
+{
+#ifdef HAS_INSTANCING
+    if (USE_INSTANCING) {
+        return InstanceRoughnessAO;
+    }
+#endif
+    return materials[materialIndex].roughnessAO.xy;
+}
+
+in VS_OUT {
+    vec3 FragPos;                          // 世界空间中的片段位置
+    vec3 Normal;                           // 世界空间中的法线
+    vec2 TexCoords;                        // 纹理坐标
+} fs_in;
+
+#ifdef HAS_NORMAL_MAPPING
+in vec3 Tangent;
+in vec3 Bitangent;
+#endif
+
+// 函数原型
+vec3 getNormalFromMap();
+vec3 getAlbedo(vec2 TexCoords);
+float getMetallic(vec2 TexCoords);
+float getRoughness(vec2 TexCoords);
+float getAO(vec2 TexCoords);
+
+// 从法线贴图获取法线
+vec3 getNormalFromMap()
+{
+#ifdef HAS_NORMAL_MAPPING
+    if (hasMap(NORMAL_MAP)) {
+    vec3 tangentNormal = texture(normalMap, fs_in.TexCoords).rgb;
+    tangentNormal = tangentNormal * 2.0 - 1.0;
+
+    vec3 T = normalize(Tangent);
+    vec3 B = normalize(Bitangent);
+    vec3 N = normalize(fs_in.Normal);
+    mat3 TBN = mat3(T, B, N);
+
+    return normalize(TBN * tangentNormal);
+    }
+    else{
+    vec3 tangentNormal = texture(normalMap, fs_in.TexCoords).rgb;
+    tangentNormal = tangentNormal * 2.0 - 1.0;
+
+    mat3 TBN = mat3(normalize(Tangent), normalize(Bitangent), normalize(fs_in.Normal));
+    return normalize(TBN * tangentNormal);
+    }
+#else
+    return normalize(fs_in.Normal);  // 变体不使用法线贴图，没有切线输入
+#endif
+}
+
+
+vec3 getAlbedo(vec2 texCoords) {
+    if (hasMap(ALBEDO_MAP)) {
+        return pow(texture(albedoMap, texCoords).rgb, vec3(2.2)); // Gamma矫正
+    } else {
+        return getAlbedoMetallic().rgb; // 返回默认颜色
+    }
+}
+
+float getMetallic(vec2 texCoords) {
+    if (hasMap(METALLIC_MAP)) {
+        return texture(metallicMap, texCoords).r;
+    } else {
+        return getAlbedoMetallic().a; // 返回默认金属度
+    }
+}
+
+float getRoughness(vec2 texCoords) {
+    if (hasMap(ROUGHNESS_MAP)) {
+        return texture(roughnessMap, texCoords).r;
+    } else {
+        return getRoughnessAO().x; // 返回默认粗糙度
+    }
+}
+
+float getAO(vec2 texCoords) {
+    if (hasMap(AO_MAP)) {
+        return texture(aoMap, texCoords).r;
+    } else {
+        return getRoughnessAO().y; // 返回默认AO
+    }
+}
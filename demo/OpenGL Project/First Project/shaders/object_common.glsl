@@ -0,0 +1,35 @@
+// object_common.glsl
+// 每次绘制的物体常量，与 FrameUniforms::ObjectData 对应（std140），由环形缓冲按偏移绑定
+
+layout(std140, binding = 1) uniform ObjectData {
+    mat4 model;                                // 模型矩阵（实例化时不使用）
+    int materialIndex;                         // 材质表中的下标
+    bool useBones;                             // 是否使用骨骼动画
+    bool useInstancing;                        // 是否从实例属性读取模型矩阵和材质常量
+};
+
+// 着色器变体：ShaderVariants 在 #version 之后注入 SHADER_VARIANT 和各项开关（SKINNED、INSTANCED 等）
+// 变体中没有打开的功能整段不参与编译；未注入时是包含全部功能的单一着色器，按物体常量在运行时分支
+#if !defined(SHADER_VARIANT) || defined(SKINNED)
+#define HAS_SKINNING
+#endif
+#if !defined(SHADER_VARIANT) || defined(INSTANCED)
+#define HAS_INSTANCING
+#endif
+
+// 切线只在使用法线贴图时需要；MATERIAL_MAPS 是材质贴图标志的组合，8 对应 NORMAL_MAP
+#ifdef MATERIAL_MAPS
+#if (MATERIAL_MAPS & 8) != 0
+#define HAS_NORMAL_MAPPING
+#endif
+#else
+#define HAS_NORMAL_MAPPING
+#endif
+
+#ifdef SHADER_VARIANT
+#define USE_BONES true
+#define USE_INSTANCING true
+#else
+#define USE_BONES useBones
+#define USE_INSTANCING useInstancing
+#endif
@@ -1,4 +1,6 @@
 #include "skybox.h"
+#include "RenderStats.h"
+#include "GLStateCache.h"
 
 // 
 float skyboxVertices[] = {
@@ -55,7 +57,7 @@ Skybox::Skybox(const std::vector<std::string>& paths)
 
     glGenBuffers(1, &VBO); 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    GL_STATE.bindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -71,7 +73,7 @@ Skybox::Skybox(const std::string& panoramaPath)
 
     glGenBuffers(1, &VBO); 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    GL_STATE.bindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -80,9 +82,9 @@ Skybox::Skybox(const std::string& panoramaPath)
 
 Skybox::~Skybox()
 {
-    glDeleteVertexArrays(1, &VAO);
+    GL_STATE.deleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteTextures(1, &texture);
+    GL_STATE.deleteTextures(1, &texture);
 }
 
 void Skybox::Draw(Shader& shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
@@ -93,12 +95,13 @@ void Skybox::Draw(Shader& shader, glm::mat4 model, glm::mat4 view, glm::mat4 pro
     shader.setMat4("view", view);
     shader.setMat4("projection", projection);
     shader.setInt("skybox", 0);
-    glDepthMask(GL_FALSE);
-    glBindVertexArray(VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    GL_STATE.depthMask(GL_FALSE);
+    GL_STATE.bindVertexArray(VAO);
+    GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP, texture);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthMask(GL_TRUE);
+    RENDER_STATS_TEXTURE();
+    RENDER_STATS_DRAW(12);
+    GL_STATE.depthMask(GL_TRUE);
 }
 
 unsigned int Skybox::GenCubeMap(const std::vector<std::string>& facePaths)
@@ -109,7 +112,7 @@ unsigned int Skybox::GenCubeMap(const std::vector<std::string>& facePaths)
 
     unsigned int tid;
     glGenTextures(1, &tid);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, tid);
+    GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP, tid);
 
     int width, height, nrChannels;
     stbi_set_flip_vertically_on_load(false);
@@ -136,7 +139,7 @@ unsigned int Skybox::GenCubeMap(const std::vector<std::string>& facePaths)
     }
 
     if (loadError) {
-        glDeleteTextures(1, &tid);
+        GL_STATE.deleteTextures(1, &tid);
         throw std::runtime_error("Failed to load cubemap texture at path: " + errorPath);
     }
 
@@ -167,7 +170,7 @@ unsigned int Skybox::GenCubeMapFromPanorama(const std::string& panoramaPath)
     // ȫͼ
     unsigned int panoramaTexture;
     glGenTextures(1, &panoramaTexture);
-    glBindTexture(GL_TEXTURE_2D, panoramaTexture);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, panoramaTexture);
     GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
     GLenum internalFormat = (nrChannels == 4) ? GL_RGBA16F : GL_RGB16F;
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, image);
@@ -180,7 +183,7 @@ unsigned int Skybox::GenCubeMapFromPanorama(const std::string& panoramaPath)
     // ͼ
     unsigned int cubemapTexture;
     glGenTextures(1, &cubemapTexture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
     int cubemapSize = 2048; // ӷֱ
     for (unsigned int i = 0; i < 6; ++i) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 
@@ -196,7 +199,7 @@ unsigned int Skybox::GenCubeMapFromPanorama(const std::string& panoramaPath)
     unsigned int captureFBO, captureRBO;
     glGenFramebuffers(1, &captureFBO);
     glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, cubemapSize, cubemapSize);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
@@ -221,10 +224,9 @@ unsigned int Skybox::GenCubeMapFromPanorama(const std::string& panoramaPath)
     };
 
     // תȫͼͼ
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, panoramaTexture);
-    glViewport(0, 0, cubemapSize, cubemapSize);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    GL_STATE.bindTexture(0, GL_TEXTURE_2D, panoramaTexture);
+    GL_STATE.viewport(0, 0, cubemapSize, cubemapSize);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     
     for (unsigned int i = 0; i < 6; ++i) {
         equirectangularToCubemapShader.setMat4("view", captureViews[i]);
@@ -235,14 +237,14 @@ unsigned int Skybox::GenCubeMapFromPanorama(const std::string& panoramaPath)
     }
 
     //  mipmap
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    GL_STATE.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     // Դ
-    glDeleteTextures(1, &panoramaTexture);
-    glDeleteFramebuffers(1, &captureFBO);
+    GL_STATE.deleteTextures(1, &panoramaTexture);
+    GL_STATE.deleteFramebuffers(1, &captureFBO);
     glDeleteRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GL_STATE.bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     return cubemapTexture;
 }
@@ -301,14 +303,14 @@ void Skybox::renderCube()
 
         glGenVertexArrays(1, &cubeVAO);
         glGenBuffers(1, &cubeVBO);
-        glBindVertexArray(cubeVAO);
+        GL_STATE.bindVertexArray(cubeVAO);
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     }
 
-    glBindVertexArray(cubeVAO);
+    GL_STATE.bindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    GL_STATE.bindVertexArray(0);
 }
@@ -2,6 +2,7 @@
 #define SKYBOX_H
 
 // Windows ضǰ
+#ifdef _WIN32
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #define RPC_NO_WINDOWS_H
@@ -11,6 +12,7 @@
 // ȡ Windows 궨
 #undef near
 #undef far
+#endif
 
 // OpenGL ͷļ
 #include <glad/glad.h>
@@ -27,7 +29,7 @@
 #include <stdexcept>
 
 // Ŀͷļ
-#include "Shader.h"
+#include "shader.h"
 #include "stb_image.h"
 
 // ǰ
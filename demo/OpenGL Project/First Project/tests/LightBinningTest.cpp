@@ -0,0 +1,127 @@
+// LightBinningTest.cpp
+// 光源分簇的 CPU 单元测试：把分簇结果与逐簇逐光源的暴力相交测试比较
+// 网格的 tile 数故意不是 4 的倍数，覆盖 SIMD 按 4 个一组读取的尾部
+#include "LightBinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float FOV_Y = glm::radians(60.0f);
+    const float ASPECT = 16.0f / 9.0f;
+    const float NEAR_PLANE = 0.1f;
+    const float FAR_PLANE = 100.0f;
+
+    // 视锥内外随机分布的点光源和聚光灯
+    std::vector<LightBinning::LightVolume> makeLights(size_t count, unsigned int seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> depth(-5.0f, FAR_PLANE + 5.0f);
+        std::uniform_real_distribution<float> range(0.5f, 15.0f);
+        std::uniform_real_distribution<float> angle(glm::radians(5.0f), glm::radians(60.0f));
+
+        std::vector<LightBinning::LightVolume> lights(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            LightBinning::LightVolume& light = lights[i];
+            float d = depth(rng);
+            light.position = glm::vec3(unit(rng) * d * 1.2f, unit(rng) * d * 0.7f, -d);
+            light.range = range(rng);
+            light.isSpot = (i % 3) == 0;
+            light.direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, -0.5f));
+            float a = angle(rng);
+            light.cosAngle = std::cos(a);
+            light.sinAngle = std::sin(a);
+            light.lightIndex = static_cast<uint32_t>(i);
+        }
+        return lights;
+    }
+
+    // 返回不一致的簇数
+    int compareWithBruteForce(LightBinning& binning, const std::vector<LightBinning::LightVolume>& lights, const char* label)
+    {
+        binning.bin(lights);
+        const std::vector<glm::uvec2>& clusters = binning.getClusters();
+        const std::vector<uint32_t>& indices = binning.getLightIndices();
+        if (static_cast<int>(clusters.size()) != binning.getClusterCount())
+        {
+            std::cerr << label << ": expected " << binning.getClusterCount() << " clusters, got " << clusters.size() << std::endl;
+            return 1;
+        }
+
+        int mismatches = 0;
+        for (int c = 0; c < binning.getClusterCount(); ++c)
+        {
+            glm::vec3 aabbMin, aabbMax;
+            binning.getClusterBounds(c, aabbMin, aabbMax);
+
+            std::vector<uint32_t> expected;
+            for (const LightBinning::LightVolume& light : lights)
+            {
+                bool hit = light.isSpot ? LightBinning::coneIntersectsAABB(light, aabbMin, aabbMax)
+                    : LightBinning::sphereIntersectsAABB(light.position, light.range, aabbMin, aabbMax);
+                if (hit)
+                    expected.push_back(light.lightIndex);
+            }
+
+            if (clusters[c].x + clusters[c].y > indices.size())
+            {
+                std::cerr << label << ": cluster " << c << " points past the index list" << std::endl;
+                return mismatches + 1;
+            }
+            std::vector<uint32_t> binned(indices.begin() + clusters[c].x, indices.begin() + clusters[c].x + clusters[c].y);
+            std::sort(binned.begin(), binned.end());
+            if (binned != expected)
+            {
+                if (mismatches < 5)
+                {
+                    std::cerr << label << ": cluster " << c << " has " << binned.size()
+                        << " lights, brute force found " << expected.size() << std::endl;
+                }
+                ++mismatches;
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main()
+{
+    int failures = 0;
+
+    // 5x3 个 tile：每个切片 15 个簇，最后一组只有 3 个有效簇
+    LightBinning small;
+    small.configure(5, 3, 4, FOV_Y, ASPECT, NEAR_PLANE, FAR_PLANE);
+    small.setWorkerCount(1);
+    failures += compareWithBruteForce(small, makeLights(40, 1), "5x3x4, 40 lights");
+
+    // 与引擎相同的网格；超过 128 个光源时按切片分给多个线程
+    LightBinning full;
+    full.configure(16, 9, 24, FOV_Y, ASPECT, NEAR_PLANE, FAR_PLANE);
+    full.setWorkerCount(1);
+    failures += compareWithBruteForce(full, makeLights(300, 2), "16x9x24, 1 worker");
+    full.setWorkerCount(4);
+    failures += compareWithBruteForce(full, makeLights(300, 2), "16x9x24, 4 workers");
+
+    // 多线程且切片数不能被线程数整除
+    LightBinning odd;
+    odd.configure(7, 5, 11, FOV_Y, ASPECT, NEAR_PLANE, FAR_PLANE);
+    odd.setWorkerCount(3);
+    failures += compareWithBruteForce(odd, makeLights(200, 3), "7x5x11, 3 workers");
+
+    // 没有光源时每个簇都为空
+    failures += compareWithBruteForce(odd, {}, "7x5x11, no lights");
+
+    if (failures != 0)
+    {
+        std::cerr << "LightBinning test failed: " << failures << " mismatching clusters" << std::endl;
+        return 1;
+    }
+    std::cout << "LightBinning test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+// SoftwareOcclusionTest.cpp
+// 软件遮挡剔除的 CPU 单元测试：光栅化一面遮挡墙，再查询墙后、墙旁、墙前和跨过近平面的包围盒
+// 墙分别用 2 个三角形（单线程）和 512 个三角形（多线程分 tile）提交，查询结果应一致
+#include "SoftwareOcclusion.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // z = -5 处 4x4 的墙，每边细分为 cells 格
+    void addWall(SoftwareOcclusion& occlusion, int cells)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        for (int y = 0; y <= cells; ++y)
+        {
+            for (int x = 0; x <= cells; ++x)
+                positions.push_back(glm::vec3(-2.0f + 4.0f * x / cells, -2.0f + 4.0f * y / cells, -5.0f));
+        }
+        for (int y = 0; y < cells; ++y)
+        {
+            for (int x = 0; x < cells; ++x)
+            {
+                unsigned int i = static_cast<unsigned int>(y * (cells + 1) + x);
+                unsigned int row = static_cast<unsigned int>(cells + 1);
+                indices.insert(indices.end(), { i, i + 1, i + row + 1, i, i + row + 1, i + row });
+            }
+        }
+        occlusion.addOccluder(glm::mat4(1.0f), positions.data(), sizeof(glm::vec3), positions.size(),
+            indices.data(), indices.size());
+    }
+
+    struct Query
+    {
+        const char* name;
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        bool expectVisible;
+    };
+
+    // 相机在原点朝 -Z 看；墙在 z = -5 处的 [-2, 2]，投影到 z = -10 处为 [-4, 4]
+    const Query QUERIES[] = {
+        { "box behind the wall", glm::vec3(-0.5f, -0.5f, -10.5f), glm::vec3(0.5f, 0.5f, -9.5f), false },
+        { "large box behind the wall", glm::vec3(-3.0f, -3.0f, -12.0f), glm::vec3(3.0f, 3.0f, -11.0f), false },
+        { "box beside the wall", glm::vec3(6.0f, -0.5f, -10.5f), glm::vec3(7.0f, 0.5f, -9.5f), true },
+        { "box across the wall edge", glm::vec3(3.5f, -0.5f, -10.5f), glm::vec3(4.5f, 0.5f, -9.5f), true },
+        { "box in front of the wall", glm::vec3(-0.5f, -0.5f, -3.5f), glm::vec3(0.5f, 0.5f, -2.5f), true },
+        { "box across the near plane", glm::vec3(-0.5f, -0.5f, -1.0f), glm::vec3(0.5f, 0.5f, 1.0f), true },
+    };
+
+    int runQueries(SoftwareOcclusion& occlusion, const char* label)
+    {
+        int failures = 0;
+        size_t expectedCulled = 0;
+        for (const Query& query : QUERIES)
+        {
+            bool visible = occlusion.isVisible(query.boxMin, query.boxMax);
+            if (!query.expectVisible)
+                ++expectedCulled;
+            if (visible != query.expectVisible)
+            {
+                std::cerr << label << ": " << query.name << " should be " << (query.expectVisible ? "visible" : "occluded") << std::endl;
+                ++failures;
+            }
+        }
+        if (occlusion.getStats().culled != expectedCulled)
+        {
+            std::cerr << label << ": stats report " << occlusion.getStats().culled << " culled boxes, expected " << expectedCulled << std::endl;
+            ++failures;
+        }
+        return failures;
+    }
+}
+
+int main()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int failures = 0;
+
+    SoftwareOcclusion occlusion(256, 128);
+
+    // 没有遮挡体时所有包围盒都可见
+    occlusion.beginFrame(projection * view);
+    occlusion.rasterize();
+    for (const Query& query : QUERIES)
+    {
+        if (!occlusion.isVisible(query.boxMin, query.boxMax))
+        {
+            std::cerr << "empty buffer: " << query.name << " should be visible" << std::endl;
+            ++failures;
+        }
+    }
+
+    occlusion.setWorkerCount(1);
+    occlusion.beginFrame(projection * view);
+    addWall(occlusion, 1);
+    occlusion.rasterize();
+    failures += runQueries(occlusion, "2 triangles, 1 worker");
+
+    occlusion.setWorkerCount(4);
+    occlusion.beginFrame(projection * view);
+    addWall(occlusion, 16);
+    occlusion.rasterize();
+    failures += runQueries(occlusion, "512 triangles, 4 workers");
+
+    if (failures != 0)
+    {
+        std::cerr << "SoftwareOcclusion test failed: " << failures << " wrong results" << std::endl;
+        return 1;
+    }
+    std::cout << "SoftwareOcclusion test passed" << std::endl;
+    return 0;
+}